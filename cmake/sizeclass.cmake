@@ -0,0 +1,177 @@
+# This file is part of the *ramalloc* project at <http://fmrl.org>.
+# Copyright (c) 2011, Michael Lowell Roberts.
+# All rights reserved. 
+#
+# Redistribution and use in source and binary forms, with or without 
+# modification, are permitted provided that the following conditions are 
+# met: 
+#
+#  * Redistributions of source code must retain the above copyright 
+#  notice, this list of conditions and the following disclaimer. 
+#
+#  * Redistributions in binary form must reproduce the above copyright 
+#  notice, this list of conditions and the following disclaimer in the 
+#  documentation and/or other materials provided with the distribution.
+# 
+#  * Neither the name of the copyright holder nor the names of 
+#  contributors may be used to endorse or promote products derived 
+#  from this software without specific prior written permission. 
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+# IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+# TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+# PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+# OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+# SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+# TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. 
+
+# set_right_aligned
+# -----------------
+# pads VALUE with spaces on the left until it's WIDTH characters wide and
+# stores the result in the variable named by RESULT.
+function(set_right_aligned RESULT VALUE WIDTH)
+	string(LENGTH "${VALUE}" LENGTH)
+	while(LENGTH LESS WIDTH)
+		set(VALUE " ${VALUE}")
+		math(EXPR LENGTH "${LENGTH} + 1")
+	endwhile()
+	set(${RESULT} "${VALUE}" PARENT_SCOPE)
+endfunction()
+
+# generate_size_classes
+# ---------------------
+# generates the size class table that mux pools use to map a request onto
+# an aligned pool. the smallest classes are spaced STEP bytes apart (the
+# size of a pointer). once the spacing would become less than 1/DIVISIONS of
+# a class, the classes become geometric: each doubling is divided into
+# DIVISIONS equally spaced classes, up to and including MAXIMUM. the worst
+# case internal fragmentation of a geometric class is therefore
+# 1/(DIVISIONS+1) of the class.
+#
+# TEMPLATE is configured into OUTPUT with the following variables:
+#
+#	RAMALLOC_SIZECLASS_COUNT	the number of classes.
+#	RAMALLOC_SIZECLASS_SIZES	an initializer for the class sizes.
+#	RAMALLOC_SIZECLASS_LOOKUP	an initializer for an array that maps
+#					(size + STEP - 1) / STEP onto the
+#					smallest class that can hold size.
+#	RAMALLOC_SIZECLASS_REPORT	the fragmentation report, as a C
+#					comment.
+function(generate_size_classes TEMPLATE OUTPUT STEP DIVISIONS MAXIMUM)
+	math(EXPR DIVISIONS_MASK "${DIVISIONS} & (${DIVISIONS} - 1)")
+	if(DIVISIONS LESS 1 OR DIVISIONS GREATER 16 OR DIVISIONS_MASK)
+		message(FATAL_ERROR
+			"i need the number of size classes per doubling to be a power of two from 1 to 16 (not ${DIVISIONS}).")
+	endif()
+	math(EXPR LINEAR_LIMIT "${STEP} * ${DIVISIONS}")
+	math(EXPR MAXIMUM_MASK "${MAXIMUM} & (${MAXIMUM} - 1)")
+	if(MAXIMUM LESS LINEAR_LIMIT OR MAXIMUM_MASK)
+		message(FATAL_ERROR
+			"i need the maximum size class to be a power of two no smaller than ${LINEAR_LIMIT} (not ${MAXIMUM}).")
+	endif()
+
+	# first, the linear classes...
+	set(CLASSES)
+	set(SIZE ${STEP})
+	while(NOT SIZE GREATER LINEAR_LIMIT)
+		list(APPEND CLASSES ${SIZE})
+		math(EXPR SIZE "${SIZE} + ${STEP}")
+	endwhile()
+	# ...followed by the geometric classes.
+	set(BASE ${LINEAR_LIMIT})
+	while(BASE LESS MAXIMUM)
+		math(EXPR SPACING "${BASE} / ${DIVISIONS}")
+		foreach(I RANGE 1 ${DIVISIONS})
+			math(EXPR SIZE "${BASE} + ${I} * ${SPACING}")
+			list(APPEND CLASSES ${SIZE})
+		endforeach()
+		math(EXPR BASE "${BASE} * 2")
+	endwhile()
+	list(LENGTH CLASSES COUNT)
+	# each class needs a partition of its own when partitioning is enabled
+	# (see RAMVAS_PARTITIONCOUNT).
+	if(COUNT GREATER 128)
+		message(FATAL_ERROR
+			"i can't accomodate ${COUNT} size classes; there can be at most 128.")
+	endif()
+
+	# the class sizes and the fragmentation report.
+	set(SIZES)
+	set(REPORT "/*")
+	foreach(FIELD class size smallest worst mean)
+		set_right_aligned(FIELD "${FIELD}" 9)
+		set(REPORT "${REPORT}${FIELD}")
+	endforeach()
+	set(REPORT "${REPORT}\n")
+	set(PREVIOUS 0)
+	set(INDEX 0)
+	foreach(SIZE ${CLASSES})
+		if(INDEX)
+			set(SIZES "${SIZES},")
+		endif()
+		math(EXPR BREAK "${INDEX} % 8")
+		if(NOT BREAK)
+			set(SIZES "${SIZES} \\\n  ")
+		endif()
+		set(SIZES "${SIZES} ${SIZE}")
+		# i report fragmentation in tenths of a percent. the worst case
+		# is a request one byte larger than the previous class; the mean
+		# assumes every size that falls into the class is equally likely.
+		math(EXPR SMALLEST "${PREVIOUS} + 1")
+		math(EXPR WORST "(${SIZE} - ${SMALLEST}) * 1000 / ${SIZE}")
+		math(EXPR MEAN "(${SIZE} - ${SMALLEST}) * 500 / ${SIZE}")
+		math(EXPR WORST_WHOLE "${WORST} / 10")
+		math(EXPR WORST_TENTHS "${WORST} % 10")
+		math(EXPR MEAN_WHOLE "${MEAN} / 10")
+		math(EXPR MEAN_TENTHS "${MEAN} % 10")
+		set(LINE)
+		foreach(FIELD ${INDEX} ${SIZE} ${SMALLEST}
+				"${WORST_WHOLE}.${WORST_TENTHS}%"
+				"${MEAN_WHOLE}.${MEAN_TENTHS}%")
+			set_right_aligned(FIELD "${FIELD}" 9)
+			set(LINE "${LINE}${FIELD}")
+		endforeach()
+		set(REPORT "${REPORT} *${LINE}\n")
+		set(PREVIOUS ${SIZE})
+		math(EXPR INDEX "${INDEX} + 1")
+	endforeach()
+	set(REPORT "${REPORT} */")
+
+	# the lookup table maps every multiple of STEP up to MAXIMUM onto a
+	# class. index 0 is never used, since zero-sized requests are refused.
+	set(LOOKUP)
+	set(CLASS 0)
+	list(GET CLASSES 0 CLASS_SIZE)
+	math(EXPR LAST "${MAXIMUM} / ${STEP}")
+	foreach(I RANGE 0 ${LAST})
+		math(EXPR SIZE "${I} * ${STEP}")
+		if(SIZE GREATER CLASS_SIZE)
+			math(EXPR CLASS "${CLASS} + 1")
+			list(GET CLASSES ${CLASS} CLASS_SIZE)
+		endif()
+		if(I)
+			set(LOOKUP "${LOOKUP},")
+		endif()
+		math(EXPR BREAK "${I} % 16")
+		if(NOT BREAK)
+			set(LOOKUP "${LOOKUP} \\\n  ")
+		endif()
+		set(LOOKUP "${LOOKUP} ${CLASS}")
+	endforeach()
+
+	set(RAMALLOC_SIZECLASS_STEP ${STEP})
+	set(RAMALLOC_SIZECLASS_DIVISIONS ${DIVISIONS})
+	set(RAMALLOC_SIZECLASS_MAXIMUM ${MAXIMUM})
+	set(RAMALLOC_SIZECLASS_COUNT ${COUNT})
+	set(RAMALLOC_SIZECLASS_SIZES "${SIZES}")
+	set(RAMALLOC_SIZECLASS_LOOKUP "${LOOKUP}")
+	set(RAMALLOC_SIZECLASS_REPORT "${REPORT}")
+	configure_file(${TEMPLATE} ${OUTPUT} @ONLY)
+	if(WANT_FEEDBACK)
+		message(STATUS "size classes (${COUNT}):\n${REPORT}")
+	endif()
+endfunction()
@@ -46,17 +46,39 @@ typedef struct ramalgn_pool
 {
    rampg_pool_t ramalgnp_pgpool;
    ramslot_pool_t ramalgnp_slotpool;
+   /* the nodes that describe the pages in the slot pool. */
+   ramslot_pool_t ramalgnp_nodepool;
    ramalgn_tag_t ramalgnp_tag;
 } ramalgn_pool_t;
 
 ram_reply_t ramalgn_initialize();
 ram_reply_t ramalgn_mkpool(ramalgn_pool_t *pool_arg, rampg_appetite_t appetite_arg, 
    size_t granularity_arg, const ramalgn_tag_t *tag_arg);
+/* replies RAM_REPLY_DISALLOWED if any of the pool's objects are still in
+ * use, in which case the pool is left as it was. */
+ram_reply_t ramalgn_rmpool(ramalgn_pool_t *pool_arg);
+ram_reply_t ramalgn_isempty(int *emptyflag_arg, const ramalgn_pool_t *pool_arg);
 ram_reply_t ramalgn_acquire(void **newptr_arg, ramalgn_pool_t *pool_arg);
 ram_reply_t ramalgn_release(void *ptr_arg);
+ram_reply_t ramalgn_gettoken(void **token_arg, void *ptr_arg);
+#define ramalgn_defer ramslot_defer
+#define ramalgn_merge ramslot_merge
+ram_reply_t ramalgn_reserve(ramalgn_pool_t *pool_arg, size_t count_arg);
+ram_reply_t ramalgn_confine(ramalgn_pool_t *pool_arg, size_t partition_arg);
 ram_reply_t ramalgn_chkpool(const ramalgn_pool_t *pool_arg);
 ram_reply_t ramalgn_query(ramalgn_pool_t **apool_arg, void *ptr_arg);
+ram_reply_t ramalgn_querytoken(ramalgn_pool_t **apool_arg, void *token_arg);
 ram_reply_t ramalgn_gettag(const ramalgn_tag_t **tag_arg, const ramalgn_pool_t *apool_arg);
 ram_reply_t ramalgn_getgranularity(size_t *granularity_arg, const ramalgn_pool_t *apool_arg);
+/* reports how many pages make up each of the pool's slabs and how many
+ * objects each slab holds. */
+ram_reply_t ramalgn_getslabsize(size_t *pages_arg, size_t *capacity_arg,
+   const ramalgn_pool_t *apool_arg);
+/* chooses the number of pages in each slab of a pool whose objects are
+ * *granularity_arg* bytes large, given that a reservation holds
+ * *reservation_arg* pages, and reports how many objects such a slab holds.
+ * replies RAM_REPLY_RANGEFAIL if no slab suits the granularity. */
+ram_reply_t ramalgn_calcslab(size_t *pages_arg, size_t *capacity_arg,
+   size_t granularity_arg, size_t reservation_arg);
 
 #endif /* RAMALGN_H_IS_INCLUDED */
@@ -0,0 +1,85 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#ifndef RAMBIG_H_IS_INCLUDED
+#define RAMBIG_H_IS_INCLUDED
+
+#include <ramalloc/fail.h>
+#include <ramalloc/want.h>
+
+/* the large object tier gives each object too large for the largest size
+ * class a page-aligned mapping of its own. recently discarded mappings are
+ * held in a small cache for each thread and a larger one shared by every
+ * thread (both are measured in bytes; see RAM_WANT_LARGETHREADCACHEBYTES
+ * and RAM_WANT_LARGECACHEBYTES), so that a workload that repeatedly
+ * acquires and discards large buffers doesn't pay for a pair of system
+ * calls every time. the mappings are found through an ownership map, so
+ * a query about memory that belongs to another allocator costs about as
+ * much as it does for small objects. */
+
+typedef struct rambig_stats
+{
+   /* the number of large objects currently in use. */
+   size_t rambigs_live;
+   /* the number of bytes held by the shared cache. */
+   size_t rambigs_cached;
+   /* the number of bytes held by the calling thread's cache. */
+   size_t rambigs_threadcached;
+   /* acquisitions satisfied by either cache. */
+   size_t rambigs_hits;
+   /* acquisitions that had to be satisfied by the system. */
+   size_t rambigs_misses;
+   /* resizes that were satisfied by remapping rather than copying. */
+   size_t rambigs_remaps;
+   /* mappings returned to the system. */
+   size_t rambigs_unmaps;
+} rambig_stats_t;
+
+ram_reply_t rambig_initialize();
+/* the size is rounded up to a whole number of pages. RAM_REPLY_RANGEFAIL
+ * is returned if that isn't possible. */
+ram_reply_t rambig_acquire(void **newptr_arg, size_t size_arg);
+/* RAM_REPLY_NOTFOUND is returned if *ptr_arg* wasn't acquired with
+ * rambig_acquire(), so that the caller can try another allocator. */
+ram_reply_t rambig_release(void *ptr_arg);
+/* *newptr_arg* may or may not be equal to *ptr_arg*; the contents are
+ * preserved up to the smaller of the two sizes. on failure, *ptr_arg* is
+ * left intact. */
+ram_reply_t rambig_resize(void **newptr_arg, void *ptr_arg, size_t size_arg);
+ram_reply_t rambig_query(size_t *size_arg, void *ptr_arg);
+/* returns the calling thread's cache and the shared cache to the
+ * system. */
+ram_reply_t rambig_flush();
+ram_reply_t rambig_getstats(rambig_stats_t *stats_arg);
+
+#endif /* RAMBIG_H_IS_INCLUDED */
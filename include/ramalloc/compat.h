@@ -38,6 +38,7 @@
 
 void * ramcompat_malloc(size_t size_arg);
 void ramcompat_free(void *ptr_arg);
+void * ramcompat_realloc(void *ptr_arg, size_t size_arg);
 void * ramcompat_calloc(size_t count_arg, size_t size_arg);
 
 #endif /* RAMCOMPAT_H_IS_INCLUDED */
\ No newline at end of file
@@ -0,0 +1,86 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#ifndef RAMCPU_H_IS_INCLUDED
+#define RAMCPU_H_IS_INCLUDED
+
+#include <ramalloc/fail.h>
+#include <ramalloc/lazy.h>
+#include <ramalloc/mtx.h>
+
+/* a per-cpu pool is an alternative to a parallel pool for applications
+ * with many more threads than processors. instead of a lazy pool for each
+ * thread, it keeps one for each processor, so its footprint grows with the
+ * number of cores rather than the number of threads. a thread uses the
+ * heap belonging to the processor it's running on. since it can be
+ * preempted or migrated at any time, each heap is guarded by a mutex; if
+ * the heap is busy, the thread tries its neighbors before waiting. */
+
+/* the heaps sit side by side in an array, and each is written to by a
+ * different processor. they're aligned to and padded out to this many
+ * bytes so that no two of them share a cache line. */
+#define RAMCPU_CACHELINE 64
+#define RAMCPU_HEAPBYTES \
+   (sizeof(ramlazy_pool_t) + sizeof(rammtx_mutex_t) + sizeof(void *))
+
+struct ramcpu_pool;
+
+typedef struct ramcpu_heap
+{
+   ramlazy_pool_t ramcpuh_lazypool;
+   rammtx_mutex_t ramcpuh_mutex;
+   struct ramcpu_pool *ramcpuh_backref;
+   char ramcpuh_padding[RAMCPU_CACHELINE - RAMCPU_HEAPBYTES % RAMCPU_CACHELINE];
+} ramcpu_heap_t;
+
+typedef struct ramcpu_pool
+{
+   ramcpu_heap_t *ramcpup_heaps;
+   size_t ramcpup_count;
+   /* the block the heaps were carved out of, which is what gets freed. */
+   void *ramcpup_block;
+} ramcpu_pool_t;
+
+/* if *count_arg* is 0, there's one heap for each processor. */
+ram_reply_t ramcpu_mkpool(ramcpu_pool_t *cpupool_arg, size_t count_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg);
+/* replies RAM_REPLY_DISALLOWED if any of the pool's objects are still in
+ * use, in which case the pool is left as it was. */
+ram_reply_t ramcpu_rmpool(ramcpu_pool_t *cpupool_arg);
+ram_reply_t ramcpu_acquire(void **newptr_arg, ramcpu_pool_t *cpupool_arg, size_t size_arg);
+ram_reply_t ramcpu_release(void *ptr_arg);
+ram_reply_t ramcpu_reclaim(size_t *count_arg, ramcpu_pool_t *cpupool_arg, size_t goal_arg);
+ram_reply_t ramcpu_flush(ramcpu_pool_t *cpupool_arg);
+ram_reply_t ramcpu_query(ramcpu_pool_t **cpupool_arg, size_t *size_arg, void *ptr_arg);
+ram_reply_t ramcpu_chkpool(const ramcpu_pool_t *cpupool_arg);
+
+#endif /* RAMCPU_H_IS_INCLUDED */
@@ -37,7 +37,9 @@
  * @file
  * @brief the default allocator
  * @details the default module simply provides access to a global
- *    parallelized pool.
+ *    parallelized pool. objects too large for the pool's largest size
+ *    class are given page-aligned mappings of their own (see big.h), and
+ *    objects smaller than a word are packed into cells (see tiny.h).
  * @todo
  *    the default allocator needs to be able to be parameterized through
  *    runtime options, presumably passed through ram_default_initialize().
@@ -47,6 +49,7 @@
 #define RAMALLOC_DEFAULT_H_IS_INCLUDED
 
 #include <ramalloc/fail.h>
+#include <ramalloc/stdint.h>
 
 /**
  * @internal
@@ -67,7 +70,10 @@ ram_reply_t ram_default_initialize();
 /**
  * @brief acquire a quantity of memory.
  * @details ram_default_acquire() acquires a quantity of memory from the
- *    default pool.
+ *    default pool. quantities larger than the largest size class are
+ *    mapped directly, on a page boundary. quantities of
+ *    @c RAMTINY_MAXCELLSIZE bytes or less are packed into cells, unless
+ *    @c RAM_WANT_TINYCELLS is 0.
  * @param newptr_arg
  *    the address of a pointer that will reference the newly  allocated
  *    memory. this address cannot be @c NULL.
@@ -80,7 +86,9 @@ ram_reply_t ram_default_initialize();
  * @return @c RAM_REPLY_RANGEFAIL - the pool cannot accommodate the specific
  *    size requested.
  * @par performance
- *    this function completes in amortized constant time.
+ *    this function completes in amortized constant time. a large object
+ *    that can't be satisfied from a cache of recently discarded mappings
+ *    costs a system call.
  * @remark this function performs the @e acquire operation and the
  *    @e reclaim operation with the default reclamation goal.
  * @remark this function returns a @e reply as described in reply.h.
@@ -117,6 +125,114 @@ ram_reply_t ram_default_acquire(void **newptr_arg, size_t size_arg);
  */
 ram_reply_t ram_default_discard(void *ptr_arg);
 
+/**
+ * @brief change the size of an allocation.
+ * @details ram_default_resize() changes the size of memory acquired with
+ *    ram_default_acquire(), preserving its contents up to the lesser of
+ *    the old and new sizes. the object may move; if it does, the old
+ *    address is discarded. large objects are grown or shrunk by remapping
+ *    their pages where the system supports it, so their contents aren't
+ *    copied.
+ * @param newptr_arg
+ *    the address of a pointer that will reference the resized memory.
+ *    this address cannot be @c NULL.
+ * @param ptr_arg
+ *    the address of the memory to resize. this address cannot be @c NULL.
+ * @param size_arg
+ *    the minimum quantity of memory, in bytes, that is desired. this
+ *    quantity cannot be 0.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @return @c RAM_REPLY_NOTFOUND - the memory described by @e ptr_arg was
+ *    not acquired from the default allocator.
+ * @return @c RAM_REPLY_RANGEFAIL - the pool cannot accommodate the specific
+ *    size requested. @e ptr_arg is left intact.
+ * @par performance
+ *    this function completes in time proportional to the size of the
+ *    object if it has to be copied, and in amortized constant time
+ *    otherwise.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_resize(void **newptr_arg, void *ptr_arg,
+      size_t size_arg);
+
+/**
+ * @brief describes a reservation.
+ * @details a ram_default_reservation_t describes how many objects of a
+ *    given size should be held in reserve. an array of these forms the
+ *    @e profile passed to ram_default_prewarm().
+ * @see ram_default_reserve
+ */
+typedef struct ram_default_reservation
+{
+   /** @brief the size, in bytes, of the objects to be reserved. */
+   size_t ramdr_size;
+   /** @brief the number of objects to be reserved. */
+   size_t ramdr_count;
+} ram_default_reservation_t;
+
+/**
+ * @brief hold memory in reserve for future acquisitions.
+ * @details ram_default_reserve() ensures that the calling thread's
+ *    allocator can satisfy at least @e count_arg acquisitions of
+ *    @e size_arg bytes without requesting memory from the host. the
+ *    memory is committed and touched before ram_default_reserve()
+ *    returns, so acquiring it will not cause a page fault.
+ * @param size_arg
+ *    the size, in bytes, of the objects to be reserved. this quantity
+ *    cannot be 0.
+ * @param count_arg
+ *    the number of objects to reserve. the reservation persists as a
+ *    floor; memory discarded and reclaimed on the calling thread is held
+ *    in reserve until the floor is met again. passing 0 removes a previous
+ *    reservation.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @return @c RAM_REPLY_RANGEFAIL - the pool cannot accommodate the specific
+ *    size requested.
+ * @par performance
+ *    this function completes in linear time, bounded by the number of pages
+ *    needed to satisfy the reservation.
+ * @remark reservations are made per thread and are rounded up to a whole
+ *    number of pages.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_reserve(size_t size_arg, size_t count_arg);
+
+/**
+ * @brief hold memory in reserve for several sizes at once.
+ * @details ram_default_prewarm() calls ram_default_reserve() for each
+ *    element of @e profile_arg. it is intended to be called once when a
+ *    thread starts, so that latency-sensitive code running on the thread
+ *    later does not pay for the allocator's first touch of memory.
+ * @param profile_arg
+ *    an array of reservations. this address cannot be @c NULL.
+ * @param count_arg
+ *    the number of elements in @e profile_arg.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @return @c RAM_REPLY_RANGEFAIL - the pool cannot accommodate one of the
+ *    sizes in the profile. reservations preceding it will have been made.
+ * @par performance
+ *    this function completes in linear time, bounded by the number of pages
+ *    needed to satisfy the profile.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_prewarm(const ram_default_reservation_t *profile_arg,
+      size_t count_arg);
+
 /**
  * @brief reclaim discarded memory.
  * @details ram_default_reclaim() pulls a specified number of discarded
@@ -149,10 +265,59 @@ ram_reply_t ram_default_discard(void *ptr_arg);
  */
 ram_reply_t ram_default_reclaim(size_t *count_arg, size_t goal_arg);
 
+/**
+ * @brief describes the outcome of a time-bounded reclamation.
+ * @details a ram_default_reclaimstats_t is filled in by
+ *    ram_default_reclaimfor().
+ * @see ram_default_reclaimfor
+ */
+typedef struct ram_default_reclaimstats
+{
+   /** @brief the number of discarded objects that were reclaimed. */
+   size_t ramdrs_objects;
+   /** @brief the number of pages that reclamation left empty. */
+   size_t ramdrs_pages;
+   /** @brief the number of retained reservations returned to the host. */
+   size_t ramdrs_reservations;
+   /** @brief the time spent, in nanoseconds. */
+   uint64_t ramdrs_elapsed;
+   /** @brief nonzero if there was nothing left to do when the operation
+    *    stopped. */
+   int ramdrs_complete;
+} ram_default_reclaimstats_t;
+
+/**
+ * @brief reclaim discarded memory within a time budget.
+ * @details ram_default_reclaimfor() empties the current thread's @e trash
+ *    and then returns retained reservations to the host, stopping when
+ *    there is nothing left to do or when the time budget has been spent.
+ *    it's intended to be called once per iteration of a frame loop (or
+ *    similar) with whatever time remains in the frame.
+ * @param stats_arg
+ *    the address of a variable where a description of the work performed
+ *    should be deposited. this address cannot be @c NULL.
+ * @param budget_arg
+ *    the time budget, in nanoseconds.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @par performance
+ *    the clock is consulted once for every batch of objects or
+ *    reservations, so the operation may overrun its budget by the cost of
+ *    a single batch.
+ * @remark this function performs the @e reclaim operation.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_reclaimfor(ram_default_reclaimstats_t *stats_arg,
+      uint64_t budget_arg);
+
 /**
  * @brief reclaim discarded memory.
  * @details ram_default_flush() reclaims all pointers known to be discarded
- *    on the current thread.
+ *    on the current thread. it also returns every cached large object
+ *    mapping (the current thread's and the shared ones) to the system,
+ *    along with any of the current thread's cell pages that are empty.
  * @return @c RAM_REPLY_OK - the operation was successful.
  * @par performance
  *    this function completes in linear time, bounded by number of pointers
@@ -168,6 +333,231 @@ ram_reply_t ram_default_reclaim(size_t *count_arg, size_t goal_arg);
  */
 ram_reply_t ram_default_flush();
 
+/**
+ * @brief let other threads reclaim on the current thread's behalf.
+ * @details ram_default_handoff() hands the current thread's pool off until
+ *    the thread next calls into the allocator. in the meantime, threads
+ *    that discard memory belonging to the current thread reclaim its
+ *    @e trash for it once enough has piled up. a thread that's about to
+ *    block for a long time, such as on I/O, can call this so that the
+ *    memory other threads free on its behalf isn't stranded while it
+ *    waits.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @par performance
+ *    this function sends anything the current thread is holding for other
+ *    threads and otherwise completes in constant time. the next call into
+ *    the allocator on the current thread may have to wait for another
+ *    thread to finish reclaiming a single batch.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_handoff();
+
+/**
+ * @brief notification function signature.
+ * @details a ram_default_notify_t is called with the @e ramdn_context
+ *    member of the notifier that it belongs to.
+ * @see ram_default_notifier_t
+ */
+typedef ram_reply_t (*ram_default_notify_t)(void *context_arg);
+
+/**
+ * @brief describes when and how to notify a thread that its trash needs
+ *    servicing.
+ * @see ram_default_notify
+ */
+typedef struct ram_default_notifier
+{
+   /** @brief the number of pages awaiting reclamation that triggers a
+    *    notification. */
+   size_t ramdn_depth;
+   /** @brief the function to call. */
+   ram_default_notify_t ramdn_func;
+   /** @brief the argument to pass to @e ramdn_func. */
+   void *ramdn_context;
+} ram_default_notifier_t;
+
+/**
+ * @brief ask to be told when the current thread's trash needs servicing.
+ * @details ram_default_notify() registers a notifier for the current
+ *    thread. whenever other threads discard enough memory belonging to the
+ *    current thread that its @e trash climbs to the notifier's depth, the
+ *    notifier's function is called. an event loop can use this to reclaim
+ *    only when there is work to do; on Linux, for example, the function
+ *    might write to an @c eventfd that the loop polls.
+ * @param notifier_arg
+ *    the address of the notifier to use, or @c NULL to stop notifications.
+ *    the notifier's depth cannot be 0 and its function cannot be @c NULL.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @par performance
+ *    this function completes in constant time.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ * @warning the notifier is copied, but its context isn't; the context
+ *    must remain valid for as long as other threads might discard memory
+ *    belonging to the current thread.
+ * @warning the notifier's function is called on the thread that discarded
+ *    the memory, from within the allocator. it must not call back into
+ *    the allocator.
+ * @warning a notification is only delivered when the depth is first
+ *    reached. the thread should service its trash until it's empty, such
+ *    as with ram_default_flush() or ram_default_reclaimfor(), or it may
+ *    not be notified again.
+ */
+ram_reply_t ram_default_notify(const ram_default_notifier_t *notifier_arg);
+
+/**
+ * @brief a heap that isn't tied to a thread.
+ * @details a ram_default_heap_t is a handle to a heap belonging to the
+ *    default allocator that's passed to the allocator explicitly instead of
+ *    being found through thread-local storage. it's intended for fibers and
+ *    coroutines that migrate between threads: each fiber can have a heap
+ *    of its own, used by whichever thread is running the fiber.
+ * @see ram_default_mkheap
+ */
+typedef struct rampara_tls ram_default_heap_t;
+
+/**
+ * @brief create a heap.
+ * @details ram_default_mkheap() creates a heap belonging to the default
+ *    allocator. a heap that was previously removed, or one left behind by
+ *    a thread that exited, may be reused.
+ * @param heap_arg
+ *    the address of a pointer that will reference the new heap. this
+ *    address cannot be @c NULL.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @return @c RAM_REPLY_RESOURCEFAIL (unanticipated) - there wasn't enough
+ *    memory to create the heap.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ * @warning a heap mustn't be used by more than one thread at a time. it
+ *    can be handed from one thread to another, as long as the hand-off
+ *    itself is synchronized (e.g. by a scheduler's run queue).
+ */
+ram_reply_t ram_default_mkheap(ram_default_heap_t **heap_arg);
+
+/**
+ * @brief remove a heap.
+ * @details ram_default_rmheap() gives up a heap created with
+ *    ram_default_mkheap(). memory acquired from the heap remains valid and
+ *    can still be discarded with ram_default_discard(); the heap is
+ *    treated like the heap of a thread that has exited.
+ * @param heap_arg
+ *    the heap to remove. this address cannot be @c NULL.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ * @warning the heap mustn't be used after it's been removed.
+ */
+ram_reply_t ram_default_rmheap(ram_default_heap_t *heap_arg);
+
+/**
+ * @brief acquire a quantity of memory from a heap.
+ * @details ram_default_heapacquire() behaves like ram_default_acquire(),
+ *    except that the memory comes from the heap given instead of the
+ *    current thread's. objects too large for any size class don't belong
+ *    to a heap; they're mapped as ram_default_acquire() would map them.
+ *    objects of @c RAMTINY_MAXCELLSIZE bytes or less aren't packed into
+ *    tiny cells, though, since cells belong to threads rather than to
+ *    heaps; they come from the heap's smallest size class instead.
+ * @param newptr_arg
+ *    the address of a pointer that will reference the newly allocated
+ *    memory. this address cannot be @c NULL.
+ * @param heap_arg
+ *    the heap to acquire memory from. this address cannot be @c NULL.
+ * @param size_arg
+ *    the minimum quantity of memory, in bytes, that is desired. this
+ *    quantity cannot be 0.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @return @c RAM_REPLY_RANGEFAIL - the pool cannot accommodate the specific
+ *    size requested.
+ * @par performance
+ *    this function completes in amortized constant time.
+ * @remark this function performs the @e acquire operation and the
+ *    @e reclaim operation with the default reclamation goal.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_heapacquire(void **newptr_arg,
+      ram_default_heap_t *heap_arg, size_t size_arg);
+
+/**
+ * @brief discard memory on behalf of a heap.
+ * @details ram_default_heapdiscard() behaves like ram_default_discard(),
+ *    except that the heap given plays the part of the current thread's. if
+ *    the memory came from that heap, it's released immediately; otherwise,
+ *    it's sent back to the heap it came from. large objects don't belong
+ *    to a heap and are given back to the system as ram_default_discard()
+ *    would give them back; the same goes for objects that
+ *    ram_default_acquire() packed into tiny cells.
+ * @param heap_arg
+ *    the heap on whose behalf the memory is discarded. this address cannot
+ *    be @c NULL.
+ * @param ptr_arg
+ *    the address of the pointer that is no longer in use. this address
+ *    cannot be NULL.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @return @c RAM_REPLY_NOTFOUND (unanticipated) - the memory described
+ *    by @e ptr_arg was not acquired from the default allocator.
+ * @par performance
+ *    this function completes in constant time.
+ * @remark this function performs the @e discard operation.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_heapdiscard(ram_default_heap_t *heap_arg,
+      void *ptr_arg);
+
+/**
+ * @brief reclaim discarded memory into a heap.
+ * @details ram_default_heapreclaim() behaves like ram_default_reclaim(),
+ *    except that it reclaims memory that other threads (or other heaps)
+ *    discarded on behalf of the heap given.
+ * @param count_arg
+ *    the address of a variable where the number of pointers successfully
+ *    reclaimed should be deposited. this address cannot be @c NULL.
+ * @param heap_arg
+ *    the heap to reclaim memory into. this address cannot be @c NULL.
+ * @param goal_arg
+ *    the number of pointers to reclaim before stopping. this value cannot
+ *    be 0.
+ * @return @c RAM_REPLY_OK - the operation was successful.
+ * @return @c RAM_REPLY_DISALLOWED (unanticipated) - an argument contained
+ *    a disallowed value.
+ * @par performance
+ *    this function completes in linear time, bounded by the value of
+ *    @e goal_arg.
+ * @remark this function performs the @e reclaim operation.
+ * @remark this function returns a @e reply as described in reply.h.
+ *    replies not yet documented here may also be passed up through the
+ *    callstack. use a reply wrapper from fail.h to trap unexpected
+ *    replies.
+ */
+ram_reply_t ram_default_heapreclaim(size_t *count_arg,
+      ram_default_heap_t *heap_arg, size_t goal_arg);
+
 /**
  * @brief inquire about an allocation.
  * @details ram_default_query() reports whether an address was allocated
@@ -63,6 +63,15 @@ typedef rammem_malloc_t ram_malloc_t;
  */
 typedef rammem_free_t ram_free_t;
 
+/**
+ * @brief describes a reservation (façade).
+ * @see ram_default_reservation_t
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+typedef ram_default_reservation_t ram_reservation_t;
+
 /**
  * @brief acquire memory (façade).
  * @see ram_default_acquire
@@ -81,6 +90,15 @@ typedef rammem_free_t ram_free_t;
  */
 #define ram_discard ram_default_discard
 
+/**
+ * @brief change the size of an allocation (façade).
+ * @see ram_default_resize
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_resize ram_default_resize
+
 /**
  * @brief reclaim memory (façade).
  * @see ram_default_reclaim
@@ -90,6 +108,42 @@ typedef rammem_free_t ram_free_t;
  */
 #define ram_reclaim ram_default_reclaim
 
+/**
+ * @brief describes a time-bounded reclamation (façade).
+ * @see ram_default_reclaimstats_t
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+typedef ram_default_reclaimstats_t ram_reclaimstats_t;
+
+/**
+ * @brief reclaim memory within a time budget (façade).
+ * @see ram_default_reclaimfor
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_reclaimfor ram_default_reclaimfor
+
+/**
+ * @brief hold memory in reserve (façade).
+ * @see ram_default_reserve
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_reserve ram_default_reserve
+
+/**
+ * @brief hold memory in reserve for several sizes (façade).
+ * @see ram_default_prewarm
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_prewarm ram_default_prewarm
+
 /**
  * @brief flush the calling thread's allocator (façade).
  * @see ram_default_flush
@@ -99,6 +153,97 @@ typedef rammem_free_t ram_free_t;
  */
 #define ram_flush ram_default_flush
 
+/**
+ * @brief let other threads reclaim on the calling thread's behalf
+ *    (façade).
+ * @see ram_default_handoff
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_handoff ram_default_handoff
+
+/**
+ * @brief notification function signature (façade).
+ * @see ram_default_notify_t
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+typedef ram_default_notify_t ram_notify_t;
+
+/**
+ * @brief describes a notification (façade).
+ * @see ram_default_notifier_t
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+typedef ram_default_notifier_t ram_notifier_t;
+
+/**
+ * @brief ask to be told when the trash needs servicing (façade).
+ * @see ram_default_notify
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_notify ram_default_notify
+
+/**
+ * @brief a heap that isn't tied to a thread (façade).
+ * @see ram_default_heap_t
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+typedef ram_default_heap_t ram_heap_t;
+
+/**
+ * @brief create a heap (façade).
+ * @see ram_default_mkheap
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_mkheap ram_default_mkheap
+
+/**
+ * @brief remove a heap (façade).
+ * @see ram_default_rmheap
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_rmheap ram_default_rmheap
+
+/**
+ * @brief acquire a quantity of memory from a heap (façade).
+ * @see ram_default_heapacquire
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_heapacquire ram_default_heapacquire
+
+/**
+ * @brief discard memory on behalf of a heap (façade).
+ * @see ram_default_heapdiscard
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_heapdiscard ram_default_heapdiscard
+
+/**
+ * @brief reclaim discarded memory into a heap (façade).
+ * @see ram_default_heapreclaim
+ * @remark this identifier is a @e façade, meaning it aliases another
+ *    identifier for convenience. please see the documentation for the
+ *    aliased identifier for detailed information about its use.
+ */
+#define ram_heapreclaim ram_default_heapreclaim
+
 /**
  * @brief inquire about a pointer (façade).
  * @see ram_default_query
@@ -38,19 +38,93 @@
 #include <ramalloc/mux.h>
 #include <ramalloc/tra.h>
 
+/* the number of outgoing buffers each pool keeps and the number of
+ * objects a buffer holds before it's sent to the pool that owns them. */
+#define RAMLAZY_OUTGOINGCOUNT 8
+#define RAMLAZY_OUTGOINGSIZE 32
+/* when a thread sends objects to a pool whose trash is at least
+ * RAMLAZY_DELEGATEDEPTH pages deep and whose owner has handed it off, the
+ * thread merges up to RAMLAZY_DELEGATEBATCH of those pages on the owner's
+ * behalf. */
+#define RAMLAZY_DELEGATEDEPTH 64
+#define RAMLAZY_DELEGATEBATCH 64
+
+/* a lazy pool reclaims *ramlazyp_mingoal* objects from its trash each
+ * time it acquires one. when it meets its goal, objects are arriving faster
+ * than it's getting rid of them, so it doubles the goal up to
+ * *ramlazyp_maxgoal*. when the trash runs dry or is found empty, it
+ * halves the goal again. */
+typedef struct ramlazy_policy
+{
+   size_t ramlazyp_mingoal;
+   size_t ramlazyp_maxgoal;
+} ramlazy_policy_t;
+
+struct ramlazy_pool;
+
+/* objects that the pool's thread released on behalf of another pool,
+ * all from the same page and linked through their first word. */
+typedef struct ramlazy_outgoing
+{
+   struct ramlazy_pool *ramlazyo_dest;
+   void *ramlazyo_token;
+   void *ramlazyo_first;
+   void *ramlazyo_last;
+   size_t ramlazyo_count;
+} ramlazy_outgoing_t;
+
 typedef struct ramlazy_pool
 {
    rammux_pool_t ramlazyp_muxpool;
    ramtra_trash_t ramlazyp_trash;
-   size_t ramlazyp_disposalratio;
+   ramlazy_policy_t ramlazyp_policy;
+   size_t ramlazyp_goal;
+   ramlazy_outgoing_t ramlazyp_outgoing[RAMLAZY_OUTGOINGCOUNT];
+   /* the mux pool and the consuming end of the trash belong to whoever
+    * occupies the pool. the owner occupies it from the moment it's made
+    * until it's handed off; after that, it's vacant (NULL) except while a
+    * delegate is reclaiming on the owner's behalf. */
+   void * volatile ramlazyp_occupant;
+   /* nonzero while the owner has handed the pool off. only the owner
+    * looks at this, so checking it costs nothing on the owner's path. */
+   int ramlazyp_handoffflag;
 } ramlazy_pool_t;
 
-ram_reply_t ramlazy_mkpool(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg);
+ram_reply_t ramlazy_mkpool(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg);
+/* replies RAM_REPLY_DISALLOWED if any of the pool's objects are still in
+ * use, in which case the pool remains usable and belongs to the caller. */
 ram_reply_t ramlazy_rmpool(ramlazy_pool_t *lpool_arg);
+/* *emptyflag_arg* receives nonzero if none of the pool's objects are in
+ * use. objects still waiting in the trash (or in another pool's outgoing
+ * buffers) count as in use, so the caller should flush first. */
+ram_reply_t ramlazy_isempty(int *emptyflag_arg, const ramlazy_pool_t *lpool_arg);
 ram_reply_t ramlazy_acquire(void **newptr_arg, ramlazy_pool_t *lpool_arg, size_t size_arg);
 ram_reply_t ramlazy_release(void *ptr_arg);
-ram_reply_t ramlazy_reclaim(size_t *count_arg, ramlazy_pool_t *lpool_arg, size_t goal_arg);
+/* releases *ptr_arg*, which belongs to *lpool_arg* and is *size_arg* bytes
+ * large. *caller_arg* is the pool owned by the calling thread, if it has
+ * one. if it's *lpool_arg*, the object is released immediately; otherwise,
+ * it's buffered in *caller_arg* on its way to *lpool_arg*. */
+ram_reply_t ramlazy_discard(ramlazy_pool_t *lpool_arg, void *ptr_arg,
+      size_t size_arg, ramlazy_pool_t *caller_arg);
+/* sends everything in the pool's outgoing buffers to the pools that own
+ * it. */
+ram_reply_t ramlazy_dispatch(ramlazy_pool_t *lpool_arg);
+ram_reply_t ramlazy_reserve(ramlazy_pool_t *lpool_arg, size_t size_arg, size_t count_arg);
+/* *pages_arg* receives the number of pages that reclamation emptied and
+ * returned to the page layer. */
+ram_reply_t ramlazy_reclaim(size_t *count_arg, size_t *pages_arg, ramlazy_pool_t *lpool_arg, size_t goal_arg);
 ram_reply_t ramlazy_flush(ramlazy_pool_t *lpool_arg);
+/* lets threads that discard into the pool reclaim its trash until the
+ * owner next uses it. an owner that's about to block for a while (or a
+ * thread that's orphaning the pool) can call this so that memory sent to
+ * the pool isn't stranded in the meantime. */
+ram_reply_t ramlazy_handoff(ramlazy_pool_t *lpool_arg);
+/* the notifier is told when the pool's trash reaches a given depth. see
+ * ramtra_notify(). */
+ram_reply_t ramlazy_notify(ramlazy_pool_t *lpool_arg, const ramtra_notifier_t *notifier_arg);
+/* *goal_arg* receives the number of objects the pool will try to reclaim
+ * the next time it acquires one. */
+ram_reply_t ramlazy_getgoal(size_t *goal_arg, const ramlazy_pool_t *lpool_arg);
 ram_reply_t ramlazy_query(ramlazy_pool_t **lpool_arg, size_t *size_arg, void *ptr_arg);
 ram_reply_t ramlazy_chkpool(const ramlazy_pool_t *lpool_arg);
 
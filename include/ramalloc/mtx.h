@@ -42,6 +42,8 @@ typedef ramsys_mutex_t rammtx_mutex_t;
 #define rammtx_mkmutex ramsys_mkmutex
 #define rammtx_rmmutex ramsys_rmmutex
 #define rammtx_wait ramsys_waitformutex
+/* rammtx_trywait() doesn't wait; it reports whether it got the mutex. */
+#define rammtx_trywait ramsys_trywaitformutex
 #define rammtx_quit ramsys_quitmutex
 
 #endif /* RAMMTX_H_IS_INCLUDED */
@@ -36,22 +36,46 @@
 
 #include <ramalloc/algn.h>
 #include <ramalloc/want.h>
+#include <ramalloc/vas.h>
+#include <ramalloc/sizeclass.h>
 
-#define RAMMUX_MAXPOOLCOUNT 128
+/* each size class gets its own partition when RAM_WANT_PARTITIONED is
+ * enabled. */
+#define RAMMUX_MAXPOOLCOUNT RAMMUX_CLASSCOUNT
+#if RAMMUX_MAXPOOLCOUNT > RAMVAS_PARTITIONCOUNT
+#  error there are more size classes than partitions.
+#endif
 
 typedef struct rammux_pool
 {
    ramalgn_tag_t rammuxp_tag;
-   size_t rammuxp_step;
-   ramalgn_pool_t rammuxp_apools[RAMMUX_MAXPOOLCOUNT];
+   /* a size class's pool is taken from a shared arena the first time it's
+    * needed, so a pool (and each thread that owns one) only pays for the
+    * classes it actually uses. a class that can't be accommodated is
+    * remembered as such, so it isn't retried. */
+   ramalgn_pool_t *rammuxp_apools[RAMMUX_MAXPOOLCOUNT];
    rampg_appetite_t rammuxp_appetite;
-   int8_t rammuxp_initflags[RAMMUX_MAXPOOLCOUNT];
 } rammux_pool_t;
 
+ram_reply_t rammux_initialize();
 ram_reply_t rammux_mkpool(rammux_pool_t *mpool_arg, rampg_appetite_t appetite_arg);
+/* replies RAM_REPLY_DISALLOWED if any of the pool's objects are still in
+ * use. the size classes that were empty are given up regardless, so the
+ * pool remains usable. */
+ram_reply_t rammux_rmpool(rammux_pool_t *mpool_arg);
+ram_reply_t rammux_isempty(int *emptyflag_arg, const rammux_pool_t *mpool_arg);
 ram_reply_t rammux_acquire(void **newptr_arg, rammux_pool_t *mpool_arg, size_t size_arg);
 #define rammux_release ramalgn_release
+#define rammux_gettoken ramalgn_gettoken
+#define rammux_defer ramalgn_defer
+#define rammux_merge ramalgn_merge
+ram_reply_t rammux_reserve(rammux_pool_t *mpool_arg, size_t size_arg, size_t count_arg);
 ram_reply_t rammux_query(rammux_pool_t **mpool_arg, size_t *size_arg, void *ptr_arg);
+ram_reply_t rammux_querytoken(rammux_pool_t **mpool_arg, void *token_arg);
 ram_reply_t rammux_chkpool(const rammux_pool_t *mpool_arg);
+ram_reply_t rammux_getclass(size_t *class_arg, size_t *classsize_arg, size_t size_arg);
+/* reports the bytes of metadata the pool occupies, including the size class
+ * pools it has taken from the arena. */
+ram_reply_t rammux_getfootprint(size_t *bytes_arg, const rammux_pool_t *mpool_arg);
 
-#endif /* RAMMUX_H_IS_INCLUDED */
\ No newline at end of file
+#endif /* RAMMUX_H_IS_INCLUDED */
@@ -0,0 +1,77 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#ifndef RAMOWN_H_IS_INCLUDED
+#define RAMOWN_H_IS_INCLUDED
+
+#include <ramalloc/fail.h>
+#include <ramalloc/stdint.h>
+
+/* an ownership map associates pages with the structures that own them, so
+ * that an allocator can find the owner of any address without storing
+ * anything in the page itself. it's a radix table keyed by page number:
+ * the root is part of the map, and the branches and leaves beneath it are
+ * created on demand with a compare-and-swap. they're never freed, so
+ * lookups don't need a lock. an address the map doesn't know about
+ * resolves to RAM_REPLY_NOTFOUND, whatever the page happens to contain. */
+
+#if UINTPTR_MAX > 0xffffffffu
+   /* most 64-bit systems only use the lower 48 bits of an address. */
+#  define RAMOWN_ADDRESSBITS 48
+#  define RAMOWN_FANOUTBITS 12
+#else
+#  define RAMOWN_ADDRESSBITS 32
+#  define RAMOWN_FANOUTBITS 10
+#endif
+/* the smallest page size the map can accommodate is 4 KiB. */
+#define RAMOWN_MINPAGEBITS 12
+#define RAMOWN_FANOUT ((size_t)1 << RAMOWN_FANOUTBITS)
+#define RAMOWN_ROOTCOUNT ((size_t)1 << (RAMOWN_ADDRESSBITS - \
+      RAMOWN_MINPAGEBITS - 2 * RAMOWN_FANOUTBITS))
+
+typedef struct ramown_map
+{
+   /* each entry refers to a branch of RAMOWN_FANOUT entries, each of
+    * which refers to a leaf of RAMOWN_FANOUT owners. */
+   void * volatile ramownm_root[RAMOWN_ROOTCOUNT];
+} ramown_map_t;
+
+ram_reply_t ramown_initialize();
+/* passing NULL for *owner_arg* removes the page from the map. */
+ram_reply_t ramown_set(ramown_map_t *map_arg, const void *page_arg,
+      void *owner_arg);
+ram_reply_t ramown_get(void **owner_arg, const ramown_map_t *map_arg,
+      const void *ptr_arg);
+/* reports how many bytes of branches and leaves the map has created. */
+ram_reply_t ramown_getfootprint(size_t *bytes_arg, const ramown_map_t *map_arg);
+
+#endif /* RAMOWN_H_IS_INCLUDED */
@@ -37,21 +37,78 @@
 #include <ramalloc/fail.h>
 #include <ramalloc/tls.h>
 #include <ramalloc/lazy.h>
+#include <ramalloc/list.h>
+#include <ramalloc/mtx.h>
+#include <ramalloc/stdint.h>
+
+/* the number of objects (or reservations) i reclaim between looks at the
+ * clock in rampara_reclaimfor(). */
+#define RAMPARA_RECLAIMBATCH 64
 
 typedef struct rampara_pool
 {
    ramtls_key_t ramparap_tlskey;
    rampg_appetite_t ramparap_appetite;
-   size_t ramparap_reclaimratio;
+   ramlazy_policy_t ramparap_policy;
+   /* when a thread exits, its lazy pool is put here to be adopted by the
+    * next thread that needs one. */
+   ramlist_list_t ramparap_orphans;
+   rammtx_mutex_t ramparap_mutex;
+   /* distinguishes this pool from any other that's been made at the same
+    * address, so that a thread's cached pool can't be mistaken for one
+    * that belongs to a pool that's since been destroyed. */
+   long ramparap_serial;
 } rampara_pool_t;
 
-ram_reply_t rampara_mkpool(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, size_t reclaimratio_arg);
+typedef struct rampara_reclaimstats
+{
+   size_t ramparars_objects;
+   size_t ramparars_pages;
+   size_t ramparars_reservations;
+   uint64_t ramparars_elapsed;
+   int ramparars_complete;
+} rampara_reclaimstats_t;
+
+ram_reply_t rampara_mkpool(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg);
+/* takes apart the calling thread's pool and the pools of threads that have
+ * exited. replies RAM_REPLY_DISALLOWED if any of them still has objects in
+ * use; the empty ones are freed regardless and the pool remains usable. */
 ram_reply_t rampara_rmpool(rampara_pool_t *parapool_arg);
 ram_reply_t rampara_acquire(void **newptr_arg, rampara_pool_t *parapool_arg, size_t size_arg);
-#define rampara_release ramlazy_release
+/* replies RAM_REPLY_NOTFOUND if the object doesn't belong to a parallel
+ * pool. */
+ram_reply_t rampara_release(void *ptr_arg);
+ram_reply_t rampara_reserve(rampara_pool_t *parapool_arg, size_t size_arg, size_t count_arg);
 ram_reply_t rampara_reclaim(size_t *count_arg, rampara_pool_t *parapool_arg, size_t goal_arg);
+ram_reply_t rampara_reclaimfor(rampara_reclaimstats_t *stats_arg, rampara_pool_t *parapool_arg, uint64_t budget_arg);
 ram_reply_t rampara_flush(rampara_pool_t *parapool_arg);
+/* hands the calling thread's pool off; see ramlazy_handoff(). */
+ram_reply_t rampara_handoff(rampara_pool_t *parapool_arg);
+/* the notifier is copied into the calling thread's pool, so it needn't
+ * remain valid after the call returns. */
+ram_reply_t rampara_notify(rampara_pool_t *parapool_arg, const ramtra_notifier_t *notifier_arg);
 ram_reply_t rampara_query(rampara_pool_t **parapool_arg, size_t *size_arg, void *ptr_arg);
 ram_reply_t rampara_chkpool(const rampara_pool_t *parapool_arg);
 
+/* a heap is a lazy pool that belongs to a parallel pool but not to any
+ * thread, so finding it doesn't involve thread-local storage. it's meant
+ * for fibers and coroutines that move between threads: whichever thread is
+ * running the fiber uses the fiber's heap. a heap mustn't be used by more
+ * than one thread at a time, but it can be handed from one thread to
+ * another with whatever synchronization the hand-off already involves.
+ * objects from a heap can be discarded with rampara_release() like any
+ * other. */
+typedef struct rampara_tls rampara_heap_t;
+
+ram_reply_t rampara_mkheap(rampara_heap_t **heap_arg, rampara_pool_t *parapool_arg);
+/* a heap that's removed is orphaned, just like the pool of a thread that
+ * exits, so objects acquired from it remain valid. */
+ram_reply_t rampara_rmheap(rampara_heap_t *heap_arg);
+ram_reply_t rampara_heapacquire(void **newptr_arg, rampara_heap_t *heap_arg, size_t size_arg);
+/* releases *ptr_arg* with *heap_arg* playing the part of the calling
+ * thread's pool. replies RAM_REPLY_NOTFOUND if the object doesn't belong
+ * to a parallel pool. */
+ram_reply_t rampara_heapdiscard(rampara_heap_t *heap_arg, void *ptr_arg);
+ram_reply_t rampara_heapreclaim(size_t *count_arg, rampara_heap_t *heap_arg, size_t goal_arg);
+
 #endif /* RAMPARA_H_IS_INCLUDED */
\ No newline at end of file
@@ -44,10 +44,10 @@
  * @brief page appetites.
  * @details a <b>page appetite</b> specifies a strategy for returning
  *    unused memory the virtual memory subsystem.
- * @remark due to differences in the virtual memory subsystems on Windows
- *    and POSIX-compliant systems, appetites currently only affect the
- *    use of virtual memory on Windows systems. POSIX-compliant systems
- *    always behave as if @e RAMOPT_FRUGAL was specified.
+ * @remark on Windows, frugal pools decommit pages with @c MEM_DECOMMIT
+ *    and greedy pools reset them with @c MEM_RESET. on POSIX-compliant
+ *    systems, frugal pools use @c MADV_DONTNEED and greedy pools use
+ *    @c MADV_FREE (or @c MADV_DONTNEED, if the kernel doesn't support it).
  * @remark the choice of appetite will affect the degree of reluctance that
  *    @e ramalloc has regarding returning memory to the host system but
  *    @e ramalloc @b never withholds unused memory indefinitely.
@@ -56,24 +56,64 @@ typedef enum rampg_appetites
 {
    /** return unused memory to the host system at the first opportunity. */
    RAMOPT_FRUGAL,
-   /** return unused memory in quantities matching the system's allocation
-    * granularity (Windows only). */
+   /** keep unused pages committed but allow the host system to reclaim
+    * their contents at its leisure. address space is returned in
+    * quantities matching the system's allocation granularity. */
    RAMOPT_GREEDY,
+   /** reserve memory a transparent huge page at a time, packing the pages
+    * (and the bookkeeping that describes them) into the huge page to reduce
+    * TLB pressure. unused pages remain committed until the entire huge
+    * page is unused (Linux only). */
+   RAMOPT_GLUTTONOUS,
 } rampg_appetite_t;
 
+#define RAMPG_NOPARTITION ((size_t)-1)
+/* the longest run of contiguous pages a pool can hand out at once (see
+ * rampg_setrunlength()). */
+#define RAMPG_MAXRUNLENGTH 64
+
 typedef struct rampg_pool
 {
    ramvec_pool_t rampgp_vpool;
    ramslot_pool_t rampgp_slotpool;
    rampg_appetite_t rampgp_appetite;
    ramsig_signature_t rampgp_slotsig;
+   /* pages that have been acquired from the pool's nodes but are held in
+    * reserve, linked through their first word (see rampg_reserve()). */
+   char *rampgp_reserve;
+   size_t rampgp_reservesz;
+   size_t rampgp_floor;
+   /* the address space partition the pool's reservations come from, or
+    * RAMPG_NOPARTITION (see rampg_confine()). */
+   size_t rampgp_partition;
+   /* the number of contiguous pages handed out by each acquisition. */
+   size_t rampgp_runlength;
 } rampg_pool_t;
 
 ram_reply_t ram_slab_initialize();
 ram_reply_t rampg_mkpool(rampg_pool_t *pool_arg, rampg_appetite_t appetite_arg);
 ram_reply_t rampg_acquire(void **newptr_arg, rampg_pool_t *pool_arg);
 ram_reply_t rampg_release(void *ptr_arg);
+ram_reply_t rampg_reserve(rampg_pool_t *pool_arg, size_t count_arg);
+/* confines the pool's reservations to an address space partition (see
+ * vas.h). this must be done before the pool acquires any pages. */
+ram_reply_t rampg_confine(rampg_pool_t *pool_arg, size_t partition_arg);
+/* makes each acquisition hand out a run of *pages_arg* contiguous pages,
+ * aligned to its length within a reservation, instead of a single page.
+ * the length must be a power of two no greater than RAMPG_MAXRUNLENGTH
+ * that divides the number of pages in a reservation.
+ * the pool's reserve then holds runs, and only the address of a run's
+ * first page can be released. like rampg_confine(), this must be done
+ * before the pool acquires any pages. */
+ram_reply_t rampg_setrunlength(rampg_pool_t *pool_arg, size_t pages_arg);
 ram_reply_t rampg_chkpool(const rampg_pool_t *pool_arg);
 ram_reply_t rampg_getgranularity(size_t *granularity_arg);
+/* reports how many huge pages' worth of memory gluttonous pools have
+ * mapped (*regions_arg*) and how much of it is actually backed by huge
+ * pages (*backed_arg*). mappings made outside of ramalloc aren't counted,
+ * unless the system merged one with a gluttonous region, in which case
+ * its huge pages may be credited to the region. */
+ram_reply_t rampg_gethugestats(size_t *regions_arg, size_t *backed_arg);
+ram_reply_t rampg_getoverhead(size_t *metadata_arg, size_t *payload_arg);
 
 #endif /* RAMPG_H_IS_INCLUDED */
@@ -0,0 +1,73 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#ifndef RAMRCY_H_IS_INCLUDED
+#define RAMRCY_H_IS_INCLUDED
+
+#include <ramalloc/fail.h>
+#include <ramalloc/want.h>
+
+/* the recycler holds onto empty page pool reservations (see
+ * ramsys_reserve()) on behalf of every page pool in the process, so that
+ * a pool that needs a new node can reuse the reservation some other pool
+ * (possibly for another size class, in another thread) just gave up,
+ * instead of asking the system for a new one. it doesn't use locks. */
+
+typedef struct ramrcy_stats
+{
+   /* the number of reservations the recycler currently holds. */
+   size_t ramrcys_count;
+   /* withdrawals satisfied by the recycler. */
+   size_t ramrcys_hits;
+   /* withdrawals that had to be satisfied by the system. */
+   size_t ramrcys_misses;
+   /* reservations returned to the system to honor the watermarks. */
+   size_t ramrcys_trims;
+} ramrcy_stats_t;
+
+ram_reply_t ramrcy_initialize();
+/* once the recycler holds more than *high_arg* reservations, it returns
+ * reservations to the system until it holds *low_arg*. */
+ram_reply_t ramrcy_setwatermarks(size_t low_arg, size_t high_arg);
+ram_reply_t ramrcy_getwatermarks(size_t *low_arg, size_t *high_arg);
+/* *commitflag_arg* indicates whether every page in the reservation is
+ * committed (nonzero) or none of them are (zero). */
+ram_reply_t ramrcy_deposit(char *pages_arg, int commitflag_arg);
+ram_reply_t ramrcy_withdraw(char **pages_arg, int *commitflag_arg);
+ram_reply_t ramrcy_flush();
+/* returns at most *goal_arg* reservations to the system, regardless of the
+ * watermarks, and reports how many it returned in *count_arg*. */
+ram_reply_t ramrcy_shed(size_t *count_arg, size_t goal_arg);
+ram_reply_t ramrcy_getstats(ramrcy_stats_t *stats_arg);
+
+#endif /* RAMRCY_H_IS_INCLUDED */
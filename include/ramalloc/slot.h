@@ -65,6 +65,11 @@ struct ramslot_node
    char *ramslotn_slots;
    ramslot_size_t ramslotn_count;
    ramslot_index_t ramslotn_freestk;
+   /* objects released by other threads, linked through their first word.
+    * the low bit is set while the node is waiting to be merged. */
+   void * volatile ramslotn_remote;
+   /* the word that ramslot_defer() hands out to queue the node with. */
+   void *ramslotn_link;
 };
 
 struct ramslot_pool
@@ -81,6 +86,19 @@ ram_reply_t ramslot_mkpool(ramslot_pool_t *pool_arg, size_t granularity_arg,
    ramslot_initslot_t initslot_arg);
 ram_reply_t ramslot_acquire(void **newptr_arg, ramslot_pool_t *pool_arg);
 ram_reply_t ramslot_release(void *ptr_arg, ramslot_node_t *node_arg);
+/* a token identifies a node to threads other than the pool's owner. it's
+ * a word that can be used to link the node into a list. */
+ram_reply_t ramslot_gettoken(void **token_arg, ramslot_node_t *node_arg);
+ram_reply_t ramslot_gettokennode(ramslot_node_t **node_arg, void *token_arg);
+/* ramslot_defer() may be called from any thread. it leaves the chain of
+ * objects from *first_arg* to *last_arg*, linked through their first
+ * word, on the node's remote list until the pool's owner calls
+ * ramslot_merge(). if *queueflag_arg* comes back set, the caller must
+ * pass the token on to the owner so that it gets merged. */
+ram_reply_t ramslot_defer(int *queueflag_arg, void *token_arg, void *first_arg,
+   void *last_arg);
+/* *emptyflag_arg* is set if merging emptied the node, which destroys it. */
+ram_reply_t ramslot_merge(size_t *count_arg, int *emptyflag_arg, void *token_arg);
 ram_reply_t ramslot_chkpool(const ramslot_pool_t *pool_arg);
 ram_reply_t ramslot_getgranularity(size_t *granularity_arg, const ramslot_pool_t *slotpool_arg);
 
@@ -39,10 +39,30 @@
 #define RAMGCC_MESSAGE(Message) RAMGCC_PRAGMA(message (#Message))
 #define RAMGCC_PRINTFDECL(Decl, FmtStrOrdinal, VarArgsOrdinal) \
    Decl __attribute__((format(printf, FmtStrOrdinal, VarArgsOrdinal)))
+/* the __sync builtins imply a full memory barrier. */
+#define RAMGCC_CASPTR(Target, Comparand, Exchange) \
+   (__sync_val_compare_and_swap((Target), (Comparand), (Exchange)))
+#define RAMGCC_XADD(Target, Addend) \
+   (__sync_fetch_and_add((Target), (Addend)))
+/* __sync_lock_test_and_set() is only an acquire barrier, which is all
+ * that taking ownership of whatever *Target points to requires. */
+#define RAMGCC_XCHGPTR(Target, Exchange) \
+   (__sync_lock_test_and_set((Target), (Exchange)))
+/* the result is undefined if Word is 0. */
+#define RAMGCC_CTZ64(Word) (__builtin_ctzll(Word))
+/* the initial-exec model resolves a thread-local variable to a fixed
+ * offset from the thread pointer, which is fine as long as ramalloc isn't
+ * loaded with dlopen(). */
+#define RAMGCC_THREADLOCAL __thread __attribute__((tls_model("initial-exec")))
 
 #define RAMSYS_ALIGNOF RAMGCC_ALIGNOF
 #define RAMSYS_MESSAGE(Message) RAMGCC_MESSAGE
 #define RAMSYS_PRINTFDECL(Decl, FmtStrOrdinal, VarArgsOrdinal) \
    RAMGCC_PRINTFDECL(Decl, FmtStrOrdinal, VarArgsOrdinal)
+#define RAMSYS_CASPTR RAMGCC_CASPTR
+#define RAMSYS_XADD RAMGCC_XADD
+#define RAMSYS_XCHGPTR RAMGCC_XCHGPTR
+#define RAMSYS_CTZ64 RAMGCC_CTZ64
+#define RAMSYS_THREADLOCAL RAMGCC_THREADLOCAL
 
 #endif /* RAMALLOC_GCC_H_IS_INCLUDED */
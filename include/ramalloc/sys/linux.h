@@ -51,24 +51,49 @@ typedef struct ramlin_barrier
    volatile size_t ramlinb_vacancy;
    size_t ramlinb_capacity;
    uintptr_t ramlinb_cycle;
+   /* the number of threads that haven't yet let go of the mutex. */
+   size_t ramlinb_occupancy;
 } ramlin_barrier_t;
 
+ram_reply_t ramlin_initialize();
+ram_reply_t ramlin_hugepagesize(size_t *hugepgsz_arg);
+ram_reply_t ramlin_reservehuge(char **pages_arg);
+ram_reply_t ramlin_releasehuge(char *pages_arg);
+ram_reply_t ramlin_remaprange(char **newpages_arg, char *pages_arg,
+      size_t oldsize_arg, size_t newsize_arg);
+ram_reply_t ramlin_hugestats(size_t *regions_arg, size_t *backed_arg,
+      ramsys_overlap_t overlap_arg, void *context_arg);
+ram_reply_t ramlin_whichcpu(size_t *cpu_arg);
+
 ram_reply_t ramlin_mkbarrier(ramlin_barrier_t *barrier_arg,
       size_t capacity_arg);
 ram_reply_t ramlin_rmbarrier(ramlin_barrier_t *barrier_arg);
 ram_reply_t ramlin_waitonbarrier(ramlin_barrier_t *barrier_arg);
 
-#define ramsys_initialize ramuix_initialize
+#define ramsys_initialize ramlin_initialize
 /* virtual memory mapping */
 #define ramsys_pagesize ramuix_pagesize
 #define ramsys_mmapgran ramuix_mmapgran
 #define ramsys_cpucount ramuix_cpucount
+#define ramsys_whichcpu ramlin_whichcpu
+/* timing */
+#define ramsys_clock ramuix_clock
 #define ramsys_reserve ramuix_reserve
 #define ramsys_commit ramuix_commit
+#define ramsys_commitrange ramuix_commitrange
 #define ramsys_decommit ramuix_decommit
 #define ramsys_reset ramuix_reset
 #define ramsys_bulkalloc ramuix_bulkalloc
 #define ramsys_release ramuix_release
+#define ramsys_reserverange ramuix_reserverange
+#define ramsys_releaserange ramuix_releaserange
+#define ramsys_maprange ramuix_maprange
+#define ramsys_remaprange ramlin_remaprange
+/* huge pages */
+#define ramsys_hugepagesize ramlin_hugepagesize
+#define ramsys_reservehuge ramlin_reservehuge
+#define ramsys_releasehuge ramlin_releasehuge
+#define ramsys_hugestats ramlin_hugestats
 /* thread local storage */
 typedef ramuix_tlskey_t ramsys_tlskey_t;
 #define ramsys_mktlskey ramuix_mktlskey
@@ -80,6 +105,7 @@ typedef ramuix_mutex_t ramsys_mutex_t;
 #define ramsys_mkmutex ramuix_mkmutex
 #define ramsys_rmmutex ramuix_rmmutex
 #define ramsys_waitformutex ramuix_waitformutex
+#define ramsys_trywaitformutex ramuix_trywaitformutex
 #define ramsys_quitmutex ramuix_quitmutex
 /* threads */
 typedef ramuix_thread_t ramsys_thread_t;
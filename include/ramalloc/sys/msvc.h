@@ -34,14 +34,51 @@
 #ifndef RAMALLOC_MSVC_H_IS_INCLUDED
 #define RAMALLOC_MSVC_H_IS_INCLUDED
 
+#include <intrin.h>
+
 #define RAMMSVC_ALIGNOF(Type) (__alignof(Type))
 #define RAMMSVC_PRAGMA(Args) __pragma(#Args)
 #define RAMMSVC_MESSAGE(Message) RAMMSVC_PRAGMA(message (#Message))
 #define RAMMSVC_PRINTFDECL(Decl, FmtStrOrdinal, VarArgsOrdinal) Decl
+/* the interlocked intrinsics are declared in <Windows.h>, which
+ * <ramalloc/sys/win.h> includes. */
+#define RAMMSVC_CASPTR(Target, Comparand, Exchange) \
+   (InterlockedCompareExchangePointer((PVOID volatile *)(Target), \
+         (Exchange), (Comparand)))
+#define RAMMSVC_XADD(Target, Addend) \
+   (InterlockedExchangeAdd((Target), (Addend)))
+#define RAMMSVC_XCHGPTR(Target, Exchange) \
+   (InterlockedExchangePointer((PVOID volatile *)(Target), (Exchange)))
+/* _BitScanForward64() reports its result through an argument, so i need
+ * a function to use it in an expression. the result is undefined if
+ * Word is 0. */
+#define RAMMSVC_CTZ64(Word) (rammsvc_ctz64(Word))
+#define RAMMSVC_THREADLOCAL __declspec(thread)
 
 #define RAMSYS_ALIGNOF(Type) RAMMSVC_ALIGNOF(Type)
 #define RAMSYS_MESSAGE(Message) RAMMSVC_MESSAGE(Message)
 #define RAMSYS_PRINTFDECL(Decl, FmtStrOrdinal, VarArgsOrdinal) \
    RAMMSVC_PRINTFDECL(Decl, FmtStrOrdinal, VarArgsOrdinal)
+#define RAMSYS_CASPTR(Target, Comparand, Exchange) \
+   RAMMSVC_CASPTR(Target, Comparand, Exchange)
+#define RAMSYS_XADD(Target, Addend) RAMMSVC_XADD(Target, Addend)
+#define RAMSYS_XCHGPTR(Target, Exchange) RAMMSVC_XCHGPTR(Target, Exchange)
+#define RAMSYS_CTZ64(Word) RAMMSVC_CTZ64(Word)
+#define RAMSYS_THREADLOCAL RAMMSVC_THREADLOCAL
+
+static __inline unsigned long rammsvc_ctz64(unsigned __int64 word_arg)
+{
+   unsigned long i = 0;
+
+#ifdef _WIN64
+   _BitScanForward64(&i, word_arg);
+#else
+   if (_BitScanForward(&i, (unsigned long)word_arg))
+      return i;
+   _BitScanForward(&i, (unsigned long)(word_arg >> 32));
+   i += 32;
+#endif
+   return i;
+}
 
 #endif /* RAMALLOC_MSVC_H_IS_INCLUDED */
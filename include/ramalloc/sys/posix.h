@@ -39,6 +39,7 @@
 #ifdef RAMSYS_POSIX
 
 #include <ramalloc/fail.h>
+#include <ramalloc/stdint.h>
 #include <limits.h>
 
 #define RAMUIX_PATH_MAX PATH_MAX
@@ -47,12 +48,17 @@ ram_reply_t ramuix_initialize();
 ram_reply_t ramuix_pagesize(size_t *pagesz_arg);
 ram_reply_t ramuix_mmapgran(size_t *mmapgran_arg);
 ram_reply_t ramuix_cpucount(size_t *cpucount_arg);
+ram_reply_t ramuix_clock(uint64_t *nsec_arg);
 ram_reply_t ramuix_commit(char *page_arg);
+ram_reply_t ramuix_commitrange(char *pages_arg, size_t size_arg);
 ram_reply_t ramuix_decommit(char *page_arg);
 ram_reply_t ramuix_reset(char *page_arg);
 ram_reply_t ramuix_reserve(char **pages_arg);
 ram_reply_t ramuix_bulkalloc(char **pages_arg);
 ram_reply_t ramuix_release(char *pages_arg);
+ram_reply_t ramuix_reserverange(char **pages_arg, size_t size_arg);
+ram_reply_t ramuix_releaserange(char *pages_arg, size_t size_arg);
+ram_reply_t ramuix_maprange(char **pages_arg, size_t size_arg);
 ram_reply_t ramuix_basename(char *dest_arg, size_t len_arg,
    const char *pathn_arg);
 
@@ -47,7 +47,7 @@ typedef pthread_mutex_t ramuix_mutex_t;
 typedef pthread_t ramuix_thread_t;
 typedef pthread_barrier_t ramuix_barrier_t;
 
-ram_reply_t ramuix_mktlskey(ramuix_tlskey_t *key_arg);
+ram_reply_t ramuix_mktlskey(ramuix_tlskey_t *key_arg, ramsys_tlsdtor_t dtor_arg);
 ram_reply_t ramuix_rmtlskey(ramuix_tlskey_t key_arg);
 ram_reply_t ramuix_rcltls(void **tls_arg, ramuix_tlskey_t key_arg);
 ram_reply_t ramuix_stotls(ramuix_tlskey_t key_arg, void *value_arg);
@@ -55,6 +55,8 @@ ram_reply_t ramuix_stotls(ramuix_tlskey_t key_arg, void *value_arg);
 ram_reply_t ramuix_mkmutex(ramuix_mutex_t *mutex_arg);
 ram_reply_t ramuix_rmmutex(ramuix_mutex_t *mutex_arg);
 ram_reply_t ramuix_waitformutex(ramuix_mutex_t *mutex_arg);
+ram_reply_t ramuix_trywaitformutex(int *successflag_arg,
+      ramuix_mutex_t *mutex_arg);
 ram_reply_t ramuix_quitmutex(ramuix_mutex_t *mutex_arg);
 
 ram_reply_t ramuix_mkthread(ramuix_thread_t *thread_arg,
@@ -36,5 +36,7 @@
 
 #undef RAMSYS_MESSAGE
 #define RAMSYS_MESSAGE(Message) /* unsupported */
+#undef RAMSYS_THREADLOCAL
+#define RAMSYS_THREADLOCAL /* unsupported */
 
 #endif /* RAMALLOC_SPLINT_H_IS_INCLUDED */
@@ -38,4 +38,19 @@
 
 typedef ram_reply_t (*ramsys_threadmain_t)(void *);
 
+/* a thread local storage destructor is called with a thread's value when
+ * the thread exits, so it has to use whatever calling convention the host
+ * expects. */
+#ifdef RAMSYS_WINDOWS
+#  define RAMSYS_TLSDTORDECL __stdcall
+#else
+#  define RAMSYS_TLSDTORDECL
+#endif
+typedef void (RAMSYS_TLSDTORDECL *ramsys_tlsdtor_t)(void *);
+
+/* reports how many bytes of the range from *start_arg* up to (but not
+ * including) *end_arg* belong to the caller (see ramsys_hugestats()). */
+typedef ram_reply_t (*ramsys_overlap_t)(size_t *bytes_arg, char *start_arg,
+      char *end_arg, void *context_arg);
+
 #endif /* RAMSYS_TYPES_H_IS_INCLUDED */
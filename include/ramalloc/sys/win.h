@@ -46,12 +46,13 @@
 
 #include <ramalloc/sys/types.h>
 #include <ramalloc/fail.h>
+#include <ramalloc/stdint.h>
 #include <Windows.h>
 
 typedef SSIZE_T ssize_t;
 
 typedef DWORD ramwin_tlskey_t;
-#define RAMWIN_NILTLSKEY TLS_OUT_OF_INDEXES
+#define RAMWIN_NILTLSKEY FLS_OUT_OF_INDEXES
 typedef CRITICAL_SECTION ramwin_mutex_t;
 typedef HANDLE ramwin_thread_t;
 typedef struct ramwin_barrier
@@ -66,14 +67,27 @@ ram_reply_t ramwin_initialize();
 ram_reply_t ramwin_pagesize(size_t *pagesz_arg);
 ram_reply_t ramwin_mmapgran(size_t *mmapgran_arg);
 ram_reply_t ramwin_cpucount(size_t *cpucount_arg);
+ram_reply_t ramwin_whichcpu(size_t *cpu_arg);
+ram_reply_t ramwin_clock(uint64_t *nsec_arg);
 ram_reply_t ramwin_commit(char *page_arg);
+ram_reply_t ramwin_commitrange(char *pages_arg, size_t size_arg);
 ram_reply_t ramwin_decommit(char *page_arg);
 ram_reply_t ramwin_reset(char *page_arg);
 ram_reply_t ramwin_reserve(char **pages_arg);
 ram_reply_t ramwin_bulkalloc(char **pages_arg);
 ram_reply_t ramwin_release(char *pages_arg);
-
-ram_reply_t ramwin_mktlskey(ramwin_tlskey_t *key_arg);
+ram_reply_t ramwin_reserverange(char **pages_arg, size_t size_arg);
+ram_reply_t ramwin_releaserange(char *pages_arg, size_t size_arg);
+ram_reply_t ramwin_maprange(char **pages_arg, size_t size_arg);
+ram_reply_t ramwin_remaprange(char **newpages_arg, char *pages_arg,
+      size_t oldsize_arg, size_t newsize_arg);
+ram_reply_t ramwin_hugepagesize(size_t *hugepgsz_arg);
+ram_reply_t ramwin_reservehuge(char **pages_arg);
+ram_reply_t ramwin_releasehuge(char *pages_arg);
+ram_reply_t ramwin_hugestats(size_t *regions_arg, size_t *backed_arg,
+      ramsys_overlap_t overlap_arg, void *context_arg);
+
+ram_reply_t ramwin_mktlskey(ramwin_tlskey_t *key_arg, ramsys_tlsdtor_t dtor_arg);
 ram_reply_t ramwin_rmtlskey(ramwin_tlskey_t key_arg);
 ram_reply_t ramwin_rcltls(void **value_arg, ramwin_tlskey_t key_arg);
 ram_reply_t ramwin_stotls(ramwin_tlskey_t key_arg, void *value_arg);
@@ -81,6 +95,8 @@ ram_reply_t ramwin_stotls(ramwin_tlskey_t key_arg, void *value_arg);
 ram_reply_t ramwin_mkmutex(ramwin_mutex_t *mutex_arg);
 ram_reply_t ramwin_rmmutex(ramwin_mutex_t *mutex_arg);
 ram_reply_t ramwin_waitformutex(ramwin_mutex_t *mutex_arg);
+ram_reply_t ramwin_trywaitformutex(int *successflag_arg,
+      ramwin_mutex_t *mutex_arg);
 ram_reply_t ramwin_quitmutex(ramwin_mutex_t *mutex_arg);
 
 ram_reply_t ramwin_mkthread(ramwin_thread_t *thread_arg, 
@@ -101,12 +117,25 @@ ram_reply_t ramwin_basename(char *dest_arg, size_t len_arg,
 #define ramsys_pagesize ramwin_pagesize
 #define ramsys_mmapgran ramwin_mmapgran
 #define ramsys_cpucount ramwin_cpucount
+#define ramsys_whichcpu ramwin_whichcpu
+/* timing */
+#define ramsys_clock ramwin_clock
 #define ramsys_reserve ramwin_reserve
 #define ramsys_commit ramwin_commit
+#define ramsys_commitrange ramwin_commitrange
 #define ramsys_decommit ramwin_decommit
 #define ramsys_reset ramwin_reset
 #define ramsys_bulkalloc ramwin_bulkalloc
 #define ramsys_release ramwin_release
+#define ramsys_reserverange ramwin_reserverange
+#define ramsys_releaserange ramwin_releaserange
+#define ramsys_maprange ramwin_maprange
+#define ramsys_remaprange ramwin_remaprange
+/* huge pages */
+#define ramsys_hugepagesize ramwin_hugepagesize
+#define ramsys_reservehuge ramwin_reservehuge
+#define ramsys_releasehuge ramwin_releasehuge
+#define ramsys_hugestats ramwin_hugestats
 /* thread local storage */
 typedef ramwin_tlskey_t ramsys_tlskey_t;
 #define ramsys_mktlskey ramwin_mktlskey
@@ -118,6 +147,7 @@ typedef ramwin_mutex_t ramsys_mutex_t;
 #define ramsys_mkmutex ramwin_mkmutex
 #define ramsys_rmmutex ramwin_rmmutex
 #define ramsys_waitformutex ramwin_waitformutex
+#define ramsys_trywaitformutex ramwin_trywaitformutex
 #define ramsys_quitmutex ramwin_quitmutex
 /* threads */
 typedef ramwin_thread_t ramsys_thread_t;
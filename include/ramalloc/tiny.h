@@ -0,0 +1,81 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#ifndef RAMTINY_H_IS_INCLUDED
+#define RAMTINY_H_IS_INCLUDED
+
+#include <ramalloc/fail.h>
+#include <ramalloc/want.h>
+
+/* the tiny object tier packs objects smaller than a pointer into pages of
+ * 1, 2 or 4 byte cells. a slot pool can't do this, since its free list is
+ * threaded through the slots themselves (and so are the lists that carry
+ * objects back to their home thread). instead, each page begins with a
+ * bitmap of its free cells, and the next cell is found with a bit scan.
+ *
+ * each thread allocates from a heap of its own. a cell discarded by
+ * another thread is marked in a second bitmap, with a compare-and-swap,
+ * and the page is queued on its heap so that the owner can merge it when
+ * it runs out of cells. the heap of a thread that exits is adopted by the
+ * next thread that needs one. */
+
+/* the largest request that's packed into a cell. */
+#define RAMTINY_MAXCELLSIZE 4
+
+typedef struct ramtiny_stats
+{
+   /* the number of pages the tier currently holds. */
+   size_t ramtinys_pages;
+   /* cells discarded by a thread other than their owner. */
+   size_t ramtinys_remote;
+   /* heaps that were adopted from exiting threads. */
+   size_t ramtinys_adoptions;
+} ramtiny_stats_t;
+
+ram_reply_t ramtiny_initialize();
+/* RAM_REPLY_RANGEFAIL is returned if *size_arg* is larger than
+ * RAMTINY_MAXCELLSIZE. */
+ram_reply_t ramtiny_acquire(void **newptr_arg, size_t size_arg);
+/* RAM_REPLY_NOTFOUND is returned if *ptr_arg* wasn't acquired with
+ * ramtiny_acquire(), so that the caller can try another allocator. */
+ram_reply_t ramtiny_release(void *ptr_arg);
+ram_reply_t ramtiny_query(size_t *size_arg, void *ptr_arg);
+/* merges the cells other threads have discarded into the calling thread's
+ * heap and returns its empty pages. */
+ram_reply_t ramtiny_flush();
+/* reports how many cells of *size_arg* bytes fit into a page. */
+ram_reply_t ramtiny_getcapacity(size_t *cells_arg, size_t size_arg);
+ram_reply_t ramtiny_getstats(ramtiny_stats_t *stats_arg);
+ram_reply_t ramtiny_chkheap();
+
+#endif /* RAMTINY_H_IS_INCLUDED */
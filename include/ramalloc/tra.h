@@ -35,23 +35,71 @@
 #define RAMTRA_H_IS_INCLUDED
 
 #include <ramalloc/fail.h>
-#include <ramalloc/mtx.h>
-#include <ramalloc/slst.h>
+#include <ramalloc/atom.h>
 
+typedef ram_reply_t (*ramtra_notify_t)(void *context_arg);
+
+/* a notifier asks the trash to call 'ramtran_func' whenever its depth
+ * climbs to 'ramtran_depth' items. the call is made on whichever thread
+ * pushed the item that crossed the threshold, so the function mustn't call
+ * back into the allocator. */
+typedef struct ramtra_notifier
+{
+   size_t ramtran_depth;
+   ramtra_notify_t ramtran_func;
+   void *ramtran_context;
+} ramtra_notifier_t;
+
+/* the trash is a multi-producer, single-consumer stack. any thread may
+ * push onto it but only the thread that owns it may pop, measure or
+ * enumerate it; other threads may only take the shared stack as a whole.
+ * items are linked through their first word. */
 typedef struct ramtra_trash
 {
-   rammtx_mutex_t ramtrat_mutex;
-   ramslst_slist_t ramtrat_items;
-   size_t ramtrat_size;
+   /* shared with other threads. */
+   void * volatile ramtrat_shared;
+   /* items that the owner has already taken from 'ramtrat_shared'. */
+   void *ramtrat_taken;
+   /* the number of items in both stacks. it can briefly lag behind the
+    * stacks themselves. */
+   ramatom_counter_t ramtrat_depth;
+   /* a 'const ramtra_notifier_t *' that producers consult after each
+    * push. the caller owns the storage. */
+   void * volatile ramtrat_notifier;
 } ramtra_trash_t;
 
+/* only the owner may use RAMTRA_ISEMPTY(). it costs a single load of the
+ * shared stack when the owner has nothing left of what it took. */
+#define RAMTRA_ISEMPTY(Trash) \
+   (NULL == (Trash)->ramtrat_taken && NULL == (Trash)->ramtrat_shared)
+
+/* RAMTRA_DEPTH() can be used from any thread but it's only a hint. */
+#define RAMTRA_DEPTH(Trash) ((Trash)->ramtrat_depth)
+
 typedef ram_reply_t (*ramtra_foreach_t)(void *ptr_arg, void *context_arg);
 
 ram_reply_t ramtra_mktrash(ramtra_trash_t *trash_arg);
 ram_reply_t ramtra_rmtrash(ramtra_trash_t *trash_arg);
 ram_reply_t ramtra_push(ramtra_trash_t *trash_arg, void *ptr_arg);
 ram_reply_t ramtra_pop(void **ptr_arg, ramtra_trash_t *trash_arg);
+/* takes everything on the shared stack at once, leaving alone whatever
+ * the owner has already taken with ramtra_pop(). unlike ramtra_pop(), any
+ * thread may take: the exchange leaves the taker holding a chain that
+ * nobody else can reach. the items are linked through their first word
+ * from *first_arg* to *last_arg*. */
+ram_reply_t ramtra_take(void **first_arg, void **last_arg, size_t *count_arg,
+      ramtra_trash_t *trash_arg);
+/* puts a chain of items that was taken with ramtra_take() back onto the
+ * shared stack. */
+ram_reply_t ramtra_give(ramtra_trash_t *trash_arg, void *first_arg,
+      void *last_arg, size_t count_arg);
+/* like RAMTRA_DEPTH(), the size can lag behind the stacks while other
+ * threads are pushing or taking. */
 ram_reply_t ramtra_size(size_t *size_arg, ramtra_trash_t *trash_arg);
 ram_reply_t ramtra_foreach(ramtra_trash_t *trash_arg, ramtra_foreach_t func_arg, void *context_arg);
+/* only the owner may set the notifier. passing NULL turns notification
+ * off. the notifier must remain valid for as long as other threads might
+ * push onto the trash. */
+ram_reply_t ramtra_notify(ramtra_trash_t *trash_arg, const ramtra_notifier_t *notifier_arg);
 
 #endif /* RAMTRA_H_IS_INCLUDED */
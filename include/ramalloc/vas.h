@@ -0,0 +1,58 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#ifndef RAMVAS_H_IS_INCLUDED
+#define RAMVAS_H_IS_INCLUDED
+
+#include <ramalloc/fail.h>
+#include <ramalloc/want.h>
+
+/* when RAM_WANT_PARTITIONED is enabled, the address space module reserves
+ * one contiguous range at initialization and divides it into
+ * RAMVAS_PARTITIONCOUNT partitions of 2^RAM_WANT_PARTITIONBITS bytes each.
+ * page pools that are confined to a partition take their reservations
+ * from it instead of from the system or the recycler, so an address can
+ * be attributed to a partition with a range check and a shift. */
+
+/* there's one partition for each mux size class. */
+#define RAMVAS_PARTITIONCOUNT 128
+
+ram_reply_t ramvas_initialize();
+/* *commitflag_arg* has the same meaning as it does for ramrcy_withdraw(). */
+ram_reply_t ramvas_withdraw(char **pages_arg, int *commitflag_arg,
+      size_t partition_arg);
+ram_reply_t ramvas_deposit(char *pages_arg, int commitflag_arg);
+/* reports RAM_REPLY_NOTFOUND for addresses outside of the range without
+ * reading anything at the address. */
+ram_reply_t ramvas_locate(size_t *partition_arg, const void *ptr_arg);
+
+#endif /* RAMVAS_H_IS_INCLUDED */
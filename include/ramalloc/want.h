@@ -151,8 +151,11 @@
  * @def RAM_WANT_MINPAGECAPACITY
  * @brief specifies the minimum page capacity.
  * @details the <b>minimum page capacity</b> places a constraint on the
- *    number of objects to allocate on a hardware page. it also influences
- *    the size of the largest object @e ramalloc will attempt to pool.
+ *    number of objects to allocate on a slab. objects too large to meet
+ *    it on a single hardware page are given slabs of 2, 4, 8 (and so on)
+ *    contiguous pages, up to @c RAMPG_MAXRUNLENGTH pages. it therefore
+ *    influences the size of the largest object @e ramalloc will attempt
+ *    to pool.
  * @remark you can customize this option using the CMake cache variable
  *    @c WANT_MINIMUM_PAGE_CAPACITY.
  * @todo
@@ -169,6 +172,192 @@
 #elif RAM_WANT_FEEDBACK
    RAMSYS_MESSAGE(the minimum page capacity is RAM_WANT_MINPAGECAPACITY objects.)
 #endif
+
+/**
+ * @def RAM_WANT_RESERVEPAGES
+ * @brief specifies how many pages to reserve at once (POSIX only).
+ * @details the <b>reservation size</b> is the number of hardware pages
+ *    @e ramalloc reserves with a single call to mmap(). pages are committed
+ *    individually from the reservation as they are needed, so a larger
+ *    reservation means fewer system calls and fewer mappings for the kernel
+ *    to keep track of at the expense of address space. if no preference is
+ *    specified, 128 pages will be reserved at a time.
+ * @remark Windows ignores this option, since its allocation granularity
+ *    already serves the same purpose.
+ * @remark a page pool node can keep track of at most 512 pages, so the
+ *    reservation size cannot exceed that.
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_RESERVE_PAGES.
+ */
+#ifndef RAM_WANT_RESERVEPAGES
+#  define RAM_WANT_RESERVEPAGES 128
+#endif
+#if RAM_WANT_RESERVEPAGES < 1
+#  error the reservation size cannot be less than 1 page.
+#elif RAM_WANT_RESERVEPAGES > 512
+#  error the reservation size cannot exceed 512 pages.
+#elif RAM_WANT_FEEDBACK
+   RAMSYS_MESSAGE(i will reserve RAM_WANT_RESERVEPAGES pages at a time.)
+#endif
+
+/**
+ * @def RAM_WANT_RECYCLECAPACITY
+ * @brief specifies how many empty reservations to recycle.
+ * @details the <b>recycler capacity</b> is the largest number of empty
+ *    page pool reservations @e ramalloc holds onto, rather than returning
+ *    them to the system, so that any page pool (in any thread) can reuse
+ *    them without a system call. @c 0 disables the recycler. if no
+ *    preference is specified, 16 reservations will be recycled.
+ * @remark the watermarks that govern how much of this capacity is actually
+ *    used can be adjusted at runtime with ramrcy_setwatermarks().
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_RECYCLE_CAPACITY.
+ */
+#ifndef RAM_WANT_RECYCLECAPACITY
+#  define RAM_WANT_RECYCLECAPACITY 16
+#endif
+#if RAM_WANT_RECYCLECAPACITY < 0
+#  error the recycler capacity cannot be negative.
+#elif RAM_WANT_RECYCLECAPACITY > 1024
+#  error the recycler capacity cannot exceed 1024 reservations.
+#elif RAM_WANT_FEEDBACK
+   RAMSYS_MESSAGE(i will recycle up to RAM_WANT_RECYCLECAPACITY reservations.)
+#endif
+
+/**
+ * @def RAM_WANT_LARGECACHEBYTES
+ * @brief specifies how many bytes of discarded large objects to cache.
+ * @details objects too large for any size class are given mappings of
+ *    their own. the <b>large object cache</b> holds onto mappings that
+ *    were recently discarded, rather than returning them to the system,
+ *    so that a subsequent acquisition of a similar size can reuse one
+ *    without a system call. this is the capacity, in bytes, of the cache
+ *    that's shared by every thread. @c 0 disables it. if no preference is
+ *    specified, 64 MiB will be cached.
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_LARGE_CACHE_BYTES.
+ */
+#ifndef RAM_WANT_LARGECACHEBYTES
+#  define RAM_WANT_LARGECACHEBYTES 67108864
+#endif
+#if RAM_WANT_LARGECACHEBYTES < 0
+#  error the large object cache capacity cannot be negative.
+#elif RAM_WANT_FEEDBACK
+   RAMSYS_MESSAGE(i will cache up to RAM_WANT_LARGECACHEBYTES bytes of large objects.)
+#endif
+
+/**
+ * @def RAM_WANT_LARGETHREADCACHEBYTES
+ * @brief specifies how many bytes of discarded large objects each thread
+ *    caches.
+ * @details each thread keeps a small cache of the large object mappings
+ *    it discarded most recently in front of the shared cache (see
+ *    @ref RAM_WANT_LARGECACHEBYTES), so that it doesn't have to contend
+ *    for a lock to reuse one. mappings that don't fit are passed on to the
+ *    shared cache. @c 0 disables it. if no preference is specified, 4 MiB
+ *    will be cached by each thread.
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_LARGE_THREAD_CACHE_BYTES.
+ */
+#ifndef RAM_WANT_LARGETHREADCACHEBYTES
+#  define RAM_WANT_LARGETHREADCACHEBYTES 4194304
+#endif
+#if RAM_WANT_LARGETHREADCACHEBYTES < 0
+#  error the per-thread large object cache capacity cannot be negative.
+#elif RAM_WANT_FEEDBACK
+   RAMSYS_MESSAGE(each thread will cache up to RAM_WANT_LARGETHREADCACHEBYTES bytes of large objects.)
+#endif
+
+/**
+ * @def RAM_WANT_TINYCELLS
+ * @brief pack sub-word objects into cells.
+ * @details @c RAM_WANT_TINYCELLS=1 specifies that requests for 1, 2, 3
+ *    or 4 bytes should be satisfied from pages of 1, 2 or 4 byte cells,
+ *    with a bitmap standing in for the free list, rather than from the
+ *    smallest size class (which can't be smaller than a pointer). if no
+ *    preference is specified, tiny cells are enabled.
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_TINY_CELLS.
+ */
+#ifndef RAM_WANT_TINYCELLS
+#  define RAM_WANT_TINYCELLS 1
+#endif
+#if RAM_WANT_FEEDBACK && RAM_WANT_TINYCELLS
+   RAMSYS_MESSAGE(objects of 4 bytes or less will be packed into cells.)
+#endif
+
+/**
+ * @def RAM_WANT_PARTITIONED
+ * @brief partition the address space by size class.
+ * @details @c RAM_WANT_PARTITIONED=1 specifies that @e ramalloc should
+ *    reserve one contiguous range of address space when it's initialized
+ *    and divide it into a partition for each size class. the size of an
+ *    object (and whether @e ramalloc allocated it at all) can then be
+ *    determined from its address alone, which makes inquiring about
+ *    memory from another allocator nearly free.
+ * @remark gluttonous pools can't be confined to a partition, so they're
+ *    unsupported in this mode.
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_PARTITIONED.
+ */
+#ifndef RAM_WANT_PARTITIONED
+#  define RAM_WANT_PARTITIONED 0
+#endif
+#if RAM_WANT_FEEDBACK && RAM_WANT_PARTITIONED
+   RAMSYS_MESSAGE(the address space will be partitioned by size class.)
+#endif
+
+/**
+ * @def RAM_WANT_PARTITIONBITS
+ * @brief specifies the size of each partition.
+ * @details the <b>partition size</b> is the amount of address space set
+ *    aside for each size class when @c RAM_WANT_PARTITIONED is enabled,
+ *    expressed as a power of two. if no preference is specified, each
+ *    partition will be 4 GiB (2^32 bytes).
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_PARTITION_BITS.
+ */
+#ifndef RAM_WANT_PARTITIONBITS
+#  define RAM_WANT_PARTITIONBITS 32
+#endif
+#if RAM_WANT_PARTITIONBITS < 20
+#  error the partition size cannot be less than 2^20 bytes.
+#elif RAM_WANT_PARTITIONBITS > 40
+#  error the partition size cannot exceed 2^40 bytes.
+#elif RAM_WANT_FEEDBACK && RAM_WANT_PARTITIONED
+   RAMSYS_MESSAGE(each partition will be 2^RAM_WANT_PARTITIONBITS bytes.)
+#endif
+
+/**
+ * @def RAM_WANT_COMPILERTLS
+ * @brief find each thread's pool with the compiler's thread-local storage.
+ * @details @c RAM_WANT_COMPILERTLS=1 specifies that @e ramalloc should
+ *    remember the pool a thread used last in a thread-local variable
+ *    declared with the compiler's storage class (e.g. @c __thread), so
+ *    that finding it costs a single load relative to the thread pointer
+ *    instead of a call into the threading library. the threading library's
+ *    key is still used to orphan a thread's pool when the thread exits.
+ *    if no preference is specified, this is enabled whenever the compiler
+ *    supports it.
+ * @remark the initial-exec model that's used with @e gcc assumes that
+ *    @e ramalloc is linked into the executable (or a library loaded at
+ *    startup). disable this option if you intend to load it with
+ *    @c dlopen().
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_COMPILER_TLS.
+ */
+#ifndef RAM_WANT_COMPILERTLS
+#  ifdef RAMSYS_THREADLOCAL
+#     define RAM_WANT_COMPILERTLS 1
+#  else
+#     define RAM_WANT_COMPILERTLS 0
+#  endif
+#endif
+#if RAM_WANT_COMPILERTLS && !defined(RAMSYS_THREADLOCAL)
+#  error this compiler has no thread-local storage class that i know of.
+#elif RAM_WANT_FEEDBACK && RAM_WANT_COMPILERTLS
+   RAMSYS_MESSAGE(the compiler's thread-local storage will be used to find each thread's pool.)
+#endif
 /**
  * @def RAM_WANT_DEFAULTAPPETITE
  * @brief the default appetite.
@@ -186,7 +375,8 @@
  * @def RAM_WANT_DEFAULTRECLAIMGOAL
  * @brief the default reclamation goal.
  * @details the <b>default reclamation goal</b> is the number of trashed
- *    pointers a lazy pool should reclaim per allocation request.
+ *    pointers a lazy pool should reclaim per allocation request while the
+ *    trash isn't growing.
  * @remark you can customize this option using the CMake cache variable
  *    @c WANT_DEFAULT_RECLAIM_GOAL.
  */
@@ -198,6 +388,24 @@
 #elif RAM_WANT_FEEDBACK
    RAMSYS_MESSAGE(the default reclamation goal is RAM_WANT_DEFAULTRECLAIMGOAL objects.)
 #endif
+/**
+ * @def RAM_WANT_DEFAULTRECLAIMLIMIT
+ * @brief the default limit on the reclamation goal.
+ * @details a lazy pool raises its reclamation goal while other threads
+ *    fill its trash faster than it allocates. the <b>default reclamation
+ *    limit</b> is as high as the goal is allowed to go, which bounds the
+ *    work done by a single allocation request.
+ * @remark you can customize this option using the CMake cache variable
+ *    @c WANT_DEFAULT_RECLAIM_LIMIT.
+ */
+#ifndef RAM_WANT_DEFAULTRECLAIMLIMIT
+#  define RAM_WANT_DEFAULTRECLAIMLIMIT 64
+#endif
+#if RAM_WANT_DEFAULTRECLAIMLIMIT < RAM_WANT_DEFAULTRECLAIMGOAL
+#  error the default reclamation limit cannot be less than the default reclamation goal.
+#elif RAM_WANT_FEEDBACK
+   RAMSYS_MESSAGE(the default reclamation limit is RAM_WANT_DEFAULTRECLAIMLIMIT objects.)
+#endif
 
 /**
  * @def RAM_WANT_NPTLDEADLOCK
@@ -34,49 +34,65 @@
  */
 
 #include <ramalloc/algn.h>
-#include <ramalloc/foot.h>
+#include <ramalloc/own.h>
+#include <ramalloc/mem.h>
 #include <ramalloc/want.h>
 #include <ramalloc/sys.h>
 #include <ramalloc/cast.h>
 #include <assert.h>
 #include <memory.h>
 
+/* a slab (the run of pages that a node describes) may leave at most
+ * 1/RAMALGN_MAXTAILWASTE of its space unused. */
+#define RAMALGN_MAXTAILWASTE 8
+
+struct ramalgn_snode;
+
 typedef struct ramalgn_node
 {
    ramslot_node_t ramalgnn_slotnode;
+   /* the node storage that this node was acquired from. */
+   struct ramalgn_snode *ramalgnn_snode;
 } ramalgn_node_t;
 
-typedef struct ramalgn_footer
+typedef struct ramalgn_snode
 {
-   /* in an aligned pool, the node is stored directly in the footer. */
-   ramalgn_node_t ramalgnf_node;
-} ramalgn_footer_t;
+   ramslot_node_t ramalgnsn_slotnode;
+   ramalgn_node_t ramalgnsn_nodes[];
+} ramalgn_snode_t;
 
 typedef struct ramalgn_globals
 {
-   ramfoot_spec_t ramalgng_footerspec;
+   size_t ramalgng_pagesize;
    int ramalgng_initflag;
 } ramalgn_globals_t;
 
 static ram_reply_t ramalgn_mkpool2(ramalgn_pool_t *pool_arg, rampg_appetite_t appetite_arg, 
    size_t granularity_arg, const ramalgn_tag_t *tag_arg);
+static ram_reply_t ramalgn_setowner(const ramalgn_pool_t *pool_arg, char *slab_arg,
+   ramalgn_node_t *node_arg);
 static ram_reply_t ramalgn_findnode(ramalgn_node_t **node_arg, char *ptr_arg);
 static ram_reply_t ramalgn_mknode(ramslot_node_t **node_arg, void **slots_arg, ramslot_pool_t *pool_arg);
 static ram_reply_t ramalgn_mknode2(ramalgn_node_t **node_arg, ramalgn_pool_t *pool_arg, char *page_arg);
 static ram_reply_t ramalgn_rmnode(ramslot_node_t *node_arg);
+static ram_reply_t ramalgn_mksnode(ramslot_node_t **node_arg, void **slots_arg, ramslot_pool_t *pool_arg);
+static ram_reply_t ramalgn_rmsnode(ramslot_node_t *node_arg);
+static ram_reply_t ramalgn_initslot(void *slot_arg, ramslot_node_t *node_arg);
 
 static ramalgn_globals_t ramalgn_theglobals;
+/* the ownership map associates each page in use by an aligned pool with
+ * its node. */
+static ramown_map_t ramalgn_theownmap;
 
 ram_reply_t ramalgn_initialize()
 {
    if (!ramalgn_theglobals.ramalgng_initflag)
    {
       ramalgn_globals_t stage = {0};
-      size_t writezone = 0;
 
-      /* the page pool's granularity is my writable zone. */
-      RAM_FAIL_TRAP(rampg_getgranularity(&writezone));
-      RAMFOOT_MKSPEC(&stage.ramalgng_footerspec, ramalgn_footer_t, writezone, "ALIG");
+      /* the page pool's granularity is the space i have to work with in
+       * each page. */
+      RAM_FAIL_TRAP(rampg_getgranularity(&stage.ramalgng_pagesize));
       stage.ramalgng_initflag = 1;
 
       ramalgn_theglobals = stage;
@@ -104,19 +120,54 @@ ram_reply_t ramalgn_mkpool2(ramalgn_pool_t *pool_arg, rampg_appetite_t appetite_
    size_t granularity_arg, const ramalgn_tag_t *tag_arg)
 {
    size_t capacity = 0;
+   size_t snodecapacity = 0;
+   size_t slabpages = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
 
    assert(pool_arg != NULL);
    RAM_FAIL_NOTZERO(granularity_arg);
    assert(ramalgn_theglobals.ramalgng_initflag);
 
    RAM_FAIL_TRAP(rampg_mkpool(&pool_arg->ramalgnp_pgpool, appetite_arg));
-   capacity = ramalgn_theglobals.ramalgng_footerspec.footer_offset / granularity_arg;
-   /* if the capacity doesn't meet certain requirements, then i must inform the caller. */
-   /* TODO: why is the slot capacity limit tested here and not in ramslot_mkpool()? */
-   if (RAM_WANT_MINPAGECAPACITY > capacity || RAMSLOT_MAXCAPACITY < capacity)
-      return RAM_REPLY_RANGEFAIL;
+   /* if no slab meets my requirements, then i must inform the caller. */
+   e = ramalgn_calcslab(&slabpages, &capacity, granularity_arg,
+         pool_arg->ramalgnp_pgpool.rampgp_vpool.ramvecvp_nodecapacity);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+   if (slabpages > 1)
+   {
+      /* ramalgn_calcslab() only chooses runs that divide a reservation,
+       * so a refusal here means that the page pool has other limits. */
+      e = rampg_setrunlength(&pool_arg->ramalgnp_pgpool, slabpages);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_RANGEFAIL:
+         return e;
+      case RAM_REPLY_OK:
+         break;
+      }
+   }
    RAM_FAIL_TRAP(ramslot_mkpool(&pool_arg->ramalgnp_slotpool, granularity_arg, 
       capacity, &ramalgn_mknode, &ramalgn_rmnode, NULL));
+   /* my nodes don't live in the pages they describe, so i keep them in
+    * page-sized chunks of their own. */
+   snodecapacity = (ramalgn_theglobals.ramalgng_pagesize - sizeof(ramalgn_snode_t))
+         / sizeof(ramalgn_node_t);
+   RAM_FAIL_TRAP(ramslot_mkpool(&pool_arg->ramalgnp_nodepool, sizeof(ramalgn_node_t),
+      snodecapacity, &ramalgn_mksnode, &ramalgn_rmsnode, &ramalgn_initslot));
    if (tag_arg)
       pool_arg->ramalgnp_tag = *tag_arg;
    else
@@ -125,6 +176,132 @@ ram_reply_t ramalgn_mkpool2(ramalgn_pool_t *pool_arg, rampg_appetite_t appetite_
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramalgn_rmpool(ramalgn_pool_t *pool_arg)
+{
+   int emptyflag = 0;
+
+   RAM_FAIL_NOTNULL(pool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramalgn_theglobals.ramalgng_initflag);
+
+   /* the caller is expected to try again later. */
+   RAM_FAIL_TRAP(ramalgn_isempty(&emptyflag, pool_arg));
+   if (!emptyflag)
+      return RAM_REPLY_DISALLOWED;
+   /* pages held in reserve are all that remains. */
+   RAM_FAIL_TRAP(rampg_reserve(&pool_arg->ramalgnp_pgpool, 0));
+   memset(pool_arg, 0, sizeof(*pool_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_isempty(int *emptyflag_arg, const ramalgn_pool_t *pool_arg)
+{
+   int hastail = 0;
+
+   RAM_FAIL_NOTNULL(emptyflag_arg);
+   *emptyflag_arg = 0;
+   RAM_FAIL_NOTNULL(pool_arg);
+
+   /* a slab is given back as soon as its last object is released, so any
+    * slab that's left still has objects in use. */
+   RAM_FAIL_TRAP(ramlist_hastail(&hastail,
+         &pool_arg->ramalgnp_slotpool.ramslotp_vpool.ramvecvp_inv));
+
+   *emptyflag_arg = !hastail;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_calcslab(size_t *pages_arg, size_t *capacity_arg,
+   size_t granularity_arg, size_t reservation_arg)
+{
+   size_t pages = 0;
+   size_t maxpages = 0;
+   size_t slabsz = 0;
+   size_t capacity = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = 0;
+   RAM_FAIL_NOTNULL(capacity_arg);
+   *capacity_arg = 0;
+   RAM_FAIL_NOTZERO(granularity_arg);
+   RAM_FAIL_NOTZERO(reservation_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramalgn_theglobals.ramalgng_initflag);
+
+   /* a slab has to divide the reservation evenly (see
+    * rampg_setrunlength()), which confines me to the largest power of two
+    * that divides it. */
+   for (maxpages = 1; maxpages < RAMPG_MAXRUNLENGTH
+         && 0 == reservation_arg % (maxpages * 2); maxpages *= 2)
+      continue;
+
+   /* i choose the smallest slab of 2^k pages that holds at least
+    * RAM_WANT_MINPAGECAPACITY objects without wasting too much of its
+    * tail. objects small enough to meet the minimum capacity on a single
+    * page always do so, since the tail is smaller than an object. */
+   for (pages = 1; pages <= maxpages; pages *= 2)
+   {
+      slabsz = ramalgn_theglobals.ramalgng_pagesize * pages;
+      capacity = slabsz / granularity_arg;
+      /* TODO: why is the slot capacity limit tested here and not in ramslot_mkpool()? */
+      if (RAMSLOT_MAXCAPACITY < capacity)
+         return RAM_REPLY_RANGEFAIL;
+      if (RAM_WANT_MINPAGECAPACITY <= capacity &&
+            (slabsz - capacity * granularity_arg) * RAMALGN_MAXTAILWASTE <= slabsz)
+      {
+         *pages_arg = pages;
+         *capacity_arg = capacity;
+         return RAM_REPLY_OK;
+      }
+   }
+
+   /* if it was the reservation, rather than RAMPG_MAXRUNLENGTH, that cut
+    * my search short, i settle for the longest slab it permits, so long as
+    * that slab holds something. a size class that an unusual reservation
+    * would otherwise take away is worth the waste. */
+   if (maxpages < RAMPG_MAXRUNLENGTH && capacity > 0)
+   {
+      *pages_arg = maxpages;
+      *capacity_arg = capacity;
+      return RAM_REPLY_OK;
+   }
+
+   return RAM_REPLY_RANGEFAIL;
+}
+
+ram_reply_t ramalgn_setowner(const ramalgn_pool_t *pool_arg, char *slab_arg,
+   ramalgn_node_t *node_arg)
+{
+   size_t i = 0;
+   size_t pages = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(pool_arg != NULL);
+   assert(slab_arg != NULL);
+   assert(ramalgn_theglobals.ramalgng_initflag);
+
+   /* every page of a slab refers to its node, so that an object that
+    * begins on an interior page can find it. */
+   pages = pool_arg->ramalgnp_pgpool.rampgp_runlength;
+   for (i = 0; i < pages; ++i)
+   {
+      e = ramown_set(&ramalgn_theownmap,
+            slab_arg + i * ramalgn_theglobals.ramalgng_pagesize, node_arg);
+      if (RAM_REPLY_OK != e)
+      {
+         /* clearing an entry that i've already set can't fail. */
+         while (i > 0)
+         {
+            --i;
+            RAM_FAIL_PANIC(ramown_set(&ramalgn_theownmap,
+                  slab_arg + i * ramalgn_theglobals.ramalgng_pagesize, NULL));
+         }
+         return e;
+      }
+   }
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramalgn_acquire(void **ptr_arg, ramalgn_pool_t *pool_arg)
 {
    RAM_FAIL_NOTNULL(ptr_arg);
@@ -149,16 +326,65 @@ ram_reply_t ramalgn_release(void *ptr_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramalgn_gettoken(void **token_arg, void *ptr_arg)
+{
+   ramalgn_node_t *node = NULL;
+
+   RAM_FAIL_NOTNULL(token_arg);
+   *token_arg = NULL;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramalgn_theglobals.ramalgng_initflag);
+
+   RAM_FAIL_TRAP(ramalgn_findnode(&node, (char *)ptr_arg));
+   RAM_FAIL_TRAP(ramslot_gettoken(token_arg, &node->ramalgnn_slotnode));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_reserve(ramalgn_pool_t *pool_arg, size_t count_arg)
+{
+   size_t capacity = 0;
+   char *page = NULL;
+
+   RAM_FAIL_NOTNULL(pool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramalgn_theglobals.ramalgng_initflag);
+
+   /* each slab holds a fixed number of objects, so i need enough slabs to
+    * cover the count requested. */
+   capacity = pool_arg->ramalgnp_slotpool.ramslotp_vpool.ramvecvp_nodecapacity;
+   assert(capacity > 0);
+   RAM_FAIL_TRAP(rampg_reserve(&pool_arg->ramalgnp_pgpool,
+         (count_arg + capacity - 1) / capacity));
+   /* the ownership map grows on demand, so i make sure it already has room
+    * for the pages held in reserve. */
+   for (page = pool_arg->ramalgnp_pgpool.rampgp_reserve; NULL != page;
+         page = *(char **)page)
+   {
+      RAM_FAIL_TRAP(ramalgn_setowner(pool_arg, page, NULL));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_confine(ramalgn_pool_t *pool_arg, size_t partition_arg)
+{
+   RAM_FAIL_NOTNULL(pool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramalgn_theglobals.ramalgng_initflag);
+
+   RAM_FAIL_TRAP(rampg_confine(&pool_arg->ramalgnp_pgpool, partition_arg));
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramalgn_findnode(ramalgn_node_t **node_arg, char *ptr_arg)
 {
-   ramalgn_footer_t *foot = NULL;
+   void *node = NULL;
    ram_reply_t e = RAM_REPLY_INSANE;
 
    assert(node_arg != NULL);
    assert(ptr_arg != NULL);
    assert(ramalgn_theglobals.ramalgng_initflag);
 
-   e = ramfoot_getstorage((void **)&foot, &ramalgn_theglobals.ramalgng_footerspec, ptr_arg);
+   e = ramown_get(&node, &ramalgn_theownmap, ptr_arg);
    switch (e)
    {
    default:
@@ -171,7 +397,7 @@ ram_reply_t ramalgn_findnode(ramalgn_node_t **node_arg, char *ptr_arg)
       break;
    }
 
-   *node_arg = &foot->ramalgnf_node;
+   *node_arg = (ramalgn_node_t *)node;
    return RAM_REPLY_OK;
 }
 
@@ -182,6 +408,7 @@ ram_reply_t ramalgn_chkpool(const ramalgn_pool_t *pool_arg)
 
    RAM_FAIL_TRAP(rampg_chkpool(&pool_arg->ramalgnp_pgpool));
    RAM_FAIL_TRAP(ramslot_chkpool(&pool_arg->ramalgnp_slotpool));
+   RAM_FAIL_TRAP(ramslot_chkpool(&pool_arg->ramalgnp_nodepool));
 
    return RAM_REPLY_OK;
 }
@@ -218,7 +445,8 @@ ram_reply_t ramalgn_mknode(ramslot_node_t **node_arg, void **slots_arg, ramslot_
 
 ram_reply_t ramalgn_mknode2(ramalgn_node_t **node_arg, ramalgn_pool_t *pool_arg, char *page_arg)
 {
-   ramalgn_footer_t *foot = NULL;
+   ramalgn_node_t *node = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(node_arg);
    *node_arg = NULL;
@@ -226,21 +454,80 @@ ram_reply_t ramalgn_mknode2(ramalgn_node_t **node_arg, ramalgn_pool_t *pool_arg,
    RAM_FAIL_NOTNULL(page_arg);
    assert(ramalgn_theglobals.ramalgng_initflag);
 
-   /* i need to write a footer to the page to ensure that i can get to the pool
-    * given any address of of the page. */
-   RAM_FAIL_TRAP(ramfoot_mkfooter((void **)&foot,
-      &ramalgn_theglobals.ramalgng_footerspec, page_arg));
-   *node_arg = &foot->ramalgnf_node;
+   RAM_FAIL_TRAP(ramslot_acquire((void **)&node, &pool_arg->ramalgnp_nodepool));
+   /* i need to record the slab's node in the ownership map to ensure that i
+    * can get to the pool given any address of the slab. */
+   e = ramalgn_setowner(pool_arg, page_arg, node);
+   if (RAM_REPLY_OK != e)
+   {
+      RAM_FAIL_PANIC(ramslot_release(node, &node->ramalgnn_snode->ramalgnsn_slotnode));
+      return e;
+   }
 
+   *node_arg = node;
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramalgn_rmnode(ramslot_node_t *node_arg)
 {
+   ramalgn_node_t *node = NULL;
+   ramslot_pool_t *spool = NULL;
+   char *page = NULL;
+
+   RAM_FAIL_NOTNULL(node_arg);
+   assert(ramalgn_theglobals.ramalgng_initflag);
+
+   node = RAM_CAST_STRUCTBASE(ramalgn_node_t, ramalgnn_slotnode, node_arg);
+   spool = RAM_CAST_STRUCTBASE(ramslot_pool_t, ramslotp_vpool,
+         node_arg->ramslotn_vnode.ramvecn_vpool);
+   page = node_arg->ramslotn_slots;
+   RAM_FAIL_TRAP(ramalgn_setowner(
+         RAM_CAST_STRUCTBASE(ramalgn_pool_t, ramalgnp_slotpool, spool), page, NULL));
+   RAM_FAIL_TRAP(ramslot_release(node, &node->ramalgnn_snode->ramalgnsn_slotnode));
+   RAM_FAIL_TRAP(rampg_release(page));
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_mksnode(ramslot_node_t **node_arg, void **slots_arg, ramslot_pool_t *pool_arg)
+{
+   ramalgn_snode_t *snode = NULL;
+
+   RAM_FAIL_NOTNULL(node_arg);
+   *node_arg = NULL;
+   RAM_FAIL_NOTNULL(slots_arg);
+   *slots_arg = NULL;
+   RAM_FAIL_NOTNULL(pool_arg);
+   assert(ramalgn_theglobals.ramalgng_initflag);
+
+   snode = rammem_supmalloc(ramalgn_theglobals.ramalgng_pagesize);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != snode);
+   *slots_arg = snode->ramalgnsn_nodes;
+   *node_arg = &snode->ramalgnsn_slotnode;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_rmsnode(ramslot_node_t *node_arg)
+{
+   ramalgn_snode_t *snode = NULL;
+
    RAM_FAIL_NOTNULL(node_arg);
    assert(ramalgn_theglobals.ramalgng_initflag);
 
-   RAM_FAIL_TRAP(rampg_release(node_arg->ramslotn_slots));
+   snode = RAM_CAST_STRUCTBASE(ramalgn_snode_t, ramalgnsn_slotnode, node_arg);
+   rammem_supfree(snode);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramalgn_initslot(void *slot_arg, ramslot_node_t *node_arg)
+{
+   RAM_FAIL_NOTNULL(slot_arg);
+   RAM_FAIL_NOTNULL(node_arg);
+   assert(ramalgn_theglobals.ramalgng_initflag);
+
+   ((ramalgn_node_t *)slot_arg)->ramalgnn_snode =
+         RAM_CAST_STRUCTBASE(ramalgn_snode_t, ramalgnsn_slotnode, node_arg);
+
    return RAM_REPLY_OK;
 }
 
@@ -278,6 +565,24 @@ ram_reply_t ramalgn_query(ramalgn_pool_t **apool_arg, void *ptr_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramalgn_querytoken(ramalgn_pool_t **apool_arg, void *token_arg)
+{
+   ramslot_node_t *snode = NULL;
+   ramslot_pool_t *spool = NULL;
+
+   RAM_FAIL_NOTNULL(apool_arg);
+   *apool_arg = NULL;
+   RAM_FAIL_NOTNULL(token_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramalgn_theglobals.ramalgng_initflag);
+
+   RAM_FAIL_TRAP(ramslot_gettokennode(&snode, token_arg));
+   spool = RAM_CAST_STRUCTBASE(ramslot_pool_t, ramslotp_vpool,
+         snode->ramslotn_vnode.ramvecn_vpool);
+   *apool_arg = RAM_CAST_STRUCTBASE(ramalgn_pool_t, ramalgnp_slotpool, spool);
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramalgn_gettag(const ramalgn_tag_t **tag_arg, const ramalgn_pool_t *apool_arg)
 {
    RAM_FAIL_NOTNULL(tag_arg);
@@ -300,3 +605,19 @@ ram_reply_t ramalgn_getgranularity(size_t *granularity_arg, const ramalgn_pool_t
 
    return RAM_REPLY_OK;
 }
+
+ram_reply_t ramalgn_getslabsize(size_t *pages_arg, size_t *capacity_arg,
+   const ramalgn_pool_t *apool_arg)
+{
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = 0;
+   RAM_FAIL_NOTNULL(capacity_arg);
+   *capacity_arg = 0;
+   RAM_FAIL_NOTNULL(apool_arg);
+   assert(ramalgn_theglobals.ramalgng_initflag);
+
+   *pages_arg = apool_arg->ramalgnp_pgpool.rampgp_runlength;
+   *capacity_arg = apool_arg->ramalgnp_slotpool.ramslotp_vpool.ramvecvp_nodecapacity;
+
+   return RAM_REPLY_OK;
+}
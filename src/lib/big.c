@@ -0,0 +1,686 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include <ramalloc/big.h>
+#include <ramalloc/atom.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/mtx.h>
+#include <ramalloc/own.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/tls.h>
+#include <ramalloc/stdint.h>
+#include <assert.h>
+#include <string.h>
+
+/* a cached mapping can satisfy a request that's up to 1/RAMBIG_MAXSLACK
+ * smaller than itself. the same tolerance allows a resize to shrink an
+ * object in place. */
+#define RAMBIG_MAXSLACK 8
+
+/* a block describes a mapping. it's kept outside of the mapping, so that
+ * the object can begin on a page boundary and a mapping that's sitting in
+ * a cache isn't touched. */
+typedef struct rambig_block
+{
+   char *rambigb_pages;
+   /* the size of the mapping, which is always a whole number of pages. */
+   size_t rambigb_size;
+   /* links the block into a cache while it isn't in use. */
+   struct rambig_block *rambigb_next;
+   struct rambig_block *rambigb_prev;
+} rambig_block_t;
+
+typedef struct rambig_cache
+{
+   /* the block discarded most recently is at the head of the list, so
+    * blocks are evicted from the tail. */
+   rambig_block_t *rambigc_head;
+   rambig_block_t *rambigc_tail;
+   size_t rambigc_bytes;
+   size_t rambigc_capacity;
+} rambig_cache_t;
+
+typedef struct rambig_globals
+{
+   /* only the first page of each mapping that's in use is in the map. */
+   ramown_map_t rambigg_map;
+   /* the shared cache is protected by the mutex. */
+   rambig_cache_t rambigg_cache;
+   rammtx_mutex_t rambigg_mutex;
+   /* the key refers to the calling thread's cache. */
+   ramtls_key_t rambigg_tlskey;
+   size_t rambigg_pagesize;
+   ramatom_counter_t rambigg_live;
+   ramatom_counter_t rambigg_hits;
+   ramatom_counter_t rambigg_misses;
+   ramatom_counter_t rambigg_remaps;
+   ramatom_counter_t rambigg_unmaps;
+   int rambigg_initflag;
+} rambig_globals_t;
+
+static ram_reply_t rambig_roundup(size_t *rounded_arg, size_t size_arg);
+static ram_reply_t rambig_find(rambig_block_t **block_arg, void *ptr_arg);
+static ram_reply_t rambig_withdraw(rambig_block_t **block_arg,
+      size_t size_arg);
+static ram_reply_t rambig_deposit(rambig_block_t *block_arg);
+static ram_reply_t rambig_share(rambig_block_t *block_arg);
+static ram_reply_t rambig_take(rambig_block_t **block_arg,
+      rambig_cache_t *cache_arg, size_t size_arg);
+static void rambig_push(rambig_cache_t *cache_arg, rambig_block_t *block_arg);
+static void rambig_unlink(rambig_cache_t *cache_arg,
+      rambig_block_t *block_arg);
+static void rambig_evict(rambig_block_t **chain_arg,
+      rambig_cache_t *cache_arg, size_t capacity_arg);
+static ram_reply_t rambig_unmap(rambig_block_t *chain_arg);
+static ram_reply_t rambig_mkblock(rambig_block_t **block_arg,
+      size_t size_arg);
+static ram_reply_t rambig_remap(rambig_block_t *block_arg, size_t size_arg);
+static ram_reply_t rambig_rcltls(rambig_cache_t **cache_arg,
+      int createflag_arg);
+static void RAMSYS_TLSDTORDECL rambig_orphan(void *cache_arg);
+static ram_reply_t rambig_orphan2(rambig_cache_t *cache_arg);
+
+static rambig_globals_t rambig_theglobals;
+
+ram_reply_t rambig_initialize()
+{
+   if (!rambig_theglobals.rambigg_initflag)
+   {
+      RAM_FAIL_TRAP(rammem_pagesize(&rambig_theglobals.rambigg_pagesize));
+      RAM_FAIL_TRAP(rammtx_mkmutex(&rambig_theglobals.rambigg_mutex));
+      RAM_FAIL_TRAP(ramtls_mkkey(&rambig_theglobals.rambigg_tlskey,
+            &rambig_orphan));
+      rambig_theglobals.rambigg_cache.rambigc_capacity =
+            RAM_WANT_LARGECACHEBYTES;
+      rambig_theglobals.rambigg_initflag = 1;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_acquire(void **newptr_arg, size_t size_arg)
+{
+   rambig_block_t *block = NULL;
+   size_t sz = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(newptr_arg);
+   *newptr_arg = NULL;
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         rambig_theglobals.rambigg_initflag);
+
+   e = rambig_roundup(&sz, size_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   e = rambig_withdraw(&block, sz);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      ramatom_xadd(&rambig_theglobals.rambigg_misses, 1);
+      RAM_FAIL_TRAP(rambig_mkblock(&block, sz));
+      break;
+   case RAM_REPLY_OK:
+      ramatom_xadd(&rambig_theglobals.rambigg_hits, 1);
+      break;
+   }
+
+   e = ramown_set(&rambig_theglobals.rambigg_map, block->rambigb_pages,
+         block);
+   if (RAM_REPLY_OK != e)
+   {
+      RAM_FAIL_TRAP(rambig_unmap(block));
+      return e;
+   }
+
+   ramatom_xadd(&rambig_theglobals.rambigg_live, 1);
+   *newptr_arg = block->rambigb_pages;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_release(void *ptr_arg)
+{
+   rambig_block_t *block = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(ptr_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         rambig_theglobals.rambigg_initflag);
+
+   e = rambig_find(&block, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   /* the block has to leave the map before anyone else can see it in a
+    * cache. */
+   RAM_FAIL_TRAP(ramown_set(&rambig_theglobals.rambigg_map,
+         block->rambigb_pages, NULL));
+   ramatom_xadd(&rambig_theglobals.rambigg_live, -1);
+   RAM_FAIL_TRAP(rambig_deposit(block));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_resize(void **newptr_arg, void *ptr_arg, size_t size_arg)
+{
+   rambig_block_t *block = NULL;
+   size_t sz = 0;
+   void *p = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(newptr_arg);
+   *newptr_arg = NULL;
+   RAM_FAIL_NOTNULL(ptr_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         rambig_theglobals.rambigg_initflag);
+
+   RAM_FAIL_TRAP(rambig_find(&block, ptr_arg));
+   e = rambig_roundup(&sz, size_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   /* if the mapping is already large enough, and not much larger than it
+    * needs to be, i leave it alone. */
+   if (sz <= block->rambigb_size && sz >= block->rambigb_size -
+         block->rambigb_size / RAMBIG_MAXSLACK)
+   {
+      *newptr_arg = ptr_arg;
+      return RAM_REPLY_OK;
+   }
+
+   e = rambig_remap(block, sz);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_OK:
+      ramatom_xadd(&rambig_theglobals.rambigg_remaps, 1);
+      *newptr_arg = block->rambigb_pages;
+      return RAM_REPLY_OK;
+   case RAM_REPLY_UNSUPPORTED:
+   case RAM_REPLY_RESOURCEFAIL:
+      /* the system can't move the mapping for me, so i have to copy it. */
+      break;
+   }
+
+   RAM_FAIL_TRAP(rambig_acquire(&p, sz));
+   memcpy(p, ptr_arg, sz < block->rambigb_size ? sz : block->rambigb_size);
+   RAM_FAIL_TRAP(rambig_release(ptr_arg));
+
+   *newptr_arg = p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_query(size_t *size_arg, void *ptr_arg)
+{
+   void *owner = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(size_arg);
+   *size_arg = 0;
+   RAM_FAIL_NOTNULL(ptr_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         rambig_theglobals.rambigg_initflag);
+
+   e = ramown_get(&owner, &rambig_theglobals.rambigg_map, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   *size_arg = ((rambig_block_t *)owner)->rambigb_size;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_flush()
+{
+   rambig_cache_t *cache = NULL;
+   rambig_block_t *chain = NULL;
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         rambig_theglobals.rambigg_initflag);
+
+   RAM_FAIL_TRAP(rambig_rcltls(&cache, 0));
+   if (NULL != cache)
+   {
+      rambig_evict(&chain, cache, 0);
+      RAM_FAIL_TRAP(rambig_unmap(chain));
+      chain = NULL;
+   }
+
+   RAM_FAIL_TRAP(rammtx_wait(&rambig_theglobals.rambigg_mutex));
+   rambig_evict(&chain, &rambig_theglobals.rambigg_cache, 0);
+   RAM_FAIL_PANIC(rammtx_quit(&rambig_theglobals.rambigg_mutex));
+   RAM_FAIL_TRAP(rambig_unmap(chain));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_getstats(rambig_stats_t *stats_arg)
+{
+   rambig_cache_t *cache = NULL;
+
+   RAM_FAIL_NOTNULL(stats_arg);
+   memset(stats_arg, 0, sizeof(*stats_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         rambig_theglobals.rambigg_initflag);
+
+   RAM_FAIL_TRAP(rambig_rcltls(&cache, 0));
+   if (NULL != cache)
+      stats_arg->rambigs_threadcached = cache->rambigc_bytes;
+   RAM_FAIL_TRAP(rammtx_wait(&rambig_theglobals.rambigg_mutex));
+   stats_arg->rambigs_cached = rambig_theglobals.rambigg_cache.rambigc_bytes;
+   RAM_FAIL_PANIC(rammtx_quit(&rambig_theglobals.rambigg_mutex));
+   stats_arg->rambigs_live = (size_t)rambig_theglobals.rambigg_live;
+   stats_arg->rambigs_hits = (size_t)rambig_theglobals.rambigg_hits;
+   stats_arg->rambigs_misses = (size_t)rambig_theglobals.rambigg_misses;
+   stats_arg->rambigs_remaps = (size_t)rambig_theglobals.rambigg_remaps;
+   stats_arg->rambigs_unmaps = (size_t)rambig_theglobals.rambigg_unmaps;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_roundup(size_t *rounded_arg, size_t size_arg)
+{
+   size_t mask = 0;
+
+   assert(rounded_arg != NULL);
+   assert(size_arg > 0);
+
+   mask = rambig_theglobals.rambigg_pagesize - 1;
+   if (size_arg > (size_t)-1 - mask)
+      return RAM_REPLY_RANGEFAIL;
+
+   *rounded_arg = (size_arg + mask) & ~mask;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_find(rambig_block_t **block_arg, void *ptr_arg)
+{
+   void *owner = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(block_arg != NULL);
+   assert(ptr_arg != NULL);
+
+   /* every large object begins on a page boundary, so i can dismiss most
+    * small objects without consulting the map. */
+   if (0 != ((uintptr_t)ptr_arg & (rambig_theglobals.rambigg_pagesize - 1)))
+      return RAM_REPLY_NOTFOUND;
+
+   e = ramown_get(&owner, &rambig_theglobals.rambigg_map, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   *block_arg = (rambig_block_t *)owner;
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+         (*block_arg)->rambigb_pages == (char *)ptr_arg);
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_withdraw(rambig_block_t **block_arg, size_t size_arg)
+{
+   rambig_cache_t *cache = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(block_arg != NULL);
+
+   RAM_FAIL_TRAP(rambig_rcltls(&cache, 0));
+   if (NULL != cache)
+   {
+      e = rambig_take(block_arg, cache, size_arg);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_NOTFOUND:
+         break;
+      case RAM_REPLY_OK:
+         return RAM_REPLY_OK;
+      }
+   }
+
+   /* there's no point in contending for the lock if the shared cache is
+    * disabled. */
+   if (0 == rambig_theglobals.rambigg_cache.rambigc_capacity)
+      return RAM_REPLY_NOTFOUND;
+   RAM_FAIL_TRAP(rammtx_wait(&rambig_theglobals.rambigg_mutex));
+   e = rambig_take(block_arg, &rambig_theglobals.rambigg_cache, size_arg);
+   RAM_FAIL_PANIC(rammtx_quit(&rambig_theglobals.rambigg_mutex));
+
+   return e;
+}
+
+ram_reply_t rambig_deposit(rambig_block_t *block_arg)
+{
+   rambig_cache_t *cache = NULL;
+   rambig_block_t *chain = NULL;
+
+   assert(block_arg != NULL);
+
+   if (block_arg->rambigb_size > RAM_WANT_LARGETHREADCACHEBYTES)
+   {
+      RAM_FAIL_TRAP(rambig_share(block_arg));
+      return RAM_REPLY_OK;
+   }
+
+   RAM_FAIL_TRAP(rambig_rcltls(&cache, 1));
+   rambig_push(cache, block_arg);
+   /* whatever the calling thread's cache can't hold is passed on to the
+    * shared cache. */
+   rambig_evict(&chain, cache, cache->rambigc_capacity);
+   while (NULL != chain)
+   {
+      block_arg = chain;
+      chain = chain->rambigb_next;
+      RAM_FAIL_TRAP(rambig_share(block_arg));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_share(rambig_block_t *block_arg)
+{
+   rambig_block_t *chain = NULL;
+   rambig_cache_t *cache = NULL;
+
+   assert(block_arg != NULL);
+
+   cache = &rambig_theglobals.rambigg_cache;
+   if (block_arg->rambigb_size > cache->rambigc_capacity)
+   {
+      block_arg->rambigb_next = NULL;
+      RAM_FAIL_TRAP(rambig_unmap(block_arg));
+      return RAM_REPLY_OK;
+   }
+
+   RAM_FAIL_TRAP(rammtx_wait(&rambig_theglobals.rambigg_mutex));
+   rambig_push(cache, block_arg);
+   rambig_evict(&chain, cache, cache->rambigc_capacity);
+   RAM_FAIL_PANIC(rammtx_quit(&rambig_theglobals.rambigg_mutex));
+   /* i don't hold the lock while i talk to the system. */
+   RAM_FAIL_TRAP(rambig_unmap(chain));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_take(rambig_block_t **block_arg,
+      rambig_cache_t *cache_arg, size_t size_arg)
+{
+   rambig_block_t *i = NULL, *best = NULL;
+
+   assert(block_arg != NULL);
+   assert(cache_arg != NULL);
+
+   /* i look for the smallest mapping that's large enough without being
+    * wasteful. the caches are small, so a linear search is fine. */
+   for (i = cache_arg->rambigc_head; NULL != i; i = i->rambigb_next)
+   {
+      if (i->rambigb_size >= size_arg && i->rambigb_size - size_arg <=
+            i->rambigb_size / RAMBIG_MAXSLACK && (NULL == best ||
+            i->rambigb_size < best->rambigb_size))
+      {
+         best = i;
+         if (best->rambigb_size == size_arg)
+            break;
+      }
+   }
+
+   if (NULL == best)
+      return RAM_REPLY_NOTFOUND;
+
+   rambig_unlink(cache_arg, best);
+   *block_arg = best;
+   return RAM_REPLY_OK;
+}
+
+void rambig_push(rambig_cache_t *cache_arg, rambig_block_t *block_arg)
+{
+   assert(cache_arg != NULL);
+   assert(block_arg != NULL);
+
+   block_arg->rambigb_prev = NULL;
+   block_arg->rambigb_next = cache_arg->rambigc_head;
+   if (NULL == cache_arg->rambigc_head)
+      cache_arg->rambigc_tail = block_arg;
+   else
+      cache_arg->rambigc_head->rambigb_prev = block_arg;
+   cache_arg->rambigc_head = block_arg;
+   cache_arg->rambigc_bytes += block_arg->rambigb_size;
+}
+
+void rambig_unlink(rambig_cache_t *cache_arg, rambig_block_t *block_arg)
+{
+   assert(cache_arg != NULL);
+   assert(block_arg != NULL);
+
+   if (NULL == block_arg->rambigb_prev)
+      cache_arg->rambigc_head = block_arg->rambigb_next;
+   else
+      block_arg->rambigb_prev->rambigb_next = block_arg->rambigb_next;
+   if (NULL == block_arg->rambigb_next)
+      cache_arg->rambigc_tail = block_arg->rambigb_prev;
+   else
+      block_arg->rambigb_next->rambigb_prev = block_arg->rambigb_prev;
+   block_arg->rambigb_next = NULL;
+   block_arg->rambigb_prev = NULL;
+   cache_arg->rambigc_bytes -= block_arg->rambigb_size;
+}
+
+void rambig_evict(rambig_block_t **chain_arg, rambig_cache_t *cache_arg,
+      size_t capacity_arg)
+{
+   rambig_block_t *block = NULL;
+
+   assert(chain_arg != NULL);
+   assert(cache_arg != NULL);
+
+   /* the oldest blocks are evicted first. they're strung together through
+    * their *next* links, which is all rambig_unmap() needs. */
+   while (cache_arg->rambigc_bytes > capacity_arg)
+   {
+      block = cache_arg->rambigc_tail;
+      rambig_unlink(cache_arg, block);
+      block->rambigb_next = *chain_arg;
+      *chain_arg = block;
+   }
+}
+
+ram_reply_t rambig_unmap(rambig_block_t *chain_arg)
+{
+   rambig_block_t *block = NULL;
+
+   while (NULL != chain_arg)
+   {
+      block = chain_arg;
+      chain_arg = chain_arg->rambigb_next;
+      RAM_FAIL_TRAP(ramsys_releaserange(block->rambigb_pages,
+            block->rambigb_size));
+      rammem_supfree(block);
+      ramatom_xadd(&rambig_theglobals.rambigg_unmaps, 1);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_mkblock(rambig_block_t **block_arg, size_t size_arg)
+{
+   rambig_block_t *block = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(block_arg != NULL);
+
+   block = rammem_supmalloc(sizeof(*block));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != block);
+   memset(block, 0, sizeof(*block));
+   e = ramsys_maprange(&block->rambigb_pages, size_arg);
+   if (RAM_REPLY_OK != e)
+   {
+      rammem_supfree(block);
+      return e;
+   }
+
+   block->rambigb_size = size_arg;
+   *block_arg = block;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rambig_remap(rambig_block_t *block_arg, size_t size_arg)
+{
+   char *p = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(block_arg != NULL);
+
+   /* the old address could be handed to another thread the moment the
+    * mapping moves, so the block leaves the map beforehand. */
+   RAM_FAIL_TRAP(ramown_set(&rambig_theglobals.rambigg_map,
+         block_arg->rambigb_pages, NULL));
+   e = ramsys_remaprange(&p, block_arg->rambigb_pages,
+         block_arg->rambigb_size, size_arg);
+   if (RAM_REPLY_OK == e)
+   {
+      block_arg->rambigb_pages = p;
+      block_arg->rambigb_size = size_arg;
+   }
+   /* the block goes back into the map whether or not it moved. */
+   RAM_FAIL_TRAP(ramown_set(&rambig_theglobals.rambigg_map,
+         block_arg->rambigb_pages, block_arg));
+
+   return e;
+}
+
+ram_reply_t rambig_rcltls(rambig_cache_t **cache_arg, int createflag_arg)
+{
+   void *p = NULL;
+   rambig_cache_t *cache = NULL;
+
+   assert(cache_arg != NULL);
+
+   RAM_FAIL_TRAP(ramtls_rcl(&p, rambig_theglobals.rambigg_tlskey));
+   if (NULL == p && createflag_arg)
+   {
+      cache = rammem_supmalloc(sizeof(*cache));
+      RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != cache);
+      memset(cache, 0, sizeof(*cache));
+      cache->rambigc_capacity = RAM_WANT_LARGETHREADCACHEBYTES;
+      RAM_FAIL_TRAP(ramtls_sto(rambig_theglobals.rambigg_tlskey, cache));
+      p = cache;
+   }
+
+   *cache_arg = (rambig_cache_t *)p;
+   return RAM_REPLY_OK;
+}
+
+void RAMSYS_TLSDTORDECL rambig_orphan(void *cache_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   /* there's nobody to report a failure to when a thread exits. */
+   e = rambig_orphan2((rambig_cache_t *)cache_arg);
+   if (RAM_REPLY_OK != e)
+      ram_fail_panic("i failed to empty an exiting thread's cache.");
+}
+
+ram_reply_t rambig_orphan2(rambig_cache_t *cache_arg)
+{
+   rambig_block_t *chain = NULL, *block = NULL;
+
+   RAM_FAIL_NOTNULL(cache_arg);
+
+   /* the mappings an exiting thread was holding onto might still be of use
+    * to another thread. */
+   rambig_evict(&chain, cache_arg, 0);
+   rammem_supfree(cache_arg);
+   while (NULL != chain)
+   {
+      block = chain;
+      chain = chain->rambigb_next;
+      RAM_FAIL_TRAP(rambig_share(block));
+   }
+
+   return RAM_REPLY_OK;
+}
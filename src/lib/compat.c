@@ -93,6 +93,44 @@ void ramcompat_free(void *ptr_arg)
    }
 }
 
+void * ramcompat_realloc(void *ptr_arg, size_t size_arg)
+{
+   /* realloc() behaves like malloc() if the pointer is NULL and like free()
+    * if the size is 0. */
+   if (NULL == ptr_arg)
+      return ramcompat_malloc(size_arg);
+   else if (0 == size_arg)
+   {
+      ramcompat_free(ptr_arg);
+      return NULL;
+   }
+   else
+   {
+      ram_reply_t e = RAM_REPLY_INSANE;
+      void *p = NULL;
+
+      e = ram_default_resize(&p, ptr_arg, size_arg);
+      switch (e)
+      {
+      default:
+         return NULL;
+      case RAM_REPLY_OK:
+         return p;
+      case RAM_REPLY_RANGEFAIL:
+         /* realloc() leaves the original object intact if it fails. */
+         return NULL;
+      case RAM_REPLY_NOTFOUND:
+         /* the only objects i defer to the supplementary allocator are
+          * empty ones (see ramcompat_malloc()), so there's nothing to
+          * copy. */
+         p = ramcompat_malloc(size_arg);
+         if (NULL != p)
+            rammem_supfree(ptr_arg);
+         return p;
+      }
+   }
+}
+
 void * ramcompat_calloc(size_t count_arg, size_t size_arg)
 {
    void *p = NULL;
@@ -0,0 +1,381 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include <ramalloc/cpu.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/cast.h>
+#include <ramalloc/sys.h>
+#include <string.h>
+
+static ram_reply_t ramcpu_mkpool2(ramcpu_pool_t *cpupool_arg, size_t count_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg);
+static ram_reply_t ramcpu_rmheaps(ramcpu_heap_t *heaps_arg, size_t count_arg);
+static ram_reply_t ramcpu_enter(ramcpu_heap_t **heap_arg, ramcpu_pool_t *cpupool_arg);
+static ram_reply_t ramcpu_queryheap(ramcpu_heap_t **heap_arg, size_t *size_arg, void *ptr_arg);
+
+ram_reply_t ramcpu_mkpool(ramcpu_pool_t *cpupool_arg, size_t count_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(cpupool_arg);
+
+   e = ramcpu_mkpool2(cpupool_arg, count_arg, appetite_arg, policy_arg);
+   if (RAM_REPLY_OK == e)
+      return RAM_REPLY_OK;
+   else
+   {
+      memset(cpupool_arg, 0, sizeof(*cpupool_arg));
+      return e;
+   }
+}
+
+ram_reply_t ramcpu_mkpool2(ramcpu_pool_t *cpupool_arg, size_t count_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg)
+{
+   ramcpu_heap_t *heaps = NULL;
+   void *block = NULL;
+   size_t i = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(cpupool_arg != NULL);
+   RAM_FAIL_NOTNULL(policy_arg);
+   assert(0 == sizeof(ramcpu_heap_t) % RAMCPU_CACHELINE);
+
+   if (0 == count_arg)
+      RAM_FAIL_TRAP(ramsys_cpucount(&count_arg));
+
+   /* like the parallel pool's per-thread structures, the heaps come from
+    * the supplementary allocator. this only happens once per pool. the
+    * allocator doesn't promise anything beyond ordinary alignment, so i
+    * ask for enough extra to align the heaps myself. */
+   block = rammem_supmalloc(count_arg * sizeof(*heaps) + RAMCPU_CACHELINE - 1);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != block);
+   heaps = (ramcpu_heap_t *)(((uintptr_t)block + RAMCPU_CACHELINE - 1)
+         & ~(uintptr_t)(RAMCPU_CACHELINE - 1));
+   memset(heaps, 0, count_arg * sizeof(*heaps));
+   for (i = 0; i < count_arg; ++i)
+   {
+      e = rammtx_mkmutex(&heaps[i].ramcpuh_mutex);
+      if (RAM_REPLY_OK == e)
+      {
+         e = ramlazy_mkpool(&heaps[i].ramcpuh_lazypool, appetite_arg,
+               policy_arg);
+         if (RAM_REPLY_OK != e)
+            RAM_FAIL_PANIC(rammtx_rmmutex(&heaps[i].ramcpuh_mutex));
+      }
+      if (RAM_REPLY_OK != e)
+      {
+         /* only the heaps i've finished making need to be taken apart. */
+         RAM_FAIL_PANIC(ramcpu_rmheaps(heaps, i));
+         rammem_supfree(block);
+         RAM_FAIL_TRAP(e);
+      }
+      heaps[i].ramcpuh_backref = cpupool_arg;
+   }
+
+   cpupool_arg->ramcpup_heaps = heaps;
+   cpupool_arg->ramcpup_count = count_arg;
+   cpupool_arg->ramcpup_block = block;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_rmpool(ramcpu_pool_t *cpupool_arg)
+{
+   size_t i = 0;
+   int emptyflag = 0;
+
+   RAM_FAIL_NOTNULL(cpupool_arg);
+
+   /* objects in a heap's trash or on their way to it aren't in use, so
+    * they have to be reclaimed before i can tell. every heap has to be
+    * empty before i take any of them apart; otherwise, a thread that
+    * releases an object that's still in use would have nowhere to put
+    * it. */
+   RAM_FAIL_TRAP(ramcpu_flush(cpupool_arg));
+   for (i = 0; i < cpupool_arg->ramcpup_count; ++i)
+   {
+      RAM_FAIL_TRAP(ramlazy_isempty(&emptyflag,
+            &cpupool_arg->ramcpup_heaps[i].ramcpuh_lazypool));
+      if (!emptyflag)
+         return RAM_REPLY_DISALLOWED;
+   }
+
+   RAM_FAIL_TRAP(ramcpu_rmheaps(cpupool_arg->ramcpup_heaps,
+         cpupool_arg->ramcpup_count));
+   rammem_supfree(cpupool_arg->ramcpup_block);
+   memset(cpupool_arg, 0, sizeof(*cpupool_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_rmheaps(ramcpu_heap_t *heaps_arg, size_t count_arg)
+{
+   size_t i = 0;
+
+   assert(heaps_arg != NULL || 0 == count_arg);
+
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(ramlazy_rmpool(&heaps_arg[i].ramcpuh_lazypool));
+      RAM_FAIL_TRAP(rammtx_rmmutex(&heaps_arg[i].ramcpuh_mutex));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_acquire(void **newptr_arg, ramcpu_pool_t *cpupool_arg, size_t size_arg)
+{
+   ramcpu_heap_t *heap = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(newptr_arg);
+   *newptr_arg = NULL;
+   RAM_FAIL_NOTNULL(cpupool_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+
+   RAM_FAIL_TRAP(ramcpu_enter(&heap, cpupool_arg));
+   e = ramlazy_acquire(newptr_arg, &heap->ramcpuh_lazypool, size_arg);
+   RAM_FAIL_PANIC(rammtx_quit(&heap->ramcpuh_mutex));
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_release(void *ptr_arg)
+{
+   ramcpu_heap_t *owner = NULL, *caller = NULL;
+   size_t sz = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(ptr_arg);
+
+   RAM_FAIL_TRAP(ramcpu_queryheap(&owner, &sz, ptr_arg));
+   /* the heap i'm running on plays the part that the calling thread's own
+    * pool plays in a parallel pool: if it owns the object, the object is
+    * released immediately; otherwise, it's buffered there on its way
+    * home. */
+   RAM_FAIL_TRAP(ramcpu_enter(&caller, owner->ramcpuh_backref));
+   e = ramlazy_discard(&owner->ramcpuh_lazypool, ptr_arg, sz,
+         &caller->ramcpuh_lazypool);
+   RAM_FAIL_PANIC(rammtx_quit(&caller->ramcpuh_mutex));
+   RAM_FAIL_TRAP(e);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_reclaim(size_t *count_arg, ramcpu_pool_t *cpupool_arg, size_t goal_arg)
+{
+   ramcpu_heap_t *heap = NULL;
+   size_t i = 0, count = 0, unused = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(count_arg);
+   *count_arg = 0;
+   RAM_FAIL_NOTNULL(cpupool_arg);
+   RAM_FAIL_NOTZERO(goal_arg);
+
+   /* there's no telling which heap the calling thread's objects went to,
+    * so i visit each of them until i've met the goal. */
+   for (i = 0; i < cpupool_arg->ramcpup_count && *count_arg < goal_arg; ++i)
+   {
+      heap = &cpupool_arg->ramcpup_heaps[i];
+      count = 0;
+      RAM_FAIL_TRAP(rammtx_wait(&heap->ramcpuh_mutex));
+      e = ramlazy_dispatch(&heap->ramcpuh_lazypool);
+      if (RAM_REPLY_OK == e)
+      {
+         e = ramlazy_reclaim(&count, &unused, &heap->ramcpuh_lazypool,
+               goal_arg - *count_arg);
+      }
+      RAM_FAIL_PANIC(rammtx_quit(&heap->ramcpuh_mutex));
+      RAM_FAIL_TRAP(e);
+      *count_arg += count;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_flush(ramcpu_pool_t *cpupool_arg)
+{
+   ramcpu_heap_t *heap = NULL;
+   size_t i = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(cpupool_arg);
+
+   /* every heap's outgoing buffers are dispatched before any of them is
+    * flushed, so that nothing is left in transit to a heap that's already
+    * been visited. */
+   for (i = 0; i < cpupool_arg->ramcpup_count; ++i)
+   {
+      heap = &cpupool_arg->ramcpup_heaps[i];
+      RAM_FAIL_TRAP(rammtx_wait(&heap->ramcpuh_mutex));
+      e = ramlazy_dispatch(&heap->ramcpuh_lazypool);
+      RAM_FAIL_PANIC(rammtx_quit(&heap->ramcpuh_mutex));
+      RAM_FAIL_TRAP(e);
+   }
+   for (i = 0; i < cpupool_arg->ramcpup_count; ++i)
+   {
+      heap = &cpupool_arg->ramcpup_heaps[i];
+      RAM_FAIL_TRAP(rammtx_wait(&heap->ramcpuh_mutex));
+      e = ramlazy_flush(&heap->ramcpuh_lazypool);
+      RAM_FAIL_PANIC(rammtx_quit(&heap->ramcpuh_mutex));
+      RAM_FAIL_TRAP(e);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_query(ramcpu_pool_t **cpupool_arg, size_t *size_arg, void *ptr_arg)
+{
+   ramcpu_heap_t *heap = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(cpupool_arg);
+   *cpupool_arg = NULL;
+
+   e = ramcpu_queryheap(&heap, size_arg, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   *cpupool_arg = heap->ramcpuh_backref;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_chkpool(const ramcpu_pool_t *cpupool_arg)
+{
+   ramcpu_heap_t *heap = NULL;
+   size_t i = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(cpupool_arg);
+   RAM_FAIL_NOTZERO(cpupool_arg->ramcpup_count);
+   RAM_FAIL_NOTNULL(cpupool_arg->ramcpup_heaps);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+         0 == (uintptr_t)cpupool_arg->ramcpup_heaps % RAMCPU_CACHELINE);
+
+   for (i = 0; i < cpupool_arg->ramcpup_count; ++i)
+   {
+      heap = &cpupool_arg->ramcpup_heaps[i];
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+            cpupool_arg == heap->ramcpuh_backref);
+      RAM_FAIL_TRAP(rammtx_wait(&heap->ramcpuh_mutex));
+      e = ramlazy_chkpool(&heap->ramcpuh_lazypool);
+      RAM_FAIL_PANIC(rammtx_quit(&heap->ramcpuh_mutex));
+      RAM_FAIL_TRAP(e);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_enter(ramcpu_heap_t **heap_arg, ramcpu_pool_t *cpupool_arg)
+{
+   ramcpu_heap_t *heap = NULL;
+   size_t cpu = 0, home = 0, i = 0;
+   int successflag = 0;
+
+   assert(heap_arg != NULL);
+   assert(cpupool_arg != NULL);
+   assert(cpupool_arg->ramcpup_count > 0);
+   *heap_arg = NULL;
+
+   /* the processor number is only a hint, since the thread can be migrated
+    * as soon as i have it. the heap is usually free anyway: another thread
+    * can only be in there if it was preempted or migrated while inside. in
+    * that case, a neighboring heap is just as good as mine. */
+   RAM_FAIL_TRAP(ramsys_whichcpu(&cpu));
+   home = cpu % cpupool_arg->ramcpup_count;
+   for (i = 0; i < cpupool_arg->ramcpup_count; ++i)
+   {
+      heap = &cpupool_arg->ramcpup_heaps[
+            (home + i) % cpupool_arg->ramcpup_count];
+      RAM_FAIL_TRAP(rammtx_trywait(&successflag, &heap->ramcpuh_mutex));
+      if (successflag)
+      {
+         *heap_arg = heap;
+         return RAM_REPLY_OK;
+      }
+   }
+
+   /* every heap is busy, so there are more threads running than there are
+    * heaps. i might as well wait my turn for my own. */
+   heap = &cpupool_arg->ramcpup_heaps[home];
+   RAM_FAIL_TRAP(rammtx_wait(&heap->ramcpuh_mutex));
+
+   *heap_arg = heap;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramcpu_queryheap(ramcpu_heap_t **heap_arg, size_t *size_arg, void *ptr_arg)
+{
+   ramlazy_pool_t *lazypool = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(heap_arg);
+   *heap_arg = NULL;
+
+   e = ramlazy_query(&lazypool, size_arg, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   *heap_arg = RAM_CAST_STRUCTBASE(ramcpu_heap_t, ramcpuh_lazypool,
+         lazypool);
+   return RAM_REPLY_OK;
+}
@@ -33,13 +33,21 @@
 
 #include <ramalloc/default.h>
 #include <ramalloc/para.h>
+#include <ramalloc/big.h>
+#include <ramalloc/tiny.h>
+#include <ramalloc/mux.h>
+#include <string.h>
 
 rampara_pool_t ram_default_thepool;
 
 ram_reply_t ram_default_initialize()
 {
+   ramlazy_policy_t policy = {0};
+
+   policy.ramlazyp_mingoal = RAM_WANT_DEFAULTRECLAIMGOAL;
+   policy.ramlazyp_maxgoal = RAM_WANT_DEFAULTRECLAIMLIMIT;
    RAM_FAIL_TRAP(rampara_mkpool(&ram_default_thepool,
-         RAM_WANT_DEFAULTAPPETITE, RAM_WANT_DEFAULTRECLAIMGOAL));
+         RAM_WANT_DEFAULTAPPETITE, &policy));
 
    return RAM_REPLY_OK;
 }
@@ -48,7 +56,20 @@ ram_reply_t ram_default_acquire(void **newptr_arg, size_t size_arg)
 {
    ram_reply_t reply = RAM_REPLY_INSANE;
 
+#if RAM_WANT_TINYCELLS
+   /* objects smaller than a word are packed into cells; they'd otherwise
+    * each occupy the smallest slot. */
+   if (size_arg > 0 && size_arg <= RAMTINY_MAXCELLSIZE)
+   {
+      RAM_FAIL_TRAP(ramtiny_acquire(newptr_arg, size_arg));
+      return RAM_REPLY_OK;
+   }
+#endif
+
    reply = rampara_acquire(newptr_arg, &ram_default_thepool, size_arg);
+   /* objects too large for any size class get a mapping of their own. */
+   if (RAM_REPLY_RANGEFAIL == reply)
+      reply = rambig_acquire(newptr_arg, size_arg);
    switch (reply)
    {
    default:
@@ -65,7 +86,146 @@ ram_reply_t ram_default_acquire(void **newptr_arg, size_t size_arg)
 
 ram_reply_t ram_default_discard(void *ptr_arg)
 {
-   RAM_FAIL_TRAP(rampara_release(ptr_arg));
+   ram_reply_t reply = RAM_REPLY_INSANE;
+
+   /* rambig_release() dismisses anything that isn't on a page boundary
+    * without consulting its map, so small objects don't pay much for
+    * being asked first. */
+   reply = rambig_release(ptr_arg);
+   switch (reply)
+   {
+   default:
+      RAM_FAIL_TRAP(reply);
+      RAM_FAIL_UNREACHABLE();
+   case RAM_REPLY_NOTFOUND:
+      break;
+   case RAM_REPLY_OK:
+      return RAM_REPLY_OK;
+   }
+
+   /* tiny cells are asked last, so ordinary objects don't pay for them. */
+   reply = rampara_release(ptr_arg);
+#if RAM_WANT_TINYCELLS
+   if (RAM_REPLY_NOTFOUND == reply)
+      reply = ramtiny_release(ptr_arg);
+#endif
+   RAM_FAIL_TRAP(reply);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_resize(void **newptr_arg, void *ptr_arg,
+      size_t size_arg)
+{
+   size_t sz = 0;
+   void *p = NULL;
+   ram_reply_t reply = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(newptr_arg);
+   *newptr_arg = NULL;
+   RAM_FAIL_NOTNULL(ptr_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+
+   reply = ram_default_query(&sz, ptr_arg);
+   switch (reply)
+   {
+   default:
+      RAM_FAIL_TRAP(reply);
+      RAM_FAIL_UNREACHABLE();
+   case RAM_REPLY_NOTFOUND:
+      return reply;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   if (sz > RAMMUX_MAXCLASSSIZE)
+   {
+      /* a large object that's staying large can be remapped. */
+      if (size_arg > RAMMUX_MAXCLASSSIZE)
+      {
+         reply = rambig_resize(newptr_arg, ptr_arg, size_arg);
+         switch (reply)
+         {
+         default:
+            RAM_FAIL_TRAP(reply);
+            RAM_FAIL_UNREACHABLE();
+         case RAM_REPLY_RANGEFAIL:
+            return reply;
+         case RAM_REPLY_OK:
+            break;
+         }
+
+         return RAM_REPLY_OK;
+      }
+   }
+   /* a small object stays put if it would still occupy at least half of
+    * its size class. */
+   else if (size_arg <= sz && size_arg >= sz / 2)
+   {
+      *newptr_arg = ptr_arg;
+      return RAM_REPLY_OK;
+   }
+
+   reply = ram_default_acquire(&p, size_arg);
+   switch (reply)
+   {
+   default:
+      RAM_FAIL_TRAP(reply);
+      RAM_FAIL_UNREACHABLE();
+   case RAM_REPLY_RANGEFAIL:
+      return reply;
+   case RAM_REPLY_OK:
+      break;
+   }
+   memcpy(p, ptr_arg, size_arg < sz ? size_arg : sz);
+   RAM_FAIL_TRAP(ram_default_discard(ptr_arg));
+
+   *newptr_arg = p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_reserve(size_t size_arg, size_t count_arg)
+{
+   ram_reply_t reply = RAM_REPLY_INSANE;
+
+   reply = rampara_reserve(&ram_default_thepool, size_arg, count_arg);
+   switch (reply)
+   {
+   default:
+      RAM_FAIL_TRAP(reply);
+      RAM_FAIL_UNREACHABLE();
+   case RAM_REPLY_RANGEFAIL:
+      return reply;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_prewarm(const ram_default_reservation_t *profile_arg,
+      size_t count_arg)
+{
+   size_t i = 0;
+   ram_reply_t reply = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(profile_arg);
+
+   for (i = 0; i < count_arg; ++i)
+   {
+      reply = ram_default_reserve(profile_arg[i].ramdr_size,
+            profile_arg[i].ramdr_count);
+      switch (reply)
+      {
+      default:
+         RAM_FAIL_TRAP(reply);
+         RAM_FAIL_UNREACHABLE();
+      case RAM_REPLY_RANGEFAIL:
+         return reply;
+      case RAM_REPLY_OK:
+         break;
+      }
+   }
 
    return RAM_REPLY_OK;
 }
@@ -78,9 +238,131 @@ ram_reply_t ram_default_reclaim(size_t *count_arg, size_t goal_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ram_default_reclaimfor(ram_default_reclaimstats_t *stats_arg,
+      uint64_t budget_arg)
+{
+   rampara_reclaimstats_t stats = {0};
+
+   RAM_FAIL_NOTNULL(stats_arg);
+
+   RAM_FAIL_TRAP(rampara_reclaimfor(&stats, &ram_default_thepool,
+         budget_arg));
+   stats_arg->ramdrs_objects = stats.ramparars_objects;
+   stats_arg->ramdrs_pages = stats.ramparars_pages;
+   stats_arg->ramdrs_reservations = stats.ramparars_reservations;
+   stats_arg->ramdrs_elapsed = stats.ramparars_elapsed;
+   stats_arg->ramdrs_complete = stats.ramparars_complete;
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ram_default_flush()
 {
    RAM_FAIL_TRAP(rampara_flush(&ram_default_thepool));
+   RAM_FAIL_TRAP(rambig_flush());
+#if RAM_WANT_TINYCELLS
+   RAM_FAIL_TRAP(ramtiny_flush());
+#endif
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_handoff()
+{
+   RAM_FAIL_TRAP(rampara_handoff(&ram_default_thepool));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_notify(const ram_default_notifier_t *notifier_arg)
+{
+   ramtra_notifier_t notifier = {0};
+
+   if (NULL == notifier_arg)
+   {
+      RAM_FAIL_TRAP(rampara_notify(&ram_default_thepool, NULL));
+      return RAM_REPLY_OK;
+   }
+
+   notifier.ramtran_depth = notifier_arg->ramdn_depth;
+   notifier.ramtran_func = notifier_arg->ramdn_func;
+   notifier.ramtran_context = notifier_arg->ramdn_context;
+   RAM_FAIL_TRAP(rampara_notify(&ram_default_thepool, &notifier));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_mkheap(ram_default_heap_t **heap_arg)
+{
+   RAM_FAIL_TRAP(rampara_mkheap(heap_arg, &ram_default_thepool));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_rmheap(ram_default_heap_t *heap_arg)
+{
+   RAM_FAIL_TRAP(rampara_rmheap(heap_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_heapacquire(void **newptr_arg,
+      ram_default_heap_t *heap_arg, size_t size_arg)
+{
+   ram_reply_t reply = RAM_REPLY_INSANE;
+
+   reply = rampara_heapacquire(newptr_arg, heap_arg, size_arg);
+   /* large objects don't belong to any heap, so they're mapped just as
+    * ram_default_acquire() would map them. */
+   if (RAM_REPLY_RANGEFAIL == reply)
+      reply = rambig_acquire(newptr_arg, size_arg);
+   switch (reply)
+   {
+   default:
+      RAM_FAIL_TRAP(reply);
+      RAM_FAIL_UNREACHABLE();
+   case RAM_REPLY_RANGEFAIL:
+      return reply;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_heapdiscard(ram_default_heap_t *heap_arg,
+      void *ptr_arg)
+{
+   ram_reply_t reply = RAM_REPLY_INSANE;
+
+   /* i ask the same allocators as ram_default_discard(), in the same
+    * order; only the parallel pool cares which heap is asking. */
+   reply = rambig_release(ptr_arg);
+   switch (reply)
+   {
+   default:
+      RAM_FAIL_TRAP(reply);
+      RAM_FAIL_UNREACHABLE();
+   case RAM_REPLY_NOTFOUND:
+      break;
+   case RAM_REPLY_OK:
+      return RAM_REPLY_OK;
+   }
+
+   reply = rampara_heapdiscard(heap_arg, ptr_arg);
+#if RAM_WANT_TINYCELLS
+   if (RAM_REPLY_NOTFOUND == reply)
+      reply = ramtiny_release(ptr_arg);
+#endif
+   RAM_FAIL_TRAP(reply);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ram_default_heapreclaim(size_t *count_arg,
+      ram_default_heap_t *heap_arg, size_t goal_arg)
+{
+   RAM_FAIL_TRAP(rampara_heapreclaim(count_arg, heap_arg, goal_arg));
 
    return RAM_REPLY_OK;
 }
@@ -102,6 +384,13 @@ ram_reply_t ram_default_query(size_t *size_arg, void *ptr_arg)
       RAM_FAIL_TRAP(reply);
       RAM_FAIL_UNREACHABLE();
    case RAM_REPLY_NOTFOUND:
+      /* it might be a large object. */
+      reply = rambig_query(size_arg, ptr_arg);
+#if RAM_WANT_TINYCELLS
+      /* ...or a tiny one. */
+      if (RAM_REPLY_NOTFOUND == reply)
+         reply = ramtiny_query(size_arg, ptr_arg);
+#endif
       return reply;
    case RAM_REPLY_OK:
       break;
@@ -119,6 +408,9 @@ ram_reply_t ram_default_query(size_t *size_arg, void *ptr_arg)
 ram_reply_t ram_default_check()
 {
    RAM_FAIL_TRAP(rampara_chkpool(&ram_default_thepool));
+#if RAM_WANT_TINYCELLS
+   RAM_FAIL_TRAP(ramtiny_chkheap());
+#endif
 
    return RAM_REPLY_OK;
 }
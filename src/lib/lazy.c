@@ -33,23 +33,49 @@
 
 #include <ramalloc/lazy.h>
 #include <ramalloc/cast.h>
+#include <ramalloc/annotate.h>
+#include <ramalloc/atom.h>
 #include <string.h>
 
+/* the occupant that marks a pool being reclaimed by another thread. */
+#define RAMLAZY_DELEGATE ((void *)1)
+/* the outgoing buffer that collects objects from the page a token
+ * describes. tokens are node addresses, which step by the size of a node
+ * rather than by a power of two, so i use a multiplicative (Fibonacci) hash
+ * and take the high bits of the product to reach every buffer. */
+#define RAMLAZY_OUTGOINGINDEX(Token) \
+   ((size_t)(((((uintptr_t)(Token) / sizeof(void *)) * 2654435769u) \
+         & 0xffffffffu) >> 24) % RAMLAZY_OUTGOINGCOUNT)
+
 typedef struct ramlazy_chktrashnode
 {
    const ramlazy_pool_t *ramlazyctn_lazypool;
 } ramlazy_chktrashnode_t;
 
-static ram_reply_t ramlazy_mkpool2(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg);
+static ram_reply_t ramlazy_mkpool2(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg);
+static ram_reply_t ramlazy_chkpool2(const ramlazy_pool_t *lpool_arg);
 static ram_reply_t ramlazy_chktrashnode(void *ptr_arg, void *context_arg);
-
-ram_reply_t ramlazy_mkpool(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg)
+static ram_reply_t ramlazy_acquire2(void **newptr_arg, ramlazy_pool_t *lpool_arg, size_t size_arg);
+static ram_reply_t ramlazy_adapt(ramlazy_pool_t *lpool_arg);
+static ram_reply_t ramlazy_relax(ramlazy_pool_t *lpool_arg);
+static ram_reply_t ramlazy_reclaim2(size_t *count_arg, size_t *pages_arg, ramlazy_pool_t *lpool_arg, size_t goal_arg);
+static ram_reply_t ramlazy_resume(ramlazy_pool_t *lpool_arg);
+static ram_reply_t ramlazy_tryoccupy(int *successflag_arg, ramlazy_pool_t *lpool_arg, void *occupant_arg);
+static ram_reply_t ramlazy_vacate(ramlazy_pool_t *lpool_arg, void *occupant_arg);
+static ram_reply_t ramlazy_delegate(ramlazy_pool_t *lpool_arg);
+static ram_reply_t ramlazy_delegate2(ramlazy_pool_t *lpool_arg);
+static ram_reply_t ramlazy_send(void *token_arg, void *first_arg, void *last_arg,
+      ramlazy_pool_t *dest_arg);
+static ram_reply_t ramlazy_sendoutgoing(ramlazy_outgoing_t *outgoing_arg);
+static ram_reply_t ramlazy_chkoutgoing(const ramlazy_outgoing_t *outgoing_arg);
+
+ram_reply_t ramlazy_mkpool(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg)
 {
    ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(lpool_arg);
 
-   e = ramlazy_mkpool2(lpool_arg, appetite_arg, disposalratio_arg);
+   e = ramlazy_mkpool2(lpool_arg, appetite_arg, policy_arg);
    if (RAM_REPLY_OK == e)
       return RAM_REPLY_OK;
    else
@@ -59,30 +85,69 @@ ram_reply_t ramlazy_mkpool(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_
    }
 }
 
-ram_reply_t ramlazy_mkpool2(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg)
+ram_reply_t ramlazy_mkpool2(ramlazy_pool_t *lpool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg)
 {
    assert(lpool_arg != NULL);
-   RAM_FAIL_NOTZERO(disposalratio_arg);
+   RAM_FAIL_NOTNULL(policy_arg);
+   RAM_FAIL_NOTZERO(policy_arg->ramlazyp_mingoal);
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED,
+         policy_arg->ramlazyp_maxgoal >= policy_arg->ramlazyp_mingoal);
 
    RAM_FAIL_TRAP(ramtra_mktrash(&lpool_arg->ramlazyp_trash));
    RAM_FAIL_TRAP(rammux_mkpool(&lpool_arg->ramlazyp_muxpool, appetite_arg));
-   lpool_arg->ramlazyp_disposalratio = disposalratio_arg;
+   lpool_arg->ramlazyp_policy = *policy_arg;
+   lpool_arg->ramlazyp_goal = policy_arg->ramlazyp_mingoal;
+   /* the owner occupies its pool until it hands it off. */
+   lpool_arg->ramlazyp_occupant = lpool_arg;
+   lpool_arg->ramlazyp_handoffflag = 0;
 
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramlazy_rmpool(ramlazy_pool_t *lpool_arg)
 {
+   size_t unused = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
    RAM_FAIL_NOTNULL(lpool_arg);
 
+   /* anything i'm holding onto for other pools has to go before i do. once
+    * i've taken the pool back, no delegate can get in. */
+   RAM_FAIL_TRAP(ramlazy_dispatch(lpool_arg));
+   RAM_FAIL_TRAP(ramlazy_resume(lpool_arg));
+   /* objects waiting in the trash aren't in use, but the mux pool can't
+    * tell until they've been reclaimed. */
+   RAM_FAIL_TRAP(ramlazy_reclaim2(&unused, &unused, lpool_arg, (size_t)-1));
+   e = rammux_rmpool(&lpool_arg->ramlazyp_muxpool);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_DISALLOWED:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
    RAM_FAIL_TRAP(ramtra_rmtrash(&lpool_arg->ramlazyp_trash));
 
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramlazy_isempty(int *emptyflag_arg, const ramlazy_pool_t *lpool_arg)
+{
+   RAM_FAIL_NOTNULL(emptyflag_arg);
+   *emptyflag_arg = 0;
+   RAM_FAIL_NOTNULL(lpool_arg);
+
+   RAM_FAIL_TRAP(rammux_isempty(emptyflag_arg, &lpool_arg->ramlazyp_muxpool));
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramlazy_acquire(void **newptr_arg, ramlazy_pool_t *lpool_arg, size_t size_arg)
 {
-   size_t unused = 0;
    ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(newptr_arg);
@@ -90,8 +155,39 @@ ram_reply_t ramlazy_acquire(void **newptr_arg, ramlazy_pool_t *lpool_arg, size_t
    RAM_FAIL_NOTNULL(lpool_arg);
    RAM_FAIL_NOTZERO(size_arg);
 
+   RAM_FAIL_TRAP(ramlazy_resume(lpool_arg));
+   e = ramlazy_acquire2(newptr_arg, lpool_arg, size_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_acquire2(void **newptr_arg, ramlazy_pool_t *lpool_arg, size_t size_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(newptr_arg != NULL);
+   assert(lpool_arg != NULL);
+
    /* first, i need to release anything that's sitting around in the trash. */
-   RAM_FAIL_TRAP(ramlazy_reclaim(&unused, lpool_arg, lpool_arg->ramlazyp_disposalratio));
+   if (!RAMTRA_ISEMPTY(&lpool_arg->ramlazyp_trash))
+      RAM_FAIL_TRAP(ramlazy_adapt(lpool_arg));
+   /* an empty trash is as good as a reclamation that fell short of its
+    * goal. without decaying here, a goal raised by a burst would stay
+    * raised until the next burst arrived, however long the pool sat idle
+    * in between. */
+   else
+      RAM_FAIL_TRAP(ramlazy_relax(lpool_arg));
    e = rammux_acquire(newptr_arg, &lpool_arg->ramlazyp_muxpool, size_arg);
    switch (e)
    {
@@ -108,6 +204,45 @@ ram_reply_t ramlazy_acquire(void **newptr_arg, ramlazy_pool_t *lpool_arg, size_t
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramlazy_adapt(ramlazy_pool_t *lpool_arg)
+{
+   size_t count = 0, unused = 0;
+
+   assert(lpool_arg != NULL);
+
+   RAM_FAIL_TRAP(ramlazy_reclaim2(&count, &unused, lpool_arg, lpool_arg->ramlazyp_goal));
+   /* if i met my goal, the trash probably isn't empty yet and i need to
+    * work harder to keep up. the limit keeps the time spent here bounded by
+    * the limit plus the objects on a single page. i don't measure the
+    * trash's depth or the rate at which objects arrive: the depth counts
+    * pages rather than objects, so it says little about how much work is
+    * waiting, and a rate would need a clock read on every acquisition.
+    * whether the last goal was met costs nothing to know and reaches any
+    * backlog in logarithmically many acquisitions. */
+   if (count >= lpool_arg->ramlazyp_goal)
+   {
+      lpool_arg->ramlazyp_goal *= 2;
+      if (lpool_arg->ramlazyp_goal > lpool_arg->ramlazyp_policy.ramlazyp_maxgoal)
+         lpool_arg->ramlazyp_goal = lpool_arg->ramlazyp_policy.ramlazyp_maxgoal;
+   }
+   /* otherwise, i emptied the trash and can afford to relax. */
+   else
+      RAM_FAIL_TRAP(ramlazy_relax(lpool_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_relax(ramlazy_pool_t *lpool_arg)
+{
+   assert(lpool_arg != NULL);
+
+   lpool_arg->ramlazyp_goal /= 2;
+   if (lpool_arg->ramlazyp_goal < lpool_arg->ramlazyp_policy.ramlazyp_mingoal)
+      lpool_arg->ramlazyp_goal = lpool_arg->ramlazyp_policy.ramlazyp_mingoal;
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramlazy_release(void *ptr_arg)
 {
    ramlazy_pool_t *lpool = NULL;
@@ -116,38 +251,185 @@ ram_reply_t ramlazy_release(void *ptr_arg)
    RAM_FAIL_NOTNULL(ptr_arg);
 
    RAM_FAIL_TRAP(ramlazy_query(&lpool, &sz, ptr_arg));
+   /* i don't know which thread i'm being called from, so i have to assume
+    * that it isn't the pool's owner and that it doesn't own a pool of its
+    * own to buffer the object in. */
+   RAM_FAIL_TRAP(ramlazy_discard(lpool, ptr_arg, sz, NULL));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_discard(ramlazy_pool_t *lpool_arg, void *ptr_arg,
+      size_t size_arg, ramlazy_pool_t *caller_arg)
+{
+   ramlazy_outgoing_t *outgoing = NULL;
+   void *token = NULL;
+
+   RAM_FAIL_NOTNULL(lpool_arg);
+   RAM_FAIL_NOTNULL(ptr_arg);
+
 #if RAM_WANT_MARKFREED
-   memset(ptr_arg, RAM_WANT_MARKFREED, sz);
+   memset(ptr_arg, RAM_WANT_MARKFREED, size_arg);
+#else
+   RAMANNOTATE_UNUSEDARG(size_arg);
 #endif
-   /* i push the pointer onto the trash stack; it will be freed on it's home
-    * thread with less synchronization and contention than i could manage from 
-    * here. */
-   RAM_FAIL_TRAP(ramtra_push(&lpool->ramlazyp_trash, ptr_arg));
+   /* the owner can release the object itself. */
+   if (caller_arg == lpool_arg)
+   {
+      RAM_FAIL_TRAP(ramlazy_resume(lpool_arg));
+      RAM_FAIL_TRAP(rammux_release(ptr_arg));
+      return RAM_REPLY_OK;
+   }
+
+   /* otherwise, the object goes onto its page's remote list, to be merged
+    * on it's home thread with less synchronization and contention than i
+    * could manage from here. */
+   RAM_FAIL_TRAP(rammux_gettoken(&token, ptr_arg));
+   if (NULL == caller_arg)
+   {
+      RAM_FAIL_TRAP(ramlazy_send(token, ptr_arg, ptr_arg, lpool_arg));
+      return RAM_REPLY_OK;
+   }
+
+   /* if the calling thread has a pool of its own, i collect objects from
+    * the same page there so they can be sent in one operation. a buffer
+    * that's holding objects from another page has to be sent first. */
+   outgoing = &caller_arg->ramlazyp_outgoing[RAMLAZY_OUTGOINGINDEX(token)];
+   if (token != outgoing->ramlazyo_token)
+   {
+      RAM_FAIL_TRAP(ramlazy_sendoutgoing(outgoing));
+      outgoing->ramlazyo_token = token;
+      outgoing->ramlazyo_dest = lpool_arg;
+      outgoing->ramlazyo_last = ptr_arg;
+   }
+   assert(lpool_arg == outgoing->ramlazyo_dest);
+   *(void **)ptr_arg = outgoing->ramlazyo_first;
+   outgoing->ramlazyo_first = ptr_arg;
+   if (++outgoing->ramlazyo_count >= RAMLAZY_OUTGOINGSIZE)
+      RAM_FAIL_TRAP(ramlazy_sendoutgoing(outgoing));
 
    return RAM_REPLY_OK;
 }
 
-ram_reply_t ramlazy_reclaim(size_t *count_arg, ramlazy_pool_t *lpool_arg, size_t goal_arg)
+ram_reply_t ramlazy_send(void *token_arg, void *first_arg, void *last_arg,
+      ramlazy_pool_t *dest_arg)
+{
+   int queueflag = 0;
+
+   assert(token_arg != NULL);
+   assert(dest_arg != NULL);
+
+   RAM_FAIL_TRAP(rammux_defer(&queueflag, token_arg, first_arg, last_arg));
+   /* the page needs to be pushed onto the trash stack only if it isn't
+    * there already. */
+   if (queueflag)
+      RAM_FAIL_TRAP(ramtra_push(&dest_arg->ramlazyp_trash, token_arg));
+   /* if the owner has handed its pool off and let the trash pile up, i
+    * can reclaim some of it myself. both tests are plain loads, so a pool
+    * whose owner is around costs me nothing extra. */
+   if (NULL == dest_arg->ramlazyp_occupant
+         && RAMTRA_DEPTH(&dest_arg->ramlazyp_trash) >= (long)RAMLAZY_DELEGATEDEPTH)
+   {
+      RAM_FAIL_TRAP(ramlazy_delegate(dest_arg));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_sendoutgoing(ramlazy_outgoing_t *outgoing_arg)
+{
+   assert(outgoing_arg != NULL);
+
+   if (0 == outgoing_arg->ramlazyo_count)
+      return RAM_REPLY_OK;
+
+   RAM_FAIL_TRAP(ramlazy_send(outgoing_arg->ramlazyo_token,
+         outgoing_arg->ramlazyo_first, outgoing_arg->ramlazyo_last,
+         outgoing_arg->ramlazyo_dest));
+   memset(outgoing_arg, 0, sizeof(*outgoing_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_dispatch(ramlazy_pool_t *lpool_arg)
 {
-   ram_reply_t e = RAM_REPLY_INSANE;
-   void *p = NULL;
    size_t i = 0;
 
+   RAM_FAIL_NOTNULL(lpool_arg);
+
+   for (i = 0; i < RAMLAZY_OUTGOINGCOUNT; ++i)
+      RAM_FAIL_TRAP(ramlazy_sendoutgoing(&lpool_arg->ramlazyp_outgoing[i]));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_reserve(ramlazy_pool_t *lpool_arg, size_t size_arg, size_t count_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(lpool_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+
+   RAM_FAIL_TRAP(ramlazy_resume(lpool_arg));
+   e = rammux_reserve(&lpool_arg->ramlazyp_muxpool, size_arg, count_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_reclaim(size_t *count_arg, size_t *pages_arg, ramlazy_pool_t *lpool_arg, size_t goal_arg)
+{
    RAM_FAIL_NOTNULL(count_arg);
    *count_arg = 0;
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = 0;
    RAM_FAIL_NOTNULL(lpool_arg);
    RAM_FAIL_NOTZERO(goal_arg);
 
-   while (i < goal_arg && RAM_REPLY_OK == (e = ramtra_pop(&p, &lpool_arg->ramlazyp_trash)))
+   RAM_FAIL_TRAP(ramlazy_resume(lpool_arg));
+   RAM_FAIL_TRAP(ramlazy_reclaim2(count_arg, pages_arg, lpool_arg, goal_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_reclaim2(size_t *count_arg, size_t *pages_arg, ramlazy_pool_t *lpool_arg, size_t goal_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   void *token = NULL;
+   size_t i = 0, n = 0, pages = 0;
+   int emptyflag = 0;
+
+   assert(count_arg != NULL);
+   assert(pages_arg != NULL);
+   assert(lpool_arg != NULL);
+   assert(goal_arg > 0);
+   *count_arg = 0;
+   *pages_arg = 0;
+
+   /* the trash holds pages with objects released by other threads. each
+    * one is merged as a whole, so i might overshoot the goal. */
+   while (i < goal_arg && RAM_REPLY_OK == (e = ramtra_pop(&token, &lpool_arg->ramlazyp_trash)))
    {
-      RAM_FAIL_TRAP(rammux_release(p));
-      ++i;
+      RAM_FAIL_TRAP(rammux_merge(&n, &emptyflag, token));
+      i += n;
+      pages += (0 != emptyflag);
    }
 
    /* it's not a problem if we don't succeed in releasing 'count_arg' items. */
    if (RAM_REPLY_NOTFOUND == e || RAM_REPLY_OK == e)
    {
       *count_arg = i;
+      *pages_arg = pages;
       return RAM_REPLY_OK;
    }
    else
@@ -156,27 +438,180 @@ ram_reply_t ramlazy_reclaim(size_t *count_arg, ramlazy_pool_t *lpool_arg, size_t
 
 ram_reply_t ramlazy_flush(ramlazy_pool_t *lpool_arg)
 {
-   size_t count = 0, unused = 0;
+   size_t unused = 0;
 
    RAM_FAIL_NOTNULL(lpool_arg);
 
+   RAM_FAIL_TRAP(ramlazy_dispatch(lpool_arg));
    /* the intent is to flush the allocator but in reality, the best i can hope for
-    * is to grab an instantaneous count of the number of items in the trash and 
-    * use that as a goal for ramlazy_reclaim(). */
-   RAM_FAIL_TRAP(ramtra_size(&count, &lpool_arg->ramlazyp_trash));
-   if (count)
-      RAM_FAIL_TRAP(ramlazy_reclaim(&unused, lpool_arg, count));
+    * is to empty the trash of whatever it holds right now. other threads can keep
+    * adding to it while i'm busy, so this might not be the last word. */
+   RAM_FAIL_TRAP(ramlazy_reclaim(&unused, &unused, lpool_arg, (size_t)-1));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_handoff(ramlazy_pool_t *lpool_arg)
+{
+   RAM_FAIL_NOTNULL(lpool_arg);
+
+   if (lpool_arg->ramlazyp_handoffflag)
+      return RAM_REPLY_OK;
+
+   /* objects i'm holding for other pools would be stranded just the same
+    * as my own, so they go first. */
+   RAM_FAIL_TRAP(ramlazy_dispatch(lpool_arg));
+   lpool_arg->ramlazyp_handoffflag = 1;
+   RAM_FAIL_TRAP(ramlazy_vacate(lpool_arg, lpool_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_resume(ramlazy_pool_t *lpool_arg)
+{
+   int successflag = 0;
+
+   assert(lpool_arg != NULL);
+
+   /* this is the only test on the owner's path. the owner never gives up
+    * the pool without handing it off, so it doesn't need to touch the
+    * occupant until it comes back. */
+   if (!lpool_arg->ramlazyp_handoffflag)
+      return RAM_REPLY_OK;
+
+   /* a delegate that got here first holds the pool for one batch at most.
+    * the owner chose to hand the pool off, so it's in a position to wait
+    * that long. */
+   do
+   {
+      RAM_FAIL_TRAP(ramlazy_tryoccupy(&successflag, lpool_arg, lpool_arg));
+   }
+   while (!successflag);
+   lpool_arg->ramlazyp_handoffflag = 0;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_tryoccupy(int *successflag_arg, ramlazy_pool_t *lpool_arg, void *occupant_arg)
+{
+   assert(successflag_arg != NULL);
+   assert(lpool_arg != NULL);
+   assert(occupant_arg != NULL);
+
+   /* the exchange makes whatever the last occupant did to the pool visible
+    * to me. */
+   *successflag_arg = (NULL == ramatom_casptr(&lpool_arg->ramlazyp_occupant,
+         NULL, occupant_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_vacate(ramlazy_pool_t *lpool_arg, void *occupant_arg)
+{
+   assert(lpool_arg != NULL);
+
+   /* the exchange publishes whatever i did to the pool to whoever occupies
+    * it next. */
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, occupant_arg ==
+         ramatom_casptr(&lpool_arg->ramlazyp_occupant, occupant_arg, NULL));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_delegate(ramlazy_pool_t *lpool_arg)
+{
+   int successflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(lpool_arg != NULL);
+
+   /* if someone else is in there already, the trash is being looked after.
+    * anything they leave behind is picked up by whoever next sends objects
+    * to the pool. */
+   RAM_FAIL_TRAP(ramlazy_tryoccupy(&successflag, lpool_arg, RAMLAZY_DELEGATE));
+   if (!successflag)
+      return RAM_REPLY_OK;
+   e = ramlazy_delegate2(lpool_arg);
+   RAM_FAIL_TRAP(ramlazy_vacate(lpool_arg, RAMLAZY_DELEGATE));
+   RAM_FAIL_TRAP(e);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_delegate2(ramlazy_pool_t *lpool_arg)
+{
+   void *first = NULL, *last = NULL, *token = NULL;
+   size_t count = 0, i = 0, unused = 0;
+   int emptyflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(lpool_arg != NULL);
+
+   /* i take a single batch off the shared stack and leave the owner's end
+    * of the trash alone. i don't adapt the owner's goal either; that's a
+    * reflection of the owner's own habits. */
+   e = ramtra_take(&first, &last, &count, &lpool_arg->ramlazyp_trash);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return RAM_REPLY_OK;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   for (i = 0; NULL != first && i < RAMLAZY_DELEGATEBATCH; ++i)
+   {
+      token = first;
+      first = *(void **)first;
+      --count;
+      RAM_FAIL_TRAP(rammux_merge(&unused, &emptyflag, token));
+   }
+   /* whatever's left goes back onto the shared stack for the next delegate
+    * or the owner. */
+   if (NULL != first)
+      RAM_FAIL_TRAP(ramtra_give(&lpool_arg->ramlazyp_trash, first, last, count));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_notify(ramlazy_pool_t *lpool_arg, const ramtra_notifier_t *notifier_arg)
+{
+   RAM_FAIL_NOTNULL(lpool_arg);
+
+   RAM_FAIL_TRAP(ramtra_notify(&lpool_arg->ramlazyp_trash, notifier_arg));
 
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramlazy_chkpool(const ramlazy_pool_t *lpool_arg)
 {
-   ramlazy_chktrashnode_t ctn = {0};
+   ramlazy_pool_t *lpool = NULL;
 
    RAM_FAIL_NOTNULL(lpool_arg);
 
+   /* taking the pool back from a delegate doesn't change anything that the
+    * check looks at, so i think it's fair to cast away the const here. */
+   lpool = (ramlazy_pool_t *)lpool_arg;
+   RAM_FAIL_TRAP(ramlazy_resume(lpool));
+   RAM_FAIL_TRAP(ramlazy_chkpool2(lpool_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_chkpool2(const ramlazy_pool_t *lpool_arg)
+{
+   ramlazy_chktrashnode_t ctn = {0};
+   size_t i = 0;
+
+   assert(lpool_arg != NULL);
+
    RAM_FAIL_TRAP(rammux_chkpool(&lpool_arg->ramlazyp_muxpool));
+   for (i = 0; i < RAMLAZY_OUTGOINGCOUNT; ++i)
+      RAM_FAIL_TRAP(ramlazy_chkoutgoing(&lpool_arg->ramlazyp_outgoing[i]));
    /* now, i check the trash. i'll be able to verify each pointer in the trash is mine. */
    ctn.ramlazyctn_lazypool = lpool_arg;
    /* it should be safe to cast away the const here. 'ramtra_foreach()' doesn't modify anything
@@ -188,20 +623,49 @@ ram_reply_t ramlazy_chkpool(const ramlazy_pool_t *lpool_arg)
 
 ram_reply_t ramlazy_chktrashnode(void *ptr_arg, void *context_arg)
 {
-   ramlazy_pool_t *lazypool = NULL;
+   rammux_pool_t *muxpool = NULL;
    ramlazy_chktrashnode_t *ctn = NULL;
-   size_t unused = 0;
 
    assert(context_arg != NULL);
    ctn = (ramlazy_chktrashnode_t *)context_arg;
    assert(ctn->ramlazyctn_lazypool != NULL);
 
    RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, ptr_arg);
-   /* if an address is in the trash, i can still query it, which gives me a good way to
-    * check the trash's integrity. */
-   RAM_FAIL_TRAP(ramlazy_query(&lazypool, &unused, ptr_arg));
-   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, ctn->ramlazyctn_lazypool == lazypool);
+   /* every page in the trash should belong to me. */
+   RAM_FAIL_TRAP(rammux_querytoken(&muxpool, ptr_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+         &ctn->ramlazyctn_lazypool->ramlazyp_muxpool == muxpool);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_chkoutgoing(const ramlazy_outgoing_t *outgoing_arg)
+{
+   const void *p = NULL, *last = NULL;
+   size_t n = 0;
+
+   assert(outgoing_arg != NULL);
+
+   for (p = outgoing_arg->ramlazyo_first; NULL != p; p = *(void * const *)p)
+   {
+      last = p;
+      ++n;
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, outgoing_arg->ramlazyo_count == n);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, outgoing_arg->ramlazyo_last == last);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+         (0 == n) == (NULL == outgoing_arg->ramlazyo_token));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlazy_getgoal(size_t *goal_arg, const ramlazy_pool_t *lpool_arg)
+{
+   RAM_FAIL_NOTNULL(goal_arg);
+   *goal_arg = 0;
+   RAM_FAIL_NOTNULL(lpool_arg);
 
+   *goal_arg = lpool_arg->ramlazyp_goal;
    return RAM_REPLY_OK;
 }
 
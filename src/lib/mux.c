@@ -33,18 +33,67 @@
 
 #include <ramalloc/mux.h>
 #include "ramalloc/cast.h"
+#include <ramalloc/annotate.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/mtx.h>
+#include <assert.h>
 #include <memory.h>
 
+/* the arena hands out size class pools this many at a time. */
+#define RAMMUX_ARENACHUNKCOUNT 16
+
+/* size class pools are never given back to the system (a chunk can hold
+ * pools belonging to several mux pools), so the arena only has to carve
+ * them out of chunks. the free list holds pools that a size class turned
+ * down or that were emptied when their mux pool was taken apart; they're
+ * linked through their first word. */
+typedef struct rammux_arena
+{
+   rammtx_mutex_t rammuxa_mutex;
+   ramalgn_pool_t *rammuxa_free;
+   ramalgn_pool_t *rammuxa_next;
+   size_t rammuxa_left;
+   int rammuxa_initflag;
+} rammux_arena_t;
+
 static ramsig_signature_t rammux_thesignature = { RAMSIG_MKUINT32('M', 'U', 'X', 'P') };
+/* the size class table is generated by CMake (see cmake/sizeclass.cmake).
+ * the lookup table turns finding the class for a size into a division by a
+ * constant and a load. */
+static const size_t rammux_theclasssizes[RAMMUX_CLASSCOUNT] = RAMMUX_CLASSSIZES;
+static const uint8_t rammux_theclasslookup[RAMMUX_MAXCLASSSIZE / RAMMUX_CLASSSTEP + 1] =
+   RAMMUX_CLASSLOOKUP;
 
 static ram_reply_t rammux_mkpool2(rammux_pool_t *mpool_arg, rampg_appetite_t appetite_arg);
 static ram_reply_t rammux_getalgnpool(ramalgn_pool_t **apool_arg, size_t size_arg, rammux_pool_t *mpool_arg);
+static ram_reply_t rammux_getmuxpool(rammux_pool_t **mpool_arg, const ramalgn_pool_t *apool_arg);
+static ram_reply_t rammux_mkalgnpool(ramalgn_pool_t **apool_arg, size_t idx_arg, size_t classsz_arg, rammux_pool_t *mpool_arg);
+static ram_reply_t rammux_takealgnpool(ramalgn_pool_t **apool_arg);
+static ram_reply_t rammux_givealgnpool(ramalgn_pool_t *apool_arg);
+
+static rammux_arena_t rammux_thearena;
+/* a size class that the aligned pool turned down is marked with this
+ * pool's address, so that asking for it again doesn't cost a trip through
+ * the arena. it's never used as a pool. */
+static ramalgn_pool_t rammux_therefusal;
+
+ram_reply_t rammux_initialize()
+{
+   if (!rammux_thearena.rammuxa_initflag)
+   {
+      RAM_FAIL_TRAP(rammtx_mkmutex(&rammux_thearena.rammuxa_mutex));
+      rammux_thearena.rammuxa_initflag = 1;
+   }
+
+   return RAM_REPLY_OK;
+}
 
 ram_reply_t rammux_mkpool(rammux_pool_t *mpool_arg, rampg_appetite_t appetite_arg)
 {
    ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(mpool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rammux_thearena.rammuxa_initflag);
 
    e = rammux_mkpool2(mpool_arg, appetite_arg);
    if (RAM_REPLY_OK == e)
@@ -61,10 +110,10 @@ ram_reply_t rammux_mkpool2(rammux_pool_t *mpool_arg, rampg_appetite_t appetite_a
    assert(mpool_arg != NULL);
 
    memset(mpool_arg, 0, sizeof(*mpool_arg));
-   /* it doesn't seem like increments smaller than the address word make sense, given the
-    * amount of waste that would result. smaller sizes smaller than this should be pooled 
-    * with an array and indices instead. */
-   mpool_arg->rammuxp_step = sizeof(void *);
+#if RAM_WANT_PARTITIONED
+   /* huge pages can't be carved out of a partition. */
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, RAMOPT_GLUTTONOUS != appetite_arg);
+#endif
    mpool_arg->rammuxp_appetite = appetite_arg;
    /* the tag i put into all of my aligned pools will be a signature and my address. this
     * is intended to be enough information to make a safe cast. */
@@ -74,6 +123,71 @@ ram_reply_t rammux_mkpool2(rammux_pool_t *mpool_arg, rampg_appetite_t appetite_a
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rammux_rmpool(rammux_pool_t *mpool_arg)
+{
+   size_t i = 0;
+   int liveflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(mpool_arg);
+
+   /* a size class with objects still in use has to stay where it is. the
+    * others go back to the arena either way, which leaves the pool just as
+    * it would have been had they never been needed. */
+   for (i = 0; i < RAMMUX_MAXPOOLCOUNT; ++i)
+   {
+      if (NULL == mpool_arg->rammuxp_apools[i]
+            || &rammux_therefusal == mpool_arg->rammuxp_apools[i])
+      {
+         continue;
+      }
+      e = ramalgn_rmpool(mpool_arg->rammuxp_apools[i]);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_DISALLOWED:
+         liveflag = 1;
+         break;
+      case RAM_REPLY_OK:
+         RAM_FAIL_TRAP(rammux_givealgnpool(mpool_arg->rammuxp_apools[i]));
+         mpool_arg->rammuxp_apools[i] = NULL;
+         break;
+      }
+   }
+   if (liveflag)
+      return RAM_REPLY_DISALLOWED;
+
+   memset(mpool_arg, 0, sizeof(*mpool_arg));
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_isempty(int *emptyflag_arg, const rammux_pool_t *mpool_arg)
+{
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(emptyflag_arg);
+   *emptyflag_arg = 0;
+   RAM_FAIL_NOTNULL(mpool_arg);
+
+   for (i = 0; i < RAMMUX_MAXPOOLCOUNT; ++i)
+   {
+      if (NULL != mpool_arg->rammuxp_apools[i]
+            && &rammux_therefusal != mpool_arg->rammuxp_apools[i])
+      {
+         RAM_FAIL_TRAP(ramalgn_isempty(emptyflag_arg,
+               mpool_arg->rammuxp_apools[i]));
+         if (!*emptyflag_arg)
+            return RAM_REPLY_OK;
+      }
+   }
+
+   *emptyflag_arg = 1;
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rammux_acquire(void **newptr_arg, rammux_pool_t *mpool_arg, size_t size_arg)
 {
    ramalgn_pool_t *apool = NULL;
@@ -102,24 +216,64 @@ ram_reply_t rammux_acquire(void **newptr_arg, rammux_pool_t *mpool_arg, size_t s
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rammux_reserve(rammux_pool_t *mpool_arg, size_t size_arg, size_t count_arg)
+{
+   ramalgn_pool_t *apool = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(mpool_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+
+   /* reserving memory for a size creates the size's pool if it doesn't
+    * already exist. */
+   e = rammux_getalgnpool(&apool, size_arg, mpool_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   RAM_FAIL_TRAP(ramalgn_reserve(apool, count_arg));
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rammux_getalgnpool(ramalgn_pool_t **apool_arg, size_t size_arg, rammux_pool_t *mpool_arg)
 {
    size_t idx = 0;
+   size_t classsz = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(apool_arg);
    *apool_arg = NULL;
    RAM_FAIL_NOTZERO(size_arg);
    RAM_FAIL_NOTNULL(mpool_arg);
 
-   idx = (size_arg + mpool_arg->rammuxp_step - 1) / mpool_arg->rammuxp_step - 1;
-   /* if i can't accomidate the size of the pool, i need to inform the caller. */
-   if (idx >= RAMMUX_MAXPOOLCOUNT)
+   e = rammux_getclass(&idx, &classsz, size_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      /* if i can't accomidate the size of the pool, i need to inform the caller. */
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+   /* a class that was refused once will be refused every time. */
+   if (&rammux_therefusal == mpool_arg->rammuxp_apools[idx])
       return RAM_REPLY_RANGEFAIL;
-   if (!mpool_arg->rammuxp_initflags[idx])
+   if (NULL == mpool_arg->rammuxp_apools[idx])
    {
-      ram_reply_t e = RAM_REPLY_INSANE;
-
-      e = ramalgn_mkpool(&mpool_arg->rammuxp_apools[idx], mpool_arg->rammuxp_appetite, mpool_arg->rammuxp_step * (idx + 1), &mpool_arg->rammuxp_tag);
+      e = rammux_mkalgnpool(&mpool_arg->rammuxp_apools[idx], idx, classsz, mpool_arg);
       switch (e)
       {
       default:
@@ -127,30 +281,158 @@ ram_reply_t rammux_getalgnpool(ramalgn_pool_t **apool_arg, size_t size_arg, ramm
          /* i shouldn't ever get here. */
          return RAM_REPLY_INSANE;
       case RAM_REPLY_RANGEFAIL:
+         mpool_arg->rammuxp_apools[idx] = &rammux_therefusal;
          return e;
       case RAM_REPLY_OK:
          break;
       }
 
-      assert(mpool_arg->rammuxp_apools[idx].ramalgnp_slotpool.ramslotp_granularity >= size_arg);
-      assert(mpool_arg->rammuxp_apools[idx].ramalgnp_slotpool.ramslotp_granularity - size_arg < mpool_arg->rammuxp_step);
-      mpool_arg->rammuxp_initflags[idx] = 1;
+      assert(mpool_arg->rammuxp_apools[idx]->ramalgnp_slotpool.ramslotp_granularity >= size_arg);
+      assert(0 == idx || rammux_theclasssizes[idx - 1] < size_arg);
    }
 
-   *apool_arg = &mpool_arg->rammuxp_apools[idx];
+   *apool_arg = mpool_arg->rammuxp_apools[idx];
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_mkalgnpool(ramalgn_pool_t **apool_arg, size_t idx_arg, size_t classsz_arg, rammux_pool_t *mpool_arg)
+{
+   ramalgn_pool_t *apool = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(apool_arg != NULL);
+   assert(mpool_arg != NULL);
+
+   RAM_FAIL_TRAP(rammux_takealgnpool(&apool));
+   /* the aligned pool refuses classes that won't fit enough objects
+    * into a page, which i pass along to the caller. */
+   e = ramalgn_mkpool(apool, mpool_arg->rammuxp_appetite, classsz_arg, &mpool_arg->rammuxp_tag);
+#if RAM_WANT_PARTITIONED
+   /* the partition index doubles as the size class, which is how
+    * rammux_query() recovers the size of an object. */
+   if (RAM_REPLY_OK == e)
+      e = ramalgn_confine(apool, idx_arg);
+#else
+   RAMANNOTATE_UNUSEDARG(idx_arg);
+#endif
+   if (RAM_REPLY_OK != e)
+   {
+      /* nothing has been acquired from the pool yet, so it can go back. */
+      RAM_FAIL_TRAP(rammux_givealgnpool(apool));
+      return e;
+   }
+
+   *apool_arg = apool;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_takealgnpool(ramalgn_pool_t **apool_arg)
+{
+   ramalgn_pool_t *apool = NULL;
+
+   assert(apool_arg != NULL);
+
+   RAM_FAIL_TRAP(rammtx_wait(&rammux_thearena.rammuxa_mutex));
+   apool = rammux_thearena.rammuxa_free;
+   if (NULL != apool)
+      rammux_thearena.rammuxa_free = *(ramalgn_pool_t **)apool;
+   else
+   {
+      if (0 == rammux_thearena.rammuxa_left)
+      {
+         /* i don't release the mutex while i wait for the supplementary
+          * allocator; pools are created rarely enough that it doesn't
+          * matter. */
+         rammux_thearena.rammuxa_next = rammem_supmalloc(RAMMUX_ARENACHUNKCOUNT * sizeof(ramalgn_pool_t));
+         if (NULL != rammux_thearena.rammuxa_next)
+            rammux_thearena.rammuxa_left = RAMMUX_ARENACHUNKCOUNT;
+      }
+      if (rammux_thearena.rammuxa_left > 0)
+      {
+         apool = rammux_thearena.rammuxa_next++;
+         --rammux_thearena.rammuxa_left;
+      }
+   }
+   RAM_FAIL_PANIC(rammtx_quit(&rammux_thearena.rammuxa_mutex));
+
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != apool);
+   memset(apool, 0, sizeof(*apool));
+   *apool_arg = apool;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_givealgnpool(ramalgn_pool_t *apool_arg)
+{
+   assert(apool_arg != NULL);
+
+   RAM_FAIL_TRAP(rammtx_wait(&rammux_thearena.rammuxa_mutex));
+   *(ramalgn_pool_t **)apool_arg = rammux_thearena.rammuxa_free;
+   rammux_thearena.rammuxa_free = apool_arg;
+   RAM_FAIL_PANIC(rammtx_quit(&rammux_thearena.rammuxa_mutex));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_getclass(size_t *class_arg, size_t *classsize_arg, size_t size_arg)
+{
+   size_t idx = 0;
+
+   RAM_FAIL_NOTNULL(class_arg);
+   *class_arg = 0;
+   RAM_FAIL_NOTNULL(classsize_arg);
+   *classsize_arg = 0;
+   RAM_FAIL_NOTZERO(size_arg);
+
+   if (size_arg > RAMMUX_MAXCLASSSIZE)
+      return RAM_REPLY_RANGEFAIL;
+   idx = rammux_theclasslookup[(size_arg + RAMMUX_CLASSSTEP - 1) / RAMMUX_CLASSSTEP];
+   assert(idx < RAMMUX_CLASSCOUNT);
+   *class_arg = idx;
+   *classsize_arg = rammux_theclasssizes[idx];
+
    return RAM_REPLY_OK;
 }
 
 ram_reply_t rammux_chkpool(const rammux_pool_t *mpool_arg)
 {
+   rammux_pool_t *mpool = NULL;
    size_t i = 0;
 
+   RAM_FAIL_NOTNULL(mpool_arg);
+
    for (i = 0; i < RAMMUX_MAXPOOLCOUNT; ++i)
    {
-      if (mpool_arg->rammuxp_initflags[i])
-         RAM_FAIL_TRAP(ramalgn_chkpool(&mpool_arg->rammuxp_apools[i]));
+      if (NULL != mpool_arg->rammuxp_apools[i]
+            && &rammux_therefusal != mpool_arg->rammuxp_apools[i])
+      {
+         RAM_FAIL_TRAP(ramalgn_chkpool(mpool_arg->rammuxp_apools[i]));
+         /* a pool from the arena must still be tagged as mine. */
+         RAM_FAIL_TRAP(rammux_getmuxpool(&mpool, mpool_arg->rammuxp_apools[i]));
+         RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, mpool_arg == mpool);
+      }
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_getfootprint(size_t *bytes_arg, const rammux_pool_t *mpool_arg)
+{
+   size_t i = 0, n = 0;
+
+   RAM_FAIL_NOTNULL(bytes_arg);
+   *bytes_arg = 0;
+   RAM_FAIL_NOTNULL(mpool_arg);
+
+   for (i = 0; i < RAMMUX_MAXPOOLCOUNT; ++i)
+   {
+      if (NULL != mpool_arg->rammuxp_apools[i]
+            && &rammux_therefusal != mpool_arg->rammuxp_apools[i])
+      {
+         ++n;
+      }
    }
 
+   *bytes_arg = sizeof(*mpool_arg) + n * sizeof(ramalgn_pool_t);
    return RAM_REPLY_OK;
 }
 
@@ -158,8 +440,9 @@ ram_reply_t rammux_query(rammux_pool_t **mpool_arg, size_t *size_arg, void *ptr_
 {
    ramalgn_pool_t *apool = NULL;
    ram_reply_t e = RAM_REPLY_INSANE;
-   const ramalgn_tag_t *tag = NULL;
-   ramsig_signature_t sig = {0};
+#if RAM_WANT_PARTITIONED
+   size_t partition = 0;
+#endif
 
    RAM_FAIL_NOTNULL(mpool_arg);
    *mpool_arg = NULL;
@@ -167,6 +450,23 @@ ram_reply_t rammux_query(rammux_pool_t **mpool_arg, size_t *size_arg, void *ptr_
    *size_arg = 0;
    RAM_FAIL_NOTNULL(ptr_arg);
 
+#if RAM_WANT_PARTITIONED
+   /* an address outside of the partitioned range can't belong to me, which
+    * i can determine without consulting the ownership map. */
+   e = ramvas_locate(&partition, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+#endif
+
    e = ramalgn_query(&apool, ptr_arg);
    switch (e)
    {
@@ -180,9 +480,54 @@ ram_reply_t rammux_query(rammux_pool_t **mpool_arg, size_t *size_arg, void *ptr_
       break;
    }
 
-   RAM_FAIL_TRAP(ramalgn_gettag(&tag, apool));
+   e = rammux_getmuxpool(mpool_arg, apool);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+#if RAM_WANT_PARTITIONED
+   *size_arg = rammux_theclasssizes[partition];
+#else
+   RAM_FAIL_TRAP(ramalgn_getgranularity(size_arg, apool));
+#endif
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_querytoken(rammux_pool_t **mpool_arg, void *token_arg)
+{
+   ramalgn_pool_t *apool = NULL;
+
+   RAM_FAIL_NOTNULL(mpool_arg);
+   *mpool_arg = NULL;
+   RAM_FAIL_NOTNULL(token_arg);
+
+   RAM_FAIL_TRAP(ramalgn_querytoken(&apool, token_arg));
+   /* a token can only come from one of my own pools. */
+   RAM_FAIL_TRAP(rammux_getmuxpool(mpool_arg, apool));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rammux_getmuxpool(rammux_pool_t **mpool_arg, const ramalgn_pool_t *apool_arg)
+{
+   const ramalgn_tag_t *tag = NULL;
+   ramsig_signature_t sig = {0};
+
+   assert(mpool_arg != NULL);
+   assert(apool_arg != NULL);
+
+   RAM_FAIL_TRAP(ramalgn_gettag(&tag, apool_arg));
    /* i use the signature in the first half of the tag to increase the possibility that
-    * an invalid address in 'ptr_arg' won't crash the process when someone attempts to dereference
+    * an aligned pool that isn't mine won't crash the process when someone attempts to dereference
     * the pointer that i expect to contain the mux pool.
     * note: `size_t` and `uintptr_t` should be identical types. */
    RAM_FAIL_TRAP(ram_cast_sztou32(&sig.ramsigs_n, tag->ramalgnt_values[0]));
@@ -191,8 +536,6 @@ ram_reply_t rammux_query(rammux_pool_t **mpool_arg, size_t *size_arg, void *ptr_
    if (0 != RAMSIG_CMP(sig, rammux_thesignature))
       return RAM_REPLY_NOTFOUND;
 
-   RAM_FAIL_TRAP(ramalgn_getgranularity(size_arg, apool));
    *mpool_arg = (rammux_pool_t *)tag->ramalgnt_values[1];
-
    return RAM_REPLY_OK;
 }
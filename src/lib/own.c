@@ -0,0 +1,191 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include <ramalloc/own.h>
+#include <ramalloc/atom.h>
+#include <ramalloc/mem.h>
+#include <assert.h>
+#include <memory.h>
+
+#define RAMOWN_MASK (RAMOWN_FANOUT - 1)
+#define RAMOWN_ROOTINDEX(PageNum) ((PageNum) >> (2 * RAMOWN_FANOUTBITS))
+#define RAMOWN_BRANCHINDEX(PageNum) \
+   (((PageNum) >> RAMOWN_FANOUTBITS) & RAMOWN_MASK)
+#define RAMOWN_LEAFINDEX(PageNum) ((PageNum) & RAMOWN_MASK)
+
+typedef struct ramown_globals
+{
+   unsigned int ramowng_pageshift;
+   int ramowng_initflag;
+} ramown_globals_t;
+
+static ram_reply_t ramown_getchild(void * volatile **child_arg,
+      void * volatile *entry_arg);
+
+static ramown_globals_t ramown_theglobals;
+
+ram_reply_t ramown_initialize()
+{
+   if (!ramown_theglobals.ramowng_initflag)
+   {
+      ramown_globals_t stage = {0};
+      size_t pgsz = 0;
+
+      RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+      /* i depend upon the page size being a power of two. */
+      RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, 0 == (pgsz & (pgsz - 1)));
+      while (((size_t)1 << stage.ramowng_pageshift) < pgsz)
+         ++stage.ramowng_pageshift;
+      RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+            stage.ramowng_pageshift >= RAMOWN_MINPAGEBITS);
+      stage.ramowng_initflag = 1;
+
+      ramown_theglobals = stage;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramown_set(ramown_map_t *map_arg, const void *page_arg,
+      void *owner_arg)
+{
+   uintptr_t pgnum = 0;
+   void * volatile *branch = NULL;
+   void * volatile *leaf = NULL;
+
+   RAM_FAIL_NOTNULL(map_arg);
+   RAM_FAIL_NOTNULL(page_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramown_theglobals.ramowng_initflag);
+
+   pgnum = (uintptr_t)page_arg >> ramown_theglobals.ramowng_pageshift;
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL,
+         RAMOWN_ROOTINDEX(pgnum) < RAMOWN_ROOTCOUNT);
+   RAM_FAIL_TRAP(ramown_getchild(&branch,
+         &map_arg->ramownm_root[RAMOWN_ROOTINDEX(pgnum)]));
+   RAM_FAIL_TRAP(ramown_getchild(&leaf,
+         &branch[RAMOWN_BRANCHINDEX(pgnum)]));
+   /* a page only has one owner at a time, so i don't need to synchronize
+    * anything here. */
+   leaf[RAMOWN_LEAFINDEX(pgnum)] = owner_arg;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramown_get(void **owner_arg, const ramown_map_t *map_arg,
+      const void *ptr_arg)
+{
+   uintptr_t pgnum = 0;
+   void * volatile *branch = NULL;
+   void * volatile *leaf = NULL;
+   void *owner = NULL;
+
+   RAM_FAIL_NOTNULL(owner_arg);
+   *owner_arg = NULL;
+   RAM_FAIL_NOTNULL(map_arg);
+   assert(ramown_theglobals.ramowng_initflag);
+
+   /* anything the map doesn't know about is considered an expected
+    * failure, since this is how i tell whether an address belongs to
+    * someone else. */
+   pgnum = (uintptr_t)ptr_arg >> ramown_theglobals.ramowng_pageshift;
+   if (RAMOWN_ROOTINDEX(pgnum) >= RAMOWN_ROOTCOUNT)
+      return RAM_REPLY_NOTFOUND;
+   branch = (void * volatile *)map_arg->ramownm_root[RAMOWN_ROOTINDEX(pgnum)];
+   if (NULL == branch)
+      return RAM_REPLY_NOTFOUND;
+   leaf = (void * volatile *)branch[RAMOWN_BRANCHINDEX(pgnum)];
+   if (NULL == leaf)
+      return RAM_REPLY_NOTFOUND;
+   owner = leaf[RAMOWN_LEAFINDEX(pgnum)];
+   if (NULL == owner)
+      return RAM_REPLY_NOTFOUND;
+
+   *owner_arg = owner;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramown_getfootprint(size_t *bytes_arg, const ramown_map_t *map_arg)
+{
+   size_t i = 0, j = 0, n = 0;
+   void * volatile *branch = NULL;
+
+   RAM_FAIL_NOTNULL(bytes_arg);
+   *bytes_arg = 0;
+   RAM_FAIL_NOTNULL(map_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramown_theglobals.ramowng_initflag);
+
+   for (i = 0; i < RAMOWN_ROOTCOUNT; ++i)
+   {
+      branch = (void * volatile *)map_arg->ramownm_root[i];
+      if (NULL == branch)
+         continue;
+      ++n;
+      for (j = 0; j < RAMOWN_FANOUT; ++j)
+      {
+         if (NULL != branch[j])
+            ++n;
+      }
+   }
+
+   *bytes_arg = n * RAMOWN_FANOUT * sizeof(void *);
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramown_getchild(void * volatile **child_arg,
+      void * volatile *entry_arg)
+{
+   void * volatile *child = NULL;
+   void *prev = NULL;
+
+   assert(child_arg != NULL);
+   assert(entry_arg != NULL);
+
+   child = (void * volatile *)*entry_arg;
+   if (NULL == child)
+   {
+      child = rammem_supmalloc(RAMOWN_FANOUT * sizeof(void *));
+      RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != child);
+      memset((void *)child, 0, RAMOWN_FANOUT * sizeof(void *));
+      /* if another thread beat me to it, i use its child instead. */
+      prev = ramatom_casptr(entry_arg, NULL, (void *)child);
+      if (NULL != prev)
+      {
+         rammem_supfree((void *)child);
+         child = (void * volatile *)prev;
+      }
+   }
+
+   *child_arg = child;
+   return RAM_REPLY_OK;
+}
@@ -34,26 +34,57 @@
 #include <ramalloc/para.h>
 #include <ramalloc/mem.h>
 #include <ramalloc/cast.h>
+#include <ramalloc/rcy.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/atom.h>
+#include <ramalloc/want.h>
 #include <string.h>
 
 typedef struct rampara_tls
 {
    rampara_pool_t *ramparat_backref;
    ramlazy_pool_t ramparat_lazypool;
+   /* links the pool into 'ramparap_orphans' while it has no thread. */
+   ramlist_list_t ramparat_orphanage;
+   /* copies of the notifiers the thread registered. the trash keeps a
+    * pointer to one of them; see rampara_notify(). */
+   ramtra_notifier_t ramparat_notifiers[2];
+   size_t ramparat_notifierindex;
 } rampara_tls_t;
 
-static ram_reply_t rampara_mkpool2(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg);
+#if RAM_WANT_COMPILERTLS
+/* the pool the calling thread used last is remembered here, so that it
+ * doesn't have to ask the threading library for it every time. the key is
+ * still needed, since it's what orphans a thread's pool when the thread
+ * exits. */
+typedef struct rampara_cache
+{
+   long ramparac_serial;
+   rampara_tls_t *ramparac_tls;
+} rampara_cache_t;
+
+static RAMSYS_THREADLOCAL rampara_cache_t rampara_thecache;
+#endif
+
+static ramatom_counter_t rampara_theserial = 0;
+
+static ram_reply_t rampara_mkpool2(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg);
 static ram_reply_t rampara_mktls(rampara_tls_t **newtls_arg, rampara_pool_t *parapool_arg);
 static ram_reply_t rampara_rcltls(rampara_tls_t **tls_arg, rampara_pool_t *parapool_arg);
 static ram_reply_t rampara_querytls(rampara_tls_t **tls_arg, size_t *size_arg, void *ptr_arg);
+static void RAMSYS_TLSDTORDECL rampara_orphan(void *tls_arg);
+static ram_reply_t rampara_orphan2(rampara_tls_t *tls_arg);
+static ram_reply_t rampara_adopt(rampara_tls_t **tls_arg, rampara_pool_t *parapool_arg, rampara_tls_t *orphan_arg);
+static ram_reply_t rampara_takeorphan(rampara_tls_t **tls_arg, rampara_pool_t *parapool_arg, rampara_tls_t *orphan_arg);
+static ram_reply_t rampara_rmorphans(rampara_pool_t *parapool_arg);
 
-ram_reply_t rampara_mkpool(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg)
+ram_reply_t rampara_mkpool(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg)
 {
    ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(parapool_arg);
 
-   e = rampara_mkpool2(parapool_arg, appetite_arg, disposalratio_arg);
+   e = rampara_mkpool2(parapool_arg, appetite_arg, policy_arg);
    if (RAM_REPLY_OK == e)
       return RAM_REPLY_OK;
    else
@@ -63,23 +94,74 @@ ram_reply_t rampara_mkpool(rampara_pool_t *parapool_arg, rampg_appetite_t appeti
    }
 }
 
-ram_reply_t rampara_mkpool2(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, size_t disposalratio_arg)
+ram_reply_t rampara_mkpool2(rampara_pool_t *parapool_arg, rampg_appetite_t appetite_arg, const ramlazy_policy_t *policy_arg)
 {
    assert(parapool_arg != NULL);
-   RAM_FAIL_NOTZERO(disposalratio_arg);
+   RAM_FAIL_NOTNULL(policy_arg);
 
-   RAM_FAIL_TRAP(ramtls_mkkey(&parapool_arg->ramparap_tlskey));
+   RAM_FAIL_TRAP(ramlist_mklist(&parapool_arg->ramparap_orphans));
+   RAM_FAIL_TRAP(rammtx_mkmutex(&parapool_arg->ramparap_mutex));
+   RAM_FAIL_TRAP(ramtls_mkkey(&parapool_arg->ramparap_tlskey, &rampara_orphan));
    parapool_arg->ramparap_appetite = appetite_arg;
-   parapool_arg->ramparap_reclaimratio = disposalratio_arg;
+   parapool_arg->ramparap_policy = *policy_arg;
+   /* a serial number of 0 is never issued, so that it never matches an
+    * empty cache. */
+   parapool_arg->ramparap_serial = ramatom_xadd(&rampara_theserial, 1) + 1;
 
    return RAM_REPLY_OK;
 }
 
 ram_reply_t rampara_rmpool(rampara_pool_t *parapool_arg)
 {
+   void *tls = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
    RAM_FAIL_NOTNULL(parapool_arg);
 
+   RAM_FAIL_TRAP(rammtx_wait(&parapool_arg->ramparap_mutex));
+   e = rampara_rmorphans(parapool_arg);
+   RAM_FAIL_PANIC(rammtx_quit(&parapool_arg->ramparap_mutex));
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_DISALLOWED:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+   /* the calling thread's own pool goes last, so that it's still stored
+    * under the key if something else is in use. pools that belong to
+    * threads that are still running are the caller's problem. */
+   RAM_FAIL_TRAP(ramtls_rcl(&tls, parapool_arg->ramparap_tlskey));
+   if (NULL != tls)
+   {
+      e = ramlazy_rmpool(&((rampara_tls_t *)tls)->ramparat_lazypool);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_DISALLOWED:
+         return e;
+      case RAM_REPLY_OK:
+         break;
+      }
+#if RAM_WANT_COMPILERTLS
+      if (tls == rampara_thecache.ramparac_tls)
+      {
+         rampara_thecache.ramparac_serial = 0;
+         rampara_thecache.ramparac_tls = NULL;
+      }
+#endif
+      rammem_supfree(tls);
+   }
+
    RAM_FAIL_TRAP(ramtls_rmkey(parapool_arg->ramparap_tlskey));
+   RAM_FAIL_TRAP(rammtx_rmmutex(&parapool_arg->ramparap_mutex));
    memset(parapool_arg, 0, sizeof(*parapool_arg));
 
    return RAM_REPLY_OK;
@@ -112,9 +194,92 @@ ram_reply_t rampara_acquire(void **newptr_arg, rampara_pool_t *parapool_arg, siz
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rampara_release(void *ptr_arg)
+{
+   rampara_tls_t *tls = NULL;
+   void *mine = NULL;
+   ramlazy_pool_t *caller = NULL;
+   size_t sz = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(ptr_arg);
+
+   /* the caller might be asking every allocator in turn whether the object
+    * is theirs, so i'll only say that it isn't mine. */
+   e = rampara_querytls(&tls, &sz, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+   /* if the object came from the calling thread's own pool, it can skip
+    * the trash; otherwise, the calling thread's pool can buffer it. i don't
+    * want to create a pool for a thread that doesn't have one yet, so i
+    * don't use rampara_rcltls() here. */
+#if RAM_WANT_COMPILERTLS
+   if (tls->ramparat_backref->ramparap_serial
+         == rampara_thecache.ramparac_serial)
+      mine = rampara_thecache.ramparac_tls;
+   else
+#endif
+   {
+      RAM_FAIL_TRAP(ramtls_rcl(&mine,
+            tls->ramparat_backref->ramparap_tlskey));
+   }
+   /* a thread without a pool of its own that's discarding into an orphan
+    * might as well adopt it. that makes this the orphan's owner, so the
+    * object is released immediately. a glance at the orphan's links is
+    * enough to tell me whether it's worth taking the mutex. */
+   if (NULL == mine
+         && &tls->ramparat_orphanage != tls->ramparat_orphanage.ramlistl_next)
+   {
+      RAM_FAIL_TRAP(rampara_adopt((rampara_tls_t **)&mine,
+            tls->ramparat_backref, tls));
+   }
+   if (NULL != mine)
+      caller = &((rampara_tls_t *)mine)->ramparat_lazypool;
+   RAM_FAIL_TRAP(ramlazy_discard(&tls->ramparat_lazypool, ptr_arg, sz,
+         caller));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_reserve(rampara_pool_t *parapool_arg, size_t size_arg, size_t count_arg)
+{
+   rampara_tls_t *tls = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(parapool_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+
+   /* reservations are made in the calling thread's pool. */
+   RAM_FAIL_TRAP(rampara_rcltls(&tls, parapool_arg));
+   e = ramlazy_reserve(&tls->ramparat_lazypool, size_arg, count_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rampara_reclaim(size_t *count_arg, rampara_pool_t *parapool_arg, size_t goal_arg)
 {
    rampara_tls_t *tls = NULL;
+   size_t unused = 0;
 
    RAM_FAIL_NOTNULL(count_arg);
    *count_arg = 0;
@@ -122,11 +287,62 @@ ram_reply_t rampara_reclaim(size_t *count_arg, rampara_pool_t *parapool_arg, siz
    RAM_FAIL_NOTZERO(goal_arg);
 
    RAM_FAIL_TRAP(rampara_rcltls(&tls, parapool_arg));
-   RAM_FAIL_TRAP(ramlazy_reclaim(count_arg, &tls->ramparat_lazypool, goal_arg));
+   /* objects this thread released on behalf of other threads are sent on
+    * their way before i reclaim what's been sent to me. */
+   RAM_FAIL_TRAP(ramlazy_dispatch(&tls->ramparat_lazypool));
+   RAM_FAIL_TRAP(ramlazy_reclaim(count_arg, &unused, &tls->ramparat_lazypool, goal_arg));
 
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rampara_reclaimfor(rampara_reclaimstats_t *stats_arg, rampara_pool_t *parapool_arg, uint64_t budget_arg)
+{
+   rampara_tls_t *tls = NULL;
+   uint64_t start = 0, now = 0;
+   size_t count = 0, pages = 0;
+
+   RAM_FAIL_NOTNULL(stats_arg);
+   memset(stats_arg, 0, sizeof(*stats_arg));
+   RAM_FAIL_NOTNULL(parapool_arg);
+
+   RAM_FAIL_TRAP(ramsys_clock(&start));
+   now = start;
+   RAM_FAIL_TRAP(rampara_rcltls(&tls, parapool_arg));
+   RAM_FAIL_TRAP(ramlazy_dispatch(&tls->ramparat_lazypool));
+
+   /* reading the clock isn't free, so i only look at it once per batch. the
+    * trash has run dry when a batch comes up short. */
+   do
+   {
+      RAM_FAIL_TRAP(ramlazy_reclaim(&count, &pages, &tls->ramparat_lazypool,
+            RAMPARA_RECLAIMBATCH));
+      stats_arg->ramparars_objects += count;
+      stats_arg->ramparars_pages += pages;
+      RAM_FAIL_TRAP(ramsys_clock(&now));
+   }
+   while (count >= RAMPARA_RECLAIMBATCH && now - start < budget_arg);
+
+   /* whatever time remains is spent returning retained reservations to the
+    * system. */
+   if (count < RAMPARA_RECLAIMBATCH)
+   {
+      while (now - start < budget_arg)
+      {
+         RAM_FAIL_TRAP(ramrcy_shed(&count, RAMPARA_RECLAIMBATCH));
+         stats_arg->ramparars_reservations += count;
+         RAM_FAIL_TRAP(ramsys_clock(&now));
+         if (count < RAMPARA_RECLAIMBATCH)
+         {
+            stats_arg->ramparars_complete = 1;
+            break;
+         }
+      }
+   }
+
+   stats_arg->ramparars_elapsed = now - start;
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rampara_flush(rampara_pool_t *parapool_arg)
 {
    rampara_tls_t *tls = NULL;
@@ -139,6 +355,45 @@ ram_reply_t rampara_flush(rampara_pool_t *parapool_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rampara_handoff(rampara_pool_t *parapool_arg)
+{
+   rampara_tls_t *tls = NULL;
+
+   RAM_FAIL_NOTNULL(parapool_arg);
+
+   RAM_FAIL_TRAP(rampara_rcltls(&tls, parapool_arg));
+   RAM_FAIL_TRAP(ramlazy_handoff(&tls->ramparat_lazypool));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_notify(rampara_pool_t *parapool_arg, const ramtra_notifier_t *notifier_arg)
+{
+   rampara_tls_t *tls = NULL;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(parapool_arg);
+
+   RAM_FAIL_TRAP(rampara_rcltls(&tls, parapool_arg));
+   if (NULL == notifier_arg)
+   {
+      RAM_FAIL_TRAP(ramlazy_notify(&tls->ramparat_lazypool, NULL));
+      return RAM_REPLY_OK;
+   }
+
+   /* the caller's notifier is copied so that it needn't outlive this call.
+    * a thread that's pushing onto the trash might still be reading the copy
+    * that's registered now, so i write the new one into the other slot
+    * rather than changing the old one underneath it. */
+   i = (tls->ramparat_notifierindex + 1) % 2;
+   tls->ramparat_notifiers[i] = *notifier_arg;
+   RAM_FAIL_TRAP(ramlazy_notify(&tls->ramparat_lazypool,
+         &tls->ramparat_notifiers[i]));
+   tls->ramparat_notifierindex = i;
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rampara_chkpool(const rampara_pool_t *parapool_arg)
 {
    rampara_tls_t *tls = NULL;
@@ -181,6 +436,102 @@ ram_reply_t rampara_query(rampara_pool_t **parapool_arg, size_t *size_arg, void
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rampara_mkheap(rampara_heap_t **heap_arg, rampara_pool_t *parapool_arg)
+{
+   rampara_tls_t *tls = NULL;
+
+   RAM_FAIL_NOTNULL(heap_arg);
+   *heap_arg = NULL;
+   RAM_FAIL_NOTNULL(parapool_arg);
+
+   /* a heap is made the same way as a thread's pool, except that it isn't
+    * stored under the pool's key. an orphan will do just as well. */
+   RAM_FAIL_TRAP(rampara_takeorphan(&tls, parapool_arg, NULL));
+   if (NULL == tls)
+      RAM_FAIL_TRAP(rampara_mktls(&tls, parapool_arg));
+
+   *heap_arg = tls;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_rmheap(rampara_heap_t *heap_arg)
+{
+   RAM_FAIL_NOTNULL(heap_arg);
+
+   RAM_FAIL_TRAP(rampara_orphan2(heap_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_heapacquire(void **newptr_arg, rampara_heap_t *heap_arg, size_t size_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(newptr_arg);
+   *newptr_arg = NULL;
+   RAM_FAIL_NOTNULL(heap_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+
+   e = ramlazy_acquire(newptr_arg, &heap_arg->ramparat_lazypool, size_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_heapdiscard(rampara_heap_t *heap_arg, void *ptr_arg)
+{
+   rampara_tls_t *tls = NULL;
+   size_t sz = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(heap_arg);
+   RAM_FAIL_NOTNULL(ptr_arg);
+
+   /* like rampara_release(), i only say whether the object is mine. */
+   e = rampara_querytls(&tls, &sz, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+   RAM_FAIL_TRAP(ramlazy_discard(&tls->ramparat_lazypool, ptr_arg, sz,
+         &heap_arg->ramparat_lazypool));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_heapreclaim(size_t *count_arg, rampara_heap_t *heap_arg, size_t goal_arg)
+{
+   size_t unused = 0;
+
+   RAM_FAIL_NOTNULL(count_arg);
+   *count_arg = 0;
+   RAM_FAIL_NOTNULL(heap_arg);
+   RAM_FAIL_NOTZERO(goal_arg);
+
+   RAM_FAIL_TRAP(ramlazy_dispatch(&heap_arg->ramparat_lazypool));
+   RAM_FAIL_TRAP(ramlazy_reclaim(count_arg, &unused,
+         &heap_arg->ramparat_lazypool, goal_arg));
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rampara_mktls(rampara_tls_t **newtls_arg, rampara_pool_t *parapool_arg)
 {
    rampara_tls_t *p = NULL;
@@ -198,7 +549,8 @@ ram_reply_t rampara_mktls(rampara_tls_t **newtls_arg, rampara_pool_t *parapool_a
    RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, p != NULL);
    memset(p, 0, sizeof(*p));
    p->ramparat_backref = parapool_arg;
-   e = ramlazy_mkpool(&p->ramparat_lazypool, parapool_arg->ramparap_appetite, parapool_arg->ramparap_reclaimratio);
+   RAM_FAIL_TRAP(ramlist_mklist(&p->ramparat_orphanage));
+   e = ramlazy_mkpool(&p->ramparat_lazypool, parapool_arg->ramparap_appetite, &parapool_arg->ramparap_policy);
    if (RAM_REPLY_OK == e)
    {
       *newtls_arg = p;
@@ -220,15 +572,34 @@ ram_reply_t rampara_rcltls(rampara_tls_t **tls_arg, rampara_pool_t *parapool_arg
    *tls_arg = NULL;
    RAM_FAIL_NOTNULL(parapool_arg);
 
+#if RAM_WANT_COMPILERTLS
+   if (parapool_arg->ramparap_serial == rampara_thecache.ramparac_serial
+         && NULL != rampara_thecache.ramparac_tls)
+   {
+      *tls_arg = rampara_thecache.ramparac_tls;
+      return RAM_REPLY_OK;
+   }
+#endif
+
    RAM_FAIL_TRAP(ramtls_rcl(&p, parapool_arg->ramparap_tlskey));
    tls = (rampara_tls_t *)p;
    if (NULL == tls)
    {
-      /* BUG: the pool is leaked here if ramtls_sto() fails-- also when threads are destroyed. */
-      RAM_FAIL_TRAP(rampara_mktls(&tls, parapool_arg));
-      RAM_FAIL_TRAP(ramtls_sto(parapool_arg->ramparap_tlskey, tls));
+      /* a pool left behind by a thread that exited is as good as a new
+       * one. */
+      RAM_FAIL_TRAP(rampara_adopt(&tls, parapool_arg, NULL));
+      if (NULL == tls)
+      {
+         /* BUG: the pool is leaked here if ramtls_sto() fails. */
+         RAM_FAIL_TRAP(rampara_mktls(&tls, parapool_arg));
+         RAM_FAIL_TRAP(ramtls_sto(parapool_arg->ramparap_tlskey, tls));
+      }
    }
 
+#if RAM_WANT_COMPILERTLS
+   rampara_thecache.ramparac_serial = parapool_arg->ramparap_serial;
+   rampara_thecache.ramparac_tls = tls;
+#endif
    *tls_arg = tls;
    return RAM_REPLY_OK;
 }
@@ -259,3 +630,152 @@ ram_reply_t rampara_querytls(rampara_tls_t **tls_arg, size_t *size_arg, void *pt
          lazypool);
    return RAM_REPLY_OK;
 }
+
+void RAMSYS_TLSDTORDECL rampara_orphan(void *tls_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   /* there's nobody to report a failure to when a thread exits. i can't
+    * use RAM_FAIL_PANIC() here because it expects to be able to return a
+    * reply. */
+   e = rampara_orphan2((rampara_tls_t *)tls_arg);
+   if (RAM_REPLY_OK != e)
+      ram_fail_panic("i failed to orphan an exiting thread's pool.");
+}
+
+ram_reply_t rampara_orphan2(rampara_tls_t *tls_arg)
+{
+   rampara_pool_t *parapool = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(tls_arg);
+   parapool = tls_arg->ramparat_backref;
+   RAM_FAIL_NOTNULL(parapool);
+
+   /* the thread's outgoing buffers are sent on their way and whatever's
+    * in its trash is reclaimed, so that the orphan holds only objects that
+    * are still in use. anything discarded into it from now on is either
+    * reclaimed by a delegate or by whoever adopts it; handing the pool off
+    * is what lets delegates in. */
+   RAM_FAIL_TRAP(ramlazy_flush(&tls_arg->ramparat_lazypool));
+   RAM_FAIL_TRAP(ramlazy_handoff(&tls_arg->ramparat_lazypool));
+   /* the thread's notifier was meant for the thread. its context might not
+    * outlive it, and whoever adopts the pool can register their own. */
+   RAM_FAIL_TRAP(ramlazy_notify(&tls_arg->ramparat_lazypool, NULL));
+#if RAM_WANT_COMPILERTLS
+   /* the exiting thread mustn't find its pool in the cache if it
+    * allocates again from another key's destructor. */
+   if (tls_arg == rampara_thecache.ramparac_tls)
+   {
+      rampara_thecache.ramparac_serial = 0;
+      rampara_thecache.ramparac_tls = NULL;
+   }
+#endif
+
+   RAM_FAIL_TRAP(rammtx_wait(&parapool->ramparap_mutex));
+   e = ramlist_splice(&parapool->ramparap_orphans,
+         &tls_arg->ramparat_orphanage);
+   RAM_FAIL_PANIC(rammtx_quit(&parapool->ramparap_mutex));
+   RAM_FAIL_TRAP(e);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_adopt(rampara_tls_t **tls_arg, rampara_pool_t *parapool_arg, rampara_tls_t *orphan_arg)
+{
+   rampara_tls_t *tls = NULL;
+
+   assert(tls_arg != NULL);
+   assert(parapool_arg != NULL);
+   *tls_arg = NULL;
+
+   RAM_FAIL_TRAP(rampara_takeorphan(&tls, parapool_arg, orphan_arg));
+   if (NULL != tls)
+   {
+      RAM_FAIL_TRAP(ramtls_sto(parapool_arg->ramparap_tlskey, tls));
+      *tls_arg = tls;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_takeorphan(rampara_tls_t **tls_arg, rampara_pool_t *parapool_arg, rampara_tls_t *orphan_arg)
+{
+   ramlist_list_t *node = NULL, *unused = NULL;
+   rampara_tls_t *tls = NULL;
+   int hastail = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(tls_arg != NULL);
+   assert(parapool_arg != NULL);
+   *tls_arg = NULL;
+
+   /* if i'm not given a specific orphan to adopt, i take whichever one has
+    * been waiting the longest. i need to check that a specific orphan is
+    * still available once i have the mutex. */
+   RAM_FAIL_TRAP(rammtx_wait(&parapool_arg->ramparap_mutex));
+   if (NULL == orphan_arg)
+      node = parapool_arg->ramparap_orphans.ramlistl_prev;
+   else
+   {
+      e = ramlist_hastail(&hastail, &orphan_arg->ramparat_orphanage);
+      if (RAM_REPLY_OK != e)
+      {
+         RAM_FAIL_PANIC(rammtx_quit(&parapool_arg->ramparap_mutex));
+         RAM_FAIL_TRAP(e);
+      }
+      node = hastail ? &orphan_arg->ramparat_orphanage : NULL;
+   }
+   if (NULL != node && &parapool_arg->ramparap_orphans != node)
+   {
+      e = ramlist_pop(&unused, node);
+      if (RAM_REPLY_OK != e)
+      {
+         RAM_FAIL_PANIC(rammtx_quit(&parapool_arg->ramparap_mutex));
+         RAM_FAIL_TRAP(e);
+      }
+      tls = RAM_CAST_STRUCTBASE(rampara_tls_t, ramparat_orphanage, node);
+   }
+   RAM_FAIL_PANIC(rammtx_quit(&parapool_arg->ramparap_mutex));
+
+   *tls_arg = tls;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampara_rmorphans(rampara_pool_t *parapool_arg)
+{
+   ramlist_list_t *node = NULL, *next = NULL, *unused = NULL;
+   rampara_tls_t *tls = NULL;
+   int liveflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(parapool_arg != NULL);
+
+   /* the caller holds the mutex. an orphan with objects still in use is
+    * handed off again and left where it is, so that the objects can still
+    * be released into it; every other orphan is taken apart. */
+   for (node = parapool_arg->ramparap_orphans.ramlistl_next;
+         &parapool_arg->ramparap_orphans != node; node = next)
+   {
+      RAM_FAIL_TRAP(ramlist_next(&next, node));
+      tls = RAM_CAST_STRUCTBASE(rampara_tls_t, ramparat_orphanage, node);
+      e = ramlazy_rmpool(&tls->ramparat_lazypool);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_DISALLOWED:
+         RAM_FAIL_TRAP(ramlazy_handoff(&tls->ramparat_lazypool));
+         liveflag = 1;
+         break;
+      case RAM_REPLY_OK:
+         RAM_FAIL_TRAP(ramlist_pop(&unused, node));
+         rammem_supfree(tls);
+         break;
+      }
+   }
+
+   return liveflag ? RAM_REPLY_DISALLOWED : RAM_REPLY_OK;
+}
@@ -32,23 +32,52 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
 
 #include <ramalloc/pg.h>
-#include <ramalloc/foot.h>
+#include <ramalloc/own.h>
 #include <ramalloc/sys.h>
 #include <ramalloc/slot.h>
+#include <ramalloc/rcy.h>
+#include <ramalloc/vas.h>
 #include <ramalloc/mem.h>
+#include <ramalloc/mtx.h>
+#include <ramalloc/list.h>
 #include <ramalloc/cast.h>
+#include <ramalloc/annotate.h>
 #include <assert.h>
 #include <memory.h>
 
 #if RAM_WANT_COMPACT
-typedef uint8_t rampg_index_t;
+typedef uint16_t rampg_index_t;
 #else
 typedef size_t rampg_index_t;
 #endif
 /* RAMPG_MAXCAPACITY is used to specify the bounds of an array, so it must
  * be a reasonable size for this task regardless of what the integer space
- * can support. */
-#define RAMPG_MAXCAPACITY UINT8_MAX
+ * can support. it needs to be large enough to cover a 2 MiB huge page
+ * made of 4 KiB pages. */
+#define RAMPG_MAXCAPACITY 512
+
+/* a node keeps track of which of its pages are free and which are
+ * committed with a bit per page. */
+typedef uint64_t rampg_bitmap_t;
+#define RAMPG_BITSPERWORD 64
+#define RAMPG_MAPWORDS (RAMPG_MAXCAPACITY / RAMPG_BITSPERWORD)
+#define RAMPG_WORD(Index) ((Index) / RAMPG_BITSPERWORD)
+#define RAMPG_BIT(Index) \
+   (((rampg_bitmap_t)1) << ((Index) % RAMPG_BITSPERWORD))
+#define RAMPG_TESTBIT(Map, Index) \
+   (0 != ((Map)[RAMPG_WORD(Index)] & RAMPG_BIT(Index)))
+#define RAMPG_SETBIT(Map, Index) \
+   ((Map)[RAMPG_WORD(Index)] |= RAMPG_BIT(Index))
+#define RAMPG_CLEARBIT(Map, Index) \
+   ((Map)[RAMPG_WORD(Index)] &= ~RAMPG_BIT(Index))
+/* a run is aligned to its length, so it never straddles two words of a
+ * map. */
+#if RAMPG_MAXRUNLENGTH > RAMPG_BITSPERWORD
+#  error a run must fit into a single word of the maps in a node.
+#endif
+#define RAMPG_RUNMASK(Length) \
+   (RAMPG_BITSPERWORD == (Length) ? ~(rampg_bitmap_t)0 : \
+   (((rampg_bitmap_t)1) << (Length)) - 1)
 
 struct rampg_snode;
 
@@ -56,44 +85,72 @@ typedef struct ramslab_node
 {
    ramvec_node_t rampgvn_vnode;
    char *rampgvn_pages;
-   rampg_index_t rampgvn_freestksz;
-   rampg_index_t rampgvn_freestk[RAMPG_MAXCAPACITY];
-   int rampgvn_commitflags[RAMPG_MAXCAPACITY];
+   rampg_index_t rampgvn_capacity;
+   rampg_index_t rampgvn_freecount;
+   /* none of the words that precede this one have a free page in them. */
+   rampg_index_t rampgvn_firstword;
+   rampg_bitmap_t rampgvn_freemap[RAMPG_MAPWORDS];
+   rampg_bitmap_t rampgvn_commitmap[RAMPG_MAPWORDS];
 } rampg_vnode_t;
 
 typedef struct rampg_slot
 {
    ramsig_signature_t rampgg_signature;
+   /* this is NULL if the slot is embedded at the beginning of the region
+    * it describes (see rampg_mkhugevnode()). */
    struct rampg_snode *rampgg_snode;
    rampg_vnode_t rampgg_vnode;
 } rampg_slot_t;
 
+/* the slot embedded in a gluttonous region is also linked into a list of
+ * every such region, so that rampg_gethugestats() can tell my huge pages
+ * apart from anyone else's. */
+typedef struct rampg_hugeslot
+{
+   rampg_slot_t rampghs_slot;
+   ramlist_list_t rampghs_link;
+} rampg_hugeslot_t;
+
 typedef struct rampg_snode
 {
    ramslot_node_t rampgsn_slotnode;
    rampg_slot_t rampgsn_slots[];
 } rampg_snode_t;
 
-typedef struct rampg_footer
-{
-   /* the page footer only needs to store a pointer to it's node. */
-   rampg_vnode_t *rampgf_vnode;
-} rampg_footer_t;
-
 typedef struct rampg_globals
 {
-   ramfoot_spec_t rampgg_footerspec;
    size_t rampgg_nodecapacity;
    size_t rampgg_granularity;
    size_t rampgg_pagesize;
+   /* this is 0 if huge pages aren't supported. */
+   size_t rampgg_hugepagesize;
+   /* protects 'rampgg_hugeregions'. */
+   rammtx_mutex_t rampgg_hugemutex;
+   ramlist_list_t rampgg_hugeregions;
    int rampgg_initflag;
 } rampg_globals_t;
 
 static ram_reply_t rampg_mkpool2(rampg_pool_t *pool_arg, rampg_appetite_t appetite_arg);
+static ram_reply_t rampg_acquire2(char **page_arg, rampg_pool_t *pool_arg);
+static ram_reply_t rampg_release2(char *page_arg, rampg_vnode_t *vnode_arg,
+      rampg_index_t index_arg);
+static ram_reply_t rampg_toreserve(rampg_pool_t *pool_arg, char *page_arg);
+static ram_reply_t rampg_unreserve(char **page_arg, rampg_pool_t *pool_arg);
 static ram_reply_t rampg_findvnode(rampg_vnode_t **node_arg, char *ptr_arg);
 static ram_reply_t rampg_mkvnode(ramvec_node_t **node_arg, ramvec_pool_t *pool_arg);
-static ram_reply_t rampg_initvnode(rampg_vnode_t *node_arg);
+static ram_reply_t rampg_mkhugevnode(ramvec_node_t **node_arg, rampg_pool_t *pool_arg);
+static ram_reply_t rampg_initvnode(rampg_vnode_t *node_arg, char *pages_arg,
+      size_t first_arg, size_t capacity_arg, int commitflag_arg);
 static ram_reply_t rampg_rmvnode(rampg_vnode_t *node_arg);
+static ram_reply_t rampg_overlap(size_t *bytes_arg, char *start_arg,
+      char *end_arg, void *context_arg);
+static ram_reply_t rampg_recycle(rampg_vnode_t *node_arg);
+static ram_reply_t rampg_unmkpages(rampg_pool_t *pool_arg, char *pages_arg,
+      int commitflag_arg);
+static ram_reply_t rampg_findfree(rampg_index_t *index_arg,
+      rampg_vnode_t *node_arg);
+static ram_reply_t rampg_findfreerun(rampg_index_t *index_arg,
+      rampg_vnode_t *node_arg, size_t length_arg);
 static ram_reply_t rampg_getpage(char **page_arg,
       rampg_vnode_t *vpoolnode_arg, rampg_index_t index_arg);
 static ram_reply_t rampg_calcindex(rampg_index_t *index_arg,
@@ -102,10 +159,16 @@ static ram_reply_t rampg_chkvnode(const ramvec_node_t *node_arg);
 static ram_reply_t rampg_mksnode(ramslot_node_t **node_arg, void **slots_arg, ramslot_pool_t *pool_arg);
 static ram_reply_t rampg_rmsnode(ramslot_node_t *node_arg);
 static ram_reply_t rampg_initslot(void *slot_arg, ramslot_node_t *node_arg);
-#define RAMPG_ISFULL(Node) (0 == (Node)->rampgvn_freestksz)
-#define RAMPG_ISEMPTY(Node) (rampg_theglobals.rampgg_nodecapacity == (Node)->rampgvn_freestksz)
+#define RAMPG_ISFULL(Node) (0 == (Node)->rampgvn_freecount)
+#define RAMPG_ISEMPTY(Node) ((Node)->rampgvn_capacity == (Node)->rampgvn_freecount)
+#define RAMPG_NODECAPACITY(Node) ((Node)->rampgvn_vnode.ramvecn_vpool->ramvecvp_nodecapacity)
+#define RAMPG_POOL(Node) \
+   RAM_CAST_STRUCTBASE(rampg_pool_t, rampgp_vpool, (Node)->rampgvn_vnode.ramvecn_vpool)
 
 static rampg_globals_t rampg_theglobals;
+/* the ownership map associates each page i've handed out with its
+ * node. */
+static ramown_map_t rampg_theownmap;
 
 ram_reply_t ram_slab_initialize()
 {
@@ -113,21 +176,39 @@ ram_reply_t ram_slab_initialize()
    {
       rampg_globals_t stage = {0};
       size_t mmapgran = 0;
+      ram_reply_t e = RAM_REPLY_INSANE;
 
       RAM_FAIL_TRAP(rammem_pagesize(&stage.rampgg_pagesize));
       RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
-      /* i am the page allocator, so i have access to the entire page 
-       * (i.e. 'page_size' == 'writable_zone') */
-      RAMFOOT_MKSPEC(&stage.rampgg_footerspec, rampg_footer_t, 
-            stage.rampgg_pagesize, "PAGE");
       /* the node capacity is the number of pages a node keeps track of. */
       stage.rampgg_nodecapacity = mmapgran / stage.rampgg_pagesize;
       RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, 
             stage.rampgg_nodecapacity <= RAMPG_MAXCAPACITY);
-      stage.rampgg_granularity = stage.rampgg_footerspec.footer_offset;
-      stage.rampgg_initflag = 1;
+      /* i don't store anything in the pages i hand out, so the caller has
+       * access to the entire page. */
+      stage.rampgg_granularity = stage.rampgg_pagesize;
+      /* huge pages are optional; i'll complain about their absence if
+       * someone asks for a gluttonous pool. */
+      e = ramsys_hugepagesize(&stage.rampgg_hugepagesize);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_OK:
+         break;
+      case RAM_REPLY_UNSUPPORTED:
+         stage.rampgg_hugepagesize = 0;
+         break;
+      }
 
       rampg_theglobals = stage;
+      /* the mutex and the list can't be copied once they're made, so i
+       * make them in place. */
+      RAM_FAIL_TRAP(rammtx_mkmutex(&rampg_theglobals.rampgg_hugemutex));
+      RAM_FAIL_TRAP(ramlist_mklist(&rampg_theglobals.rampgg_hugeregions));
+      rampg_theglobals.rampgg_initflag = 1;
    }
 
    return RAM_REPLY_OK;
@@ -151,20 +232,53 @@ ram_reply_t rampg_mkpool(rampg_pool_t *pool_arg, rampg_appetite_t appetite_arg)
 ram_reply_t rampg_mkpool2(rampg_pool_t *pool_arg, rampg_appetite_t appetite_arg)
 {
    size_t snodecapacity = 0;
-   size_t mmapgran = 0;
+   size_t nodecapacity = 0;
 
    assert(pool_arg != NULL);
    assert(rampg_theglobals.rampgg_initflag);
 
-   RAM_FAIL_TRAP(ramvec_mkpool(&pool_arg->rampgp_vpool, rampg_theglobals.rampgg_nodecapacity, 
+   switch (appetite_arg)
+   {
+   default:
+      return RAM_REPLY_DISALLOWED;
+   case RAMOPT_FRUGAL:
+   case RAMOPT_GREEDY:
+      nodecapacity = rampg_theglobals.rampgg_nodecapacity;
+      break;
+   case RAMOPT_GLUTTONOUS:
+      /* a gluttonous pool's nodes each keep track of a single huge
+       * page. */
+      RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+            0 != rampg_theglobals.rampgg_hugepagesize);
+      nodecapacity = rampg_theglobals.rampgg_hugepagesize /
+            rampg_theglobals.rampgg_pagesize;
+      RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+            nodecapacity <= RAMPG_MAXCAPACITY);
+      /* the node's bookkeeping has to fit comfortably within the huge page
+       * it's embedded in. */
+      RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, sizeof(rampg_hugeslot_t) <
+            rampg_theglobals.rampgg_hugepagesize / 2);
+      break;
+   }
+
+   RAM_FAIL_TRAP(ramvec_mkpool(&pool_arg->rampgp_vpool, nodecapacity,
       &rampg_mkvnode));
    pool_arg->rampgp_appetite = appetite_arg;
+   /* a new pool holds nothing in reserve. */
+   pool_arg->rampgp_reserve = NULL;
+   pool_arg->rampgp_reservesz = 0;
+   pool_arg->rampgp_floor = 0;
+   pool_arg->rampgp_partition = RAMPG_NOPARTITION;
+   pool_arg->rampgp_runlength = 1;
 
    /* slot pool initialization: i must determine how many slots i can store
-    * with a slot allocator in the amount of space specified by the virtual
-    * memory mapping granularity. */
-   RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
-   snodecapacity = (mmapgran - sizeof(rampg_snode_t))
+    * with a slot allocator in a single page. a node's bookkeeping is small
+    * enough that there's no need to dedicate an entire reservation to
+    * it. */
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+         rampg_theglobals.rampgg_pagesize >=
+         sizeof(rampg_snode_t) + sizeof(rampg_slot_t));
+   snodecapacity = (rampg_theglobals.rampgg_pagesize - sizeof(rampg_snode_t))
          / sizeof(rampg_slot_t);
    RAM_FAIL_TRAP(ramslot_mkpool(&pool_arg->rampgp_slotpool, sizeof(rampg_slot_t),
       snodecapacity, rampg_mksnode, rampg_rmsnode, rampg_initslot));
@@ -175,17 +289,41 @@ ram_reply_t rampg_mkpool2(rampg_pool_t *pool_arg, rampg_appetite_t appetite_arg)
 
 ram_reply_t rampg_acquire(void **ptr_arg, rampg_pool_t *pool_arg)
 {
-   rampg_index_t idx = 0;
    char *page = NULL;
-   rampg_vnode_t *vnode = NULL;
-   rampg_footer_t *foot = NULL;
-   ramvec_node_t *p = NULL;
 
    RAM_FAIL_NOTNULL(ptr_arg);
    *ptr_arg = NULL;
    RAM_FAIL_NOTNULL(pool_arg);
    assert(rampg_theglobals.rampgg_initflag);
 
+   /* a page held in reserve is already committed and faulted in, so it
+    * can be handed out without any help from the system. */
+   if (NULL != pool_arg->rampgp_reserve)
+      RAM_FAIL_TRAP(rampg_unreserve(&page, pool_arg));
+   else
+      RAM_FAIL_TRAP(rampg_acquire2(&page, pool_arg));
+
+   /* i zero-out the memory, if that behavior is desired. */
+#if RAM_WANT_ZEROMEM
+   memset(page, 0, rampg_theglobals.rampgg_granularity *
+         pool_arg->rampgp_runlength);
+#endif
+
+   *ptr_arg = page;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_acquire2(char **page_arg, rampg_pool_t *pool_arg)
+{
+   rampg_index_t idx = 0, i = 0;
+   char *page = NULL;
+   rampg_vnode_t *vnode = NULL;
+   ramvec_node_t *p = NULL;
+
+   assert(page_arg != NULL);
+   assert(pool_arg != NULL);
+   assert(rampg_theglobals.rampgg_initflag);
+
    /* first, i acquire a memory object from the next available node in the pool. */
    RAM_FAIL_TRAP(ramvec_getnode(&p, &pool_arg->rampgp_vpool));
    vnode = RAM_CAST_STRUCTBASE(rampg_vnode_t, rampgvn_vnode, p);
@@ -194,35 +332,44 @@ ram_reply_t rampg_acquire(void **ptr_arg, rampg_pool_t *pool_arg)
    /* ramvec_getnode() should never return someone else's node. */
    assert(&pool_arg->rampgp_vpool == vnode->rampgvn_vnode.ramvecn_vpool);
 
-   idx = vnode->rampgvn_freestk[vnode->rampgvn_freestksz - 1];
+   if (1 == pool_arg->rampgp_runlength)
+      RAM_FAIL_TRAP(rampg_findfree(&idx, vnode));
+   else
+   {
+      RAM_FAIL_TRAP(rampg_findfreerun(&idx, vnode,
+            pool_arg->rampgp_runlength));
+   }
    RAM_FAIL_TRAP(rampg_getpage(&page, vnode, idx));
-   RAM_FAIL_TRAP(ramsys_commit(page));
-
-   /* i mark the page as committed. */
-   vnode->rampgvn_commitflags[idx] = 1;
+   /* i need to record the page's node in the ownership map to ensure that
+    * i can get to the pool given any address of the page. only the first
+    * page of a run is recorded, since that's the only one that can be
+    * released. */
+   RAM_FAIL_TRAP(ramown_set(&rampg_theownmap, page, vnode));
+   /* a greedy pool leaves pages committed when they're released, so i only
+    * need to commit the pages that aren't already. */
+   for (i = idx; i < idx + pool_arg->rampgp_runlength; ++i)
+   {
+      if (!RAMPG_TESTBIT(vnode->rampgvn_commitmap, i))
+      {
+         RAM_FAIL_TRAP(ramsys_commit(page +
+               (i - idx) * rampg_theglobals.rampgg_pagesize));
+         /* i mark the page as committed. */
+         RAMPG_SETBIT(vnode->rampgvn_commitmap, i);
+      }
+   }
 
    /* at this point, if something goes wrong, the node is inconsistent and
     * there's no longer any hope for recovery. */
 
-   /* i need to shorten the free list; it's not necessary to clear out the old value but it
-    * is helpful to see in the debugger. */
-   vnode->rampgvn_freestk[--vnode->rampgvn_freestksz] = 0xfe;
-
-   /* i need to write a footer to the page to ensure that i can get to the pool
-    * given any address of of the page. */
-   /* TODO: should the footer spec be moved out of pool and into this? */
-   RAM_FAIL_PANIC(ramfoot_mkfooter((void **)&foot, &rampg_theglobals.rampgg_footerspec, page));
-   foot->rampgf_vnode = vnode;
+   /* the pages are no longer free. */
+   for (i = idx; i < idx + pool_arg->rampgp_runlength; ++i)
+      RAMPG_CLEARBIT(vnode->rampgvn_freemap, i);
+   vnode->rampgvn_freecount -= pool_arg->rampgp_runlength;
 
    /* i finalize the acquisition by updating the pool state. */
    RAM_FAIL_PANIC(ramvec_acquire(&vnode->rampgvn_vnode, RAMPG_ISFULL(vnode)));
 
-   /* i zero-out the memory, if that behavior is desired. */
-#if RAM_WANT_ZEROMEM
-   memset(page, 0, rampg_theglobals.rampgg_granularity);
-#endif
-
-   *ptr_arg = page;
+   *page_arg = page;
    return RAM_REPLY_OK;
 }
 
@@ -231,7 +378,6 @@ ram_reply_t rampg_release(void *ptr_arg)
    rampg_vnode_t *vnode = NULL;
    rampg_pool_t *pool = NULL;
    rampg_index_t idx = 0;
-   int emptyflag = 0;
 
    RAM_FAIL_NOTNULL(ptr_arg);
    RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rampg_theglobals.rampgg_initflag);
@@ -240,56 +386,208 @@ ram_reply_t rampg_release(void *ptr_arg)
    pool = RAM_CAST_STRUCTBASE(rampg_pool_t, rampgp_vpool,
          vnode->rampgvn_vnode.ramvecn_vpool);
    RAM_FAIL_TRAP(rampg_calcindex(&idx, vnode, ptr_arg));
-   /* depending upon the release strategy, i either return the page to the system
-    * or i wipe it and deny access to it. */
-   if (RAMOPT_FRUGAL == pool->rampgp_appetite)
+   /* only the first page of a run can be released. */
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, 0 == idx % pool->rampgp_runlength);
+   /* releasing a page twice would corrupt the node. */
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED,
+         !RAMPG_TESTBIT(vnode->rampgvn_freemap, idx));
+   assert(RAMPG_TESTBIT(vnode->rampgvn_commitmap, idx));
+
+   /* if the pool's reserve has fallen below its floor, i hold onto the
+    * page instead of giving it back to its node. */
+   if (pool->rampgp_reservesz < pool->rampgp_floor)
    {
-      assert(vnode->rampgvn_commitflags[idx]);
-      RAM_FAIL_TRAP(ramsys_decommit(ptr_arg));
-      vnode->rampgvn_commitflags[idx] = 0;
+#if RAM_WANT_MARKFREED
+      memset(ptr_arg, RAM_WANT_MARKFREED,
+            rampg_theglobals.rampgg_granularity * pool->rampgp_runlength);
+#endif
+      RAM_FAIL_TRAP(rampg_toreserve(pool, (char *)ptr_arg));
+      return RAM_REPLY_OK;
    }
-   else
+
+   RAM_FAIL_TRAP(rampg_release2((char *)ptr_arg, vnode, idx));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_release2(char *page_arg, rampg_vnode_t *vnode_arg,
+      rampg_index_t index_arg)
+{
+   rampg_pool_t *pool = NULL;
+   rampg_index_t i = 0;
+   char *page = NULL;
+   int emptyflag = 0;
+
+   assert(page_arg != NULL);
+   assert(vnode_arg != NULL);
+   assert(rampg_theglobals.rampgg_initflag);
+
+   pool = RAMPG_POOL(vnode_arg);
+   /* depending upon the release strategy, i either return the pages to the
+    * system or i let the system know that it's free to discard their
+    * contents but keep them committed. */
+   for (i = index_arg; i < index_arg + pool->rampgp_runlength; ++i)
    {
-      assert(RAMOPT_GREEDY == pool->rampgp_appetite);
-      RAM_FAIL_TRAP(ramsys_reset(ptr_arg));
+      page = page_arg + (i - index_arg) * rampg_theglobals.rampgg_pagesize;
+      if (RAMOPT_FRUGAL == pool->rampgp_appetite)
+      {
+         RAM_FAIL_TRAP(ramsys_decommit(page));
+         RAMPG_CLEARBIT(vnode_arg->rampgvn_commitmap, i);
+      }
+      else
+      {
+         assert(RAMOPT_GREEDY == pool->rampgp_appetite ||
+               RAMOPT_GLUTTONOUS == pool->rampgp_appetite);
 
 #if RAM_WANT_MARKFREED
-      /* it's helpful to see signature bytes for destroyed memory when
-       * debugging. */
-      memset(ptr_arg, RAM_WANT_MARKFREED,
-            rampg_theglobals.rampgg_granularity);
+         /* it's helpful to see signature bytes for destroyed memory when
+          * debugging. i have to mark the page before i reset it, otherwise
+          * i'd be telling the system that the page is in use again. */
+         memset(page, RAM_WANT_MARKFREED,
+               rampg_theglobals.rampgg_granularity);
 #endif
 
+         /* resetting a single page of a huge page would force the kernel to
+          * split it, so a gluttonous pool holds onto its pages until the
+          * entire region is released. */
+         if (RAMOPT_GREEDY == pool->rampgp_appetite)
+            RAM_FAIL_TRAP(ramsys_reset(page));
+      }
    }
 
    /* at this point, if something goes wrong, the vnode might be inconsistent and
       * there's no longer any hope for recovery. */
 
-   /* i now add the page's index to the free list. */
-   assert(vnode->rampgvn_freestksz < RAMPG_MAXCAPACITY);
-   vnode->rampgvn_freestk[vnode->rampgvn_freestksz++] = idx;
+   /* i now mark the pages as free. */
+   RAM_FAIL_PANIC(ramown_set(&rampg_theownmap, page_arg, NULL));
+   assert(vnode_arg->rampgvn_freecount < vnode_arg->rampgvn_capacity);
+   for (i = index_arg; i < index_arg + pool->rampgp_runlength; ++i)
+      RAMPG_SETBIT(vnode_arg->rampgvn_freemap, i);
+   vnode_arg->rampgvn_freecount += pool->rampgp_runlength;
+   if (RAMPG_WORD(index_arg) < vnode_arg->rampgvn_firstword)
+      vnode_arg->rampgvn_firstword = RAMPG_WORD(index_arg);
    /* now, i pass control to ramvec_release() to finalize the pool state. if the vnode is
     * empty, i'll discard the vnode. */
-   emptyflag = RAMPG_ISEMPTY(vnode);
-   RAM_FAIL_PANIC(ramvec_release(&vnode->rampgvn_vnode, 1 == vnode->rampgvn_freestksz, emptyflag));
+   emptyflag = RAMPG_ISEMPTY(vnode_arg);
+   RAM_FAIL_PANIC(ramvec_release(&vnode_arg->rampgvn_vnode,
+         pool->rampgp_runlength == vnode_arg->rampgvn_freecount, emptyflag));
    if (emptyflag)
-      RAM_FAIL_PANIC(rampg_rmvnode(vnode));
+      RAM_FAIL_PANIC(rampg_rmvnode(vnode_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_reserve(rampg_pool_t *pool_arg, size_t count_arg)
+{
+   char *page = NULL;
+   rampg_vnode_t *vnode = NULL;
+   rampg_index_t idx = 0;
+
+   RAM_FAIL_NOTNULL(pool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rampg_theglobals.rampgg_initflag);
+
+   pool_arg->rampgp_floor = count_arg;
+   /* i fill the reserve up to the new floor... */
+   while (pool_arg->rampgp_reservesz < count_arg)
+   {
+      RAM_FAIL_TRAP(rampg_acquire2(&page, pool_arg));
+      RAM_FAIL_TRAP(rampg_toreserve(pool_arg, page));
+   }
+   /* ...or give back whatever exceeds it. */
+   while (pool_arg->rampgp_reservesz > count_arg)
+   {
+      RAM_FAIL_TRAP(rampg_unreserve(&page, pool_arg));
+      RAM_FAIL_TRAP(rampg_findvnode(&vnode, page));
+      RAM_FAIL_TRAP(rampg_calcindex(&idx, vnode, page));
+      RAM_FAIL_TRAP(rampg_release2(page, vnode, idx));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_confine(rampg_pool_t *pool_arg, size_t partition_arg)
+{
+   int hastail = 0;
+
+   RAM_FAIL_NOTNULL(pool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rampg_theglobals.rampgg_initflag);
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, partition_arg < RAMVAS_PARTITIONCOUNT);
+   /* a gluttonous pool gets its huge pages directly from the system. */
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+         RAMOPT_GLUTTONOUS != pool_arg->rampgp_appetite);
+   /* pages that have already been acquired would end up outside of the
+    * partition. */
+   RAM_FAIL_TRAP(ramlist_hastail(&hastail, &pool_arg->rampgp_vpool.ramvecvp_inv));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, !hastail);
+
+   pool_arg->rampgp_partition = partition_arg;
+   return RAM_REPLY_OK;
+}
 
+ram_reply_t rampg_setrunlength(rampg_pool_t *pool_arg, size_t pages_arg)
+{
+   int hastail = 0;
+
+   RAM_FAIL_NOTNULL(pool_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rampg_theglobals.rampgg_initflag);
+   RAM_FAIL_NOTZERO(pages_arg);
+   /* runs are aligned to their length, so the length has to be a power of
+    * two. it also has to divide a reservation evenly, or the last run in
+    * each reservation would hang off its end. */
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, 0 == (pages_arg & (pages_arg - 1)));
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, pages_arg <= RAMPG_MAXRUNLENGTH);
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL,
+         0 == pool_arg->rampgp_vpool.ramvecvp_nodecapacity % pages_arg);
+   /* pages that have already been acquired would be the wrong length. */
+   RAM_FAIL_TRAP(ramlist_hastail(&hastail, &pool_arg->rampgp_vpool.ramvecvp_inv));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, !hastail);
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, NULL == pool_arg->rampgp_reserve);
+
+   pool_arg->rampgp_runlength = pages_arg;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_toreserve(rampg_pool_t *pool_arg, char *page_arg)
+{
+   assert(pool_arg != NULL);
+   assert(page_arg != NULL);
+
+   /* writing the link into the page also faults it in. */
+   *(char **)page_arg = pool_arg->rampgp_reserve;
+   pool_arg->rampgp_reserve = page_arg;
+   ++pool_arg->rampgp_reservesz;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_unreserve(char **page_arg, rampg_pool_t *pool_arg)
+{
+   char *page = NULL;
+
+   assert(page_arg != NULL);
+   assert(pool_arg != NULL);
+   assert(pool_arg->rampgp_reserve != NULL);
+   assert(pool_arg->rampgp_reservesz > 0);
+
+   page = pool_arg->rampgp_reserve;
+   pool_arg->rampgp_reserve = *(char **)page;
+   --pool_arg->rampgp_reservesz;
+
+   *page_arg = page;
    return RAM_REPLY_OK;
 }
 
 ram_reply_t rampg_findvnode(rampg_vnode_t **node_arg, char *ptr_arg)
 {
-   rampg_footer_t *foot = NULL;
+   void *vnode = NULL;
 
    assert(rampg_theglobals.rampgg_initflag);
    assert(node_arg != NULL);
    assert(ptr_arg != NULL);
 
-   RAM_FAIL_TRAP(ramfoot_getstorage((void **)&foot, &rampg_theglobals.rampgg_footerspec, ptr_arg));
+   RAM_FAIL_TRAP(ramown_get(&vnode, &rampg_theownmap, ptr_arg));
 
-   *node_arg = foot->rampgf_vnode;
-   assert(*node_arg != NULL);
+   *node_arg = (rampg_vnode_t *)vnode;
    return RAM_REPLY_OK;
 }
 
@@ -297,48 +595,140 @@ ram_reply_t rampg_mkvnode(ramvec_node_t **node_arg, ramvec_pool_t *pool_arg)
 {
    rampg_slot_t *slot = NULL;
    rampg_pool_t *pool = NULL;
+   char *pages = NULL;
+   int commitflag = 0;
    ram_reply_t e = RAM_REPLY_INSANE;
 
    assert(rampg_theglobals.rampgg_initflag);
    assert(node_arg != NULL);
 
    pool = RAM_CAST_STRUCTBASE(rampg_pool_t, rampgp_vpool, pool_arg);
-   RAM_FAIL_TRAP(ramslot_acquire((void **)&slot, &pool->rampgp_slotpool));
-   e = rampg_initvnode(&slot->rampgg_vnode);
+   if (RAMOPT_GLUTTONOUS == pool->rampgp_appetite)
+      return rampg_mkhugevnode(node_arg, pool);
+
+   /* a confined pool takes its reservations from its partition. */
+   if (RAMPG_NOPARTITION != pool->rampgp_partition)
+   {
+      RAM_FAIL_TRAP(ramvas_withdraw(&pages, &commitflag,
+            pool->rampgp_partition));
+      e = RAM_REPLY_OK;
+   }
+   /* if another pool recently gave up a reservation, i can reuse it without
+    * asking the system for anything. */
+   else
+      e = ramrcy_withdraw(&pages, &commitflag);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_OK:
+      break;
+   case RAM_REPLY_NOTFOUND:
+      /* i reserve the pages because there doesn't seem to be a need until memory is actually
+       * acquired. this still uses address space but preserves hardware for those pages that
+       * are actually in use. */
+      RAM_FAIL_TRAP(ramsys_reserve(&pages));
+      commitflag = 0;
+      break;
+   }
+   e = ramslot_acquire((void **)&slot, &pool->rampgp_slotpool);
+   if (RAM_REPLY_OK != e)
+   {
+      RAM_FAIL_PANIC(rampg_unmkpages(pool, pages, commitflag));
+      return e;
+   }
+   /* a fresh reservation has no pages committed; a recycled reservation
+    * has either all or none of its pages committed. */
+   e = rampg_initvnode(&slot->rampgg_vnode, pages, 0,
+         pool_arg->ramvecvp_nodecapacity, commitflag);
+   if (RAM_REPLY_OK == e)
+   {
+      *node_arg = &slot->rampgg_vnode.rampgvn_vnode;
+      return RAM_REPLY_OK;
+   }
+   else
+   {
+      RAM_FAIL_PANIC(rampg_unmkpages(pool, pages, commitflag));
+      RAM_FAIL_PANIC(ramslot_release(slot, &slot->rampgg_snode->rampgsn_slotnode));
+      return e;
+   }
+}
+
+ram_reply_t rampg_mkhugevnode(ramvec_node_t **node_arg, rampg_pool_t *pool_arg)
+{
+   rampg_hugeslot_t *hugeslot = NULL;
+   rampg_slot_t *slot = NULL;
+   char *pages = NULL;
+   size_t first = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(rampg_theglobals.rampgg_initflag);
+   assert(node_arg != NULL);
+   assert(pool_arg != NULL);
+
+   /* a gluttonous pool's bookkeeping lives at the beginning of the huge
+    * page it describes, rather than in a slot node, so that it's also
+    * backed by the huge page. the region is committed from the start. */
+   RAM_FAIL_TRAP(ramsys_reservehuge(&pages));
+   hugeslot = (rampg_hugeslot_t *)pages;
+   slot = &hugeslot->rampghs_slot;
+   slot->rampgg_signature = pool_arg->rampgp_slotsig;
+   slot->rampgg_snode = NULL;
+   /* the pages occupied by the slot are never handed out. */
+   first = (sizeof(*hugeslot) + rampg_theglobals.rampgg_pagesize - 1) /
+         rampg_theglobals.rampgg_pagesize;
+   /* the free pages have to come in whole runs, so i skip the rest of the
+    * run that the slot occupies. */
+   first = (first + pool_arg->rampgp_runlength - 1) /
+         pool_arg->rampgp_runlength * pool_arg->rampgp_runlength;
+   e = rampg_initvnode(&slot->rampgg_vnode, pages, first,
+         pool_arg->rampgp_vpool.ramvecvp_nodecapacity, 1);
    if (RAM_REPLY_OK == e)
    {
+      RAM_FAIL_TRAP(ramlist_mklist(&hugeslot->rampghs_link));
+      RAM_FAIL_TRAP(rammtx_wait(&rampg_theglobals.rampgg_hugemutex));
+      e = ramlist_splice(&rampg_theglobals.rampgg_hugeregions,
+            &hugeslot->rampghs_link);
+      RAM_FAIL_PANIC(rammtx_quit(&rampg_theglobals.rampgg_hugemutex));
+      RAM_FAIL_TRAP(e);
       *node_arg = &slot->rampgg_vnode.rampgvn_vnode;
       return RAM_REPLY_OK;
    }
    else
    {
-      RAM_FAIL_PANIC(rampg_rmvnode(&slot->rampgg_vnode));
+      RAM_FAIL_PANIC(ramsys_releasehuge(pages));
       return e;
    }
 }
 
-ram_reply_t rampg_initvnode(rampg_vnode_t *node_arg)
+ram_reply_t rampg_initvnode(rampg_vnode_t *node_arg, char *pages_arg,
+      size_t first_arg, size_t capacity_arg, int commitflag_arg)
 {
    size_t i = 0;
 
    assert(rampg_theglobals.rampgg_initflag);
    assert(node_arg != NULL);
+   assert(pages_arg != NULL);
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, first_arg < capacity_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, capacity_arg <= RAMPG_MAXCAPACITY);
 
-   memset(node_arg, 0, sizeof(node_arg));
-   /* i reserve the page because there doesn't seem to be a need until memory is actually
-    * acquired. this still uses address space but preserves hardware for those pages that 
-    * are actually in use. */
-   RAM_FAIL_TRAP(ramsys_reserve(&node_arg->rampgvn_pages));
-   /* therefore, all commit flags start out reset. */
-   memset(node_arg->rampgvn_commitflags, 0, sizeof(node_arg->rampgvn_commitflags));
-   /* this isn't absolutely necessary but it's helpful to not see garbage data in the debugger. */
-   memset(node_arg->rampgvn_freestk, 0xff, sizeof(node_arg->rampgvn_freestk));
-
-   /* now, i initialize the free list. all memory objects start out free, so i'll fill the
-    * entire free list. */
-   for (i = 0; i < rampg_theglobals.rampgg_nodecapacity; ++i)
-      node_arg->rampgvn_freestk[i] = i;
-   node_arg->rampgvn_freestksz = rampg_theglobals.rampgg_nodecapacity;
+   memset(node_arg, 0, sizeof(*node_arg));
+   node_arg->rampgvn_pages = pages_arg;
+   if (commitflag_arg)
+   {
+      for (i = 0; i < capacity_arg; ++i)
+         RAMPG_SETBIT(node_arg->rampgvn_commitmap, i);
+   }
+
+   /* now, i initialize the free map. all pages (except those that
+    * precede the first) start out free. */
+   for (i = first_arg; i < capacity_arg; ++i)
+      RAMPG_SETBIT(node_arg->rampgvn_freemap, i);
+   node_arg->rampgvn_capacity = capacity_arg - first_arg;
+   node_arg->rampgvn_freecount = node_arg->rampgvn_capacity;
+   node_arg->rampgvn_firstword = RAMPG_WORD(first_arg);
 
    return RAM_REPLY_OK;
 }
@@ -347,6 +737,9 @@ ram_reply_t rampg_rmvnode(rampg_vnode_t *node_arg)
 {
    rampg_pool_t *pool = NULL;
    rampg_slot_t *slot = NULL;
+   rampg_hugeslot_t *hugeslot = NULL;
+   ramlist_list_t *unused = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
 
    assert(rampg_theglobals.rampgg_initflag);
    assert(node_arg != NULL);
@@ -356,11 +749,169 @@ ram_reply_t rampg_rmvnode(rampg_vnode_t *node_arg)
    slot = RAM_CAST_STRUCTBASE(rampg_slot_t, rampgg_vnode, node_arg);
    RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
       0 == RAMSIG_CMP(slot->rampgg_signature, pool->rampgp_slotsig));
-   RAM_FAIL_TRAP(ramsys_release(node_arg->rampgvn_pages));
-   RAM_FAIL_TRAP(ramslot_release(slot, &slot->rampgg_snode->rampgsn_slotnode));
+   /* an embedded slot disappears along with the region it describes. */
+   if (NULL == slot->rampgg_snode)
+   {
+      assert((char *)slot == node_arg->rampgvn_pages);
+      hugeslot = RAM_CAST_STRUCTBASE(rampg_hugeslot_t, rampghs_slot, slot);
+      RAM_FAIL_TRAP(rammtx_wait(&rampg_theglobals.rampgg_hugemutex));
+      e = ramlist_pop(&unused, &hugeslot->rampghs_link);
+      RAM_FAIL_PANIC(rammtx_quit(&rampg_theglobals.rampgg_hugemutex));
+      RAM_FAIL_TRAP(e);
+      RAM_FAIL_TRAP(ramsys_releasehuge(node_arg->rampgvn_pages));
+   }
+   else
+   {
+      RAM_FAIL_TRAP(rampg_recycle(node_arg));
+      RAM_FAIL_TRAP(ramslot_release(slot, &slot->rampgg_snode->rampgsn_slotnode));
+   }
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rampg_recycle(rampg_vnode_t *node_arg)
+{
+   size_t i = 0, j = 0;
+   size_t capacity = 0;
+   size_t committed = 0;
+   char *page = NULL;
+   rampg_pool_t *pool = NULL;
+
+   assert(rampg_theglobals.rampgg_initflag);
+   assert(node_arg != NULL);
+
+   pool = RAM_CAST_STRUCTBASE(rampg_pool_t, rampgp_vpool,
+         node_arg->rampgvn_vnode.ramvecn_vpool);
+   capacity = RAMPG_NODECAPACITY(node_arg);
+   for (i = 0; i < capacity; ++i)
+   {
+      if (RAMPG_TESTBIT(node_arg->rampgvn_commitmap, i))
+         ++committed;
+   }
+   /* the recycler only keeps track of whether an entire reservation is
+    * committed or not. a frugal pool's pages are all decommitted by now
+    * but a greedy pool might have only ever touched some of its pages. i
+    * commit the rest, which is cheaper than decommitting the pages that
+    * are committed and doesn't cost any physical memory until the pages
+    * are touched. each run of uncommitted pages takes a single call. */
+   if (0 != committed && capacity != committed)
+   {
+      for (i = 0; i < capacity; i = j)
+      {
+         if (RAMPG_TESTBIT(node_arg->rampgvn_commitmap, i))
+         {
+            j = i + 1;
+            continue;
+         }
+         for (j = i + 1; j < capacity
+               && !RAMPG_TESTBIT(node_arg->rampgvn_commitmap, j); ++j)
+            continue;
+         RAM_FAIL_TRAP(rampg_getpage(&page, node_arg, i));
+         RAM_FAIL_TRAP(ramsys_commitrange(page,
+               (j - i) * rampg_theglobals.rampgg_pagesize));
+      }
+   }
+   if (RAMPG_NOPARTITION == pool->rampgp_partition)
+      RAM_FAIL_TRAP(ramrcy_deposit(node_arg->rampgvn_pages, 0 != committed));
+   else
+      RAM_FAIL_TRAP(ramvas_deposit(node_arg->rampgvn_pages, 0 != committed));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_unmkpages(rampg_pool_t *pool_arg, char *pages_arg,
+      int commitflag_arg)
+{
+   assert(pool_arg != NULL);
+   assert(pages_arg != NULL);
+
+   /* pages from a partition can't be given back to the system
+    * individually. */
+   if (RAMPG_NOPARTITION == pool_arg->rampgp_partition)
+      RAM_FAIL_TRAP(ramsys_release(pages_arg));
+   else
+      RAM_FAIL_TRAP(ramvas_deposit(pages_arg, commitflag_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_findfree(rampg_index_t *index_arg, rampg_vnode_t *node_arg)
+{
+   size_t i = 0;
+   rampg_bitmap_t free = 0;
+   rampg_bitmap_t warm = 0;
+
+   assert(index_arg != NULL);
+   assert(node_arg != NULL);
+
+   for (i = node_arg->rampgvn_firstword; i < RAMPG_MAPWORDS; ++i)
+   {
+      free = node_arg->rampgvn_freemap[i];
+      if (0 != free)
+      {
+         /* i prefer a page that's still committed, since it doesn't need
+          * a system call to be used again. */
+         warm = free & node_arg->rampgvn_commitmap[i];
+         *index_arg = i * RAMPG_BITSPERWORD +
+               RAMSYS_CTZ64(0 != warm ? warm : free);
+         node_arg->rampgvn_firstword = i;
+         return RAM_REPLY_OK;
+      }
+   }
+
+   /* the caller should never ask a full node for a page. */
+   return RAM_REPLY_CORRUPT;
+}
+
+ram_reply_t rampg_findfreerun(rampg_index_t *index_arg,
+      rampg_vnode_t *node_arg, size_t length_arg)
+{
+   size_t i = 0, j = 0;
+   rampg_bitmap_t mask = 0;
+   rampg_bitmap_t free = 0;
+   rampg_bitmap_t commit = 0;
+   int foundflag = 0;
+
+   assert(index_arg != NULL);
+   assert(node_arg != NULL);
+   assert(length_arg > 1 && length_arg <= RAMPG_MAXRUNLENGTH);
+
+   mask = RAMPG_RUNMASK(length_arg);
+   for (i = node_arg->rampgvn_firstword; i < RAMPG_MAPWORDS; ++i)
+   {
+      free = node_arg->rampgvn_freemap[i];
+      if (0 == free)
+         continue;
+      commit = node_arg->rampgvn_commitmap[i];
+      /* a node's free pages always come in whole runs, since it only ever
+       * hands out runs of the same length. as with single pages, i prefer
+       * a run that's still committed. */
+      for (j = 0; j < RAMPG_BITSPERWORD; j += length_arg)
+      {
+         if (mask == ((free >> j) & mask))
+         {
+            if (!foundflag)
+               *index_arg = i * RAMPG_BITSPERWORD + j;
+            foundflag = 1;
+            if (mask == ((commit >> j) & mask))
+            {
+               *index_arg = i * RAMPG_BITSPERWORD + j;
+               break;
+            }
+         }
+      }
+      if (foundflag)
+      {
+         node_arg->rampgvn_firstword = i;
+         return RAM_REPLY_OK;
+      }
+      /* a partial run in the free map means that the node is corrupt. */
+      return RAM_REPLY_CORRUPT;
+   }
+
+   /* the caller should never ask a full node for a run. */
+   return RAM_REPLY_CORRUPT;
+}
+
 ram_reply_t rampg_getpage(char **page_arg,
       rampg_vnode_t *vpoolnode_arg, rampg_index_t index_arg)
 {
@@ -393,7 +944,7 @@ ram_reply_t rampg_calcindex(rampg_index_t *index_arg,
    RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, vpoolnode_arg->rampgvn_pages <= page_arg);
    RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL, vpoolnode_arg->rampgvn_pages +
          rampg_theglobals.rampgg_pagesize *
-         rampg_theglobals.rampgg_nodecapacity > page_arg);
+         RAMPG_NODECAPACITY(vpoolnode_arg) > page_arg);
 
    *index_arg = (page_arg - vpoolnode_arg->rampgvn_pages) /
          rampg_theglobals.rampgg_pagesize;
@@ -403,11 +954,22 @@ ram_reply_t rampg_calcindex(rampg_index_t *index_arg,
 
 ram_reply_t rampg_chkpool(const rampg_pool_t *pool_arg)
 {
+   const char *page = NULL;
+   size_t count = 0;
+
    RAM_FAIL_NOTNULL(pool_arg);
    
    assert(rampg_theglobals.rampgg_initflag);
    RAM_FAIL_TRAP(ramslot_chkpool(&pool_arg->rampgp_slotpool));
    RAM_FAIL_TRAP(ramvec_chkpool(&pool_arg->rampgp_vpool, &rampg_chkvnode));
+   /* the reserve's length should match its size. */
+   for (page = pool_arg->rampgp_reserve; NULL != page;
+         page = *(char * const *)page)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, count < pool_arg->rampgp_reservesz);
+      ++count;
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, count == pool_arg->rampgp_reservesz);
 
    return RAM_REPLY_OK;
 }
@@ -416,6 +978,7 @@ ram_reply_t rampg_chkvnode(const ramvec_node_t *node_arg)
 {
    const rampg_vnode_t *node = NULL;
    size_t i = 0;
+   size_t freecount = 0;
    int ispage = 0;
 
    assert(node_arg != NULL);
@@ -427,16 +990,28 @@ ram_reply_t rampg_chkvnode(const ramvec_node_t *node_arg)
    /* the base address should be on a page boundary. */
    RAM_FAIL_TRAP(rammem_ispage(&ispage, node->rampgvn_pages));
    RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, ispage);
-   /* the free list length should not exceed the node capacity. */
-   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, node->rampgvn_freestksz <= rampg_theglobals.rampgg_nodecapacity);
-   /* the free list should only contain indices on the range of [0, ramvecvp_nodecapacity). */
-   for (i = 0; i < node->rampgvn_freestksz; ++i)
-      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, node->rampgvn_freestk[i] < rampg_theglobals.rampgg_nodecapacity);
-   /* the commit flags should only contain values 0 or 1 */
-   for (i = 0; i < rampg_theglobals.rampgg_nodecapacity; ++i)
+   /* the free count should not exceed the node capacity. */
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, node->rampgvn_capacity <= RAMPG_NODECAPACITY(node));
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, node->rampgvn_freecount <= node->rampgvn_capacity);
+   /* the free count should match the free map and the free map shouldn't
+    * have anything in it before the first word. */
+   for (i = 0; i < RAMPG_MAXCAPACITY; ++i)
    {
-      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 
-         0 == node->rampgvn_commitflags[i] || 1 == node->rampgvn_commitflags[i]);
+      if (RAMPG_TESTBIT(node->rampgvn_freemap, i))
+      {
+         RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, RAMPG_WORD(i) >= node->rampgvn_firstword);
+         ++freecount;
+      }
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, node->rampgvn_freecount == freecount);
+   /* free pages come in whole runs. */
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+         0 == freecount % RAMPG_POOL(node)->rampgp_runlength);
+   /* neither map should refer to pages on or beyond ramvecvp_nodecapacity. */
+   for (i = RAMPG_NODECAPACITY(node); i < RAMPG_MAXCAPACITY; ++i)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, !RAMPG_TESTBIT(node->rampgvn_freemap, i));
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, !RAMPG_TESTBIT(node->rampgvn_commitmap, i));
    }
 
    return RAM_REPLY_OK;
@@ -453,7 +1028,8 @@ ram_reply_t rampg_mksnode(ramslot_node_t **node_arg, void **slots_arg, ramslot_p
    RAM_FAIL_NOTNULL(pool_arg);
    assert(rampg_theglobals.rampgg_initflag);
 
-   RAM_FAIL_TRAP(ramsys_bulkalloc((char **)&snode));
+   snode = rammem_supmalloc(rampg_theglobals.rampgg_pagesize);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != snode);
    *slots_arg = snode->rampgsn_slots;
    *node_arg = &snode->rampgsn_slotnode;
    return RAM_REPLY_OK;
@@ -467,7 +1043,7 @@ ram_reply_t rampg_rmsnode(ramslot_node_t *node_arg)
    assert(rampg_theglobals.rampgg_initflag);
 
    snode = RAM_CAST_STRUCTBASE(rampg_snode_t, rampgsn_slotnode, node_arg);
-   RAM_FAIL_TRAP(ramsys_release((char *)snode));
+   rammem_supfree(snode);
 
    return RAM_REPLY_OK;
 }
@@ -494,6 +1070,75 @@ ram_reply_t rampg_initslot(void *slot_arg, ramslot_node_t *node_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t rampg_gethugestats(size_t *regions_arg, size_t *backed_arg)
+{
+   RAM_FAIL_NOTNULL(regions_arg);
+   *regions_arg = 0;
+   RAM_FAIL_NOTNULL(backed_arg);
+   *backed_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rampg_theglobals.rampgg_initflag);
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+         0 != rampg_theglobals.rampgg_hugepagesize);
+
+   RAM_FAIL_TRAP(ramsys_hugestats(regions_arg, backed_arg, &rampg_overlap,
+         NULL));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_overlap(size_t *bytes_arg, char *start_arg, char *end_arg,
+      void *context_arg)
+{
+   ramlist_list_t *i = NULL;
+   uintptr_t lo = 0, hi = 0, start = 0, end = 0;
+   size_t n = 0;
+
+   assert(bytes_arg != NULL);
+   assert(start_arg != NULL);
+   assert(end_arg != NULL);
+   RAMANNOTATE_UNUSEDARG(context_arg);
+
+   start = (uintptr_t)start_arg;
+   end = (uintptr_t)end_arg;
+   /* every gluttonous region is a single huge page, so i add up how much of
+    * each one falls within the range. */
+   RAM_FAIL_TRAP(rammtx_wait(&rampg_theglobals.rampgg_hugemutex));
+   for (i = rampg_theglobals.rampgg_hugeregions.ramlistl_next;
+         &rampg_theglobals.rampgg_hugeregions != i; i = i->ramlistl_next)
+   {
+      lo = (uintptr_t)RAM_CAST_STRUCTBASE(rampg_hugeslot_t, rampghs_link, i);
+      hi = lo + rampg_theglobals.rampgg_hugepagesize;
+      if (lo < start)
+         lo = start;
+      if (hi > end)
+         hi = end;
+      if (lo < hi)
+         n += hi - lo;
+   }
+   RAM_FAIL_PANIC(rammtx_quit(&rampg_theglobals.rampgg_hugemutex));
+
+   *bytes_arg = n;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t rampg_getoverhead(size_t *metadata_arg, size_t *payload_arg)
+{
+   RAM_FAIL_NOTNULL(metadata_arg);
+   *metadata_arg = 0;
+   RAM_FAIL_NOTNULL(payload_arg);
+   *payload_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, rampg_theglobals.rampgg_initflag);
+
+   /* this describes the nodes of frugal and greedy pools, including the
+    * ownership map's entries for their pages. */
+   *metadata_arg = sizeof(rampg_slot_t) +
+         rampg_theglobals.rampgg_nodecapacity * sizeof(void *);
+   *payload_arg = rampg_theglobals.rampgg_nodecapacity *
+         rampg_theglobals.rampgg_pagesize;
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t rampg_getgranularity(size_t *granularity_arg)
 {
    RAM_FAIL_NOTNULL(granularity_arg);
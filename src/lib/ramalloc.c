@@ -34,16 +34,28 @@
 #include <ramalloc/ramalloc.h>
 #include <ramalloc/pg.h>
 #include <ramalloc/algn.h>
+#include <ramalloc/mux.h>
+#include <ramalloc/big.h>
+#include <ramalloc/tiny.h>
 #include <ramalloc/para.h>
 #include <ramalloc/mem.h>
+#include <ramalloc/rcy.h>
+#include <ramalloc/own.h>
+#include <ramalloc/vas.h>
 
 ram_reply_t ram_initialize(ram_malloc_t supmalloc_arg,
       ram_free_t supfree_arg)
 {
    RAM_FAIL_TRAP(ramsys_initialize());
    RAM_FAIL_TRAP(rammem_initialize(supmalloc_arg, supfree_arg));
+   RAM_FAIL_TRAP(ramrcy_initialize());
+   RAM_FAIL_TRAP(ramown_initialize());
+   RAM_FAIL_TRAP(ramvas_initialize());
    RAM_FAIL_TRAP(ram_slab_initialize());
    RAM_FAIL_TRAP(ramalgn_initialize());
+   RAM_FAIL_TRAP(rammux_initialize());
+   RAM_FAIL_TRAP(rambig_initialize());
+   RAM_FAIL_TRAP(ramtiny_initialize());
    RAM_FAIL_TRAP(ram_default_initialize());
 
    return RAM_REPLY_OK;
@@ -0,0 +1,309 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include <ramalloc/rcy.h>
+#include <ramalloc/atom.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/stdint.h>
+#include <assert.h>
+
+/* an array can't be empty, even if the recycler is disabled. */
+#if RAM_WANT_RECYCLECAPACITY
+#  define RAMRCY_SLOTCOUNT RAM_WANT_RECYCLECAPACITY
+#else
+#  define RAMRCY_SLOTCOUNT 1
+#endif
+
+/* reservations are aligned on page boundaries, so i can keep the commit
+ * flag in the least significant bit of the pointer i store. */
+#define RAMRCY_COMMITBIT ((uintptr_t)1)
+
+typedef struct ramrcy_globals
+{
+   /* a slot is NULL if it's vacant. slots are claimed and vacated with
+    * a compare-and-swap, so there is no need for a lock. */
+   void * volatile ramrcyg_slots[RAMRCY_SLOTCOUNT];
+   /* the count is incremented before a slot is claimed and decremented
+    * after a slot is vacated, so it never underestimates the number of
+    * occupied slots. */
+   ramatom_counter_t ramrcyg_count;
+   ramatom_counter_t ramrcyg_hits;
+   ramatom_counter_t ramrcyg_misses;
+   ramatom_counter_t ramrcyg_trims;
+   volatile size_t ramrcyg_low;
+   volatile size_t ramrcyg_high;
+   int ramrcyg_initflag;
+} ramrcy_globals_t;
+
+static ram_reply_t ramrcy_take(void **entry_arg);
+static ram_reply_t ramrcy_trim(size_t goal_arg);
+
+static ramrcy_globals_t ramrcy_theglobals;
+
+ram_reply_t ramrcy_initialize()
+{
+   if (!ramrcy_theglobals.ramrcyg_initflag)
+   {
+      ramrcy_theglobals.ramrcyg_high = RAM_WANT_RECYCLECAPACITY;
+      ramrcy_theglobals.ramrcyg_low = RAM_WANT_RECYCLECAPACITY / 2;
+      ramrcy_theglobals.ramrcyg_initflag = 1;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_setwatermarks(size_t low_arg, size_t high_arg)
+{
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, low_arg <= high_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL,
+         high_arg <= RAM_WANT_RECYCLECAPACITY);
+
+   ramrcy_theglobals.ramrcyg_low = low_arg;
+   ramrcy_theglobals.ramrcyg_high = high_arg;
+   /* if the recycler is now above its high watermark, i bring it down
+    * right away rather than wait for the next deposit. */
+   if ((size_t)ramrcy_theglobals.ramrcyg_count > high_arg)
+      RAM_FAIL_TRAP(ramrcy_trim(low_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_getwatermarks(size_t *low_arg, size_t *high_arg)
+{
+   RAM_FAIL_NOTNULL(low_arg);
+   *low_arg = 0;
+   RAM_FAIL_NOTNULL(high_arg);
+   *high_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+
+   *low_arg = ramrcy_theglobals.ramrcyg_low;
+   *high_arg = ramrcy_theglobals.ramrcyg_high;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_deposit(char *pages_arg, int commitflag_arg)
+{
+   void *entry = NULL;
+   size_t count = 0;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED,
+         0 == ((uintptr_t)pages_arg & RAMRCY_COMMITBIT));
+
+   entry = (void *)((uintptr_t)pages_arg |
+         (commitflag_arg ? RAMRCY_COMMITBIT : 0));
+   /* i claim a place in the count before i claim a slot. */
+   count = (size_t)ramatom_xadd(&ramrcy_theglobals.ramrcyg_count, 1) + 1;
+   if (count > ramrcy_theglobals.ramrcyg_high)
+   {
+      /* the recycler is full. i return this reservation to the system and
+       * drain the recycler down to its low watermark, so that a workload
+       * that's shrinking doesn't pay for a trim with every deposit. */
+      ramatom_xadd(&ramrcy_theglobals.ramrcyg_count, -1);
+      RAM_FAIL_TRAP(ramsys_release(pages_arg));
+      ramatom_xadd(&ramrcy_theglobals.ramrcyg_trims, 1);
+      RAM_FAIL_TRAP(ramrcy_trim(ramrcy_theglobals.ramrcyg_low));
+      return RAM_REPLY_OK;
+   }
+
+   /* every depositor that gets this far was counted at or below the high
+    * watermark, which cannot exceed the number of slots, so a vacant slot
+    * is guaranteed to turn up eventually. */
+   for (;;)
+   {
+      for (i = 0; i < RAMRCY_SLOTCOUNT; ++i)
+      {
+         if (NULL == ramrcy_theglobals.ramrcyg_slots[i] &&
+               NULL == ramatom_casptr(&ramrcy_theglobals.ramrcyg_slots[i],
+                  NULL, entry))
+         {
+            return RAM_REPLY_OK;
+         }
+      }
+   }
+}
+
+ram_reply_t ramrcy_withdraw(char **pages_arg, int *commitflag_arg)
+{
+   void *entry = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_NOTNULL(commitflag_arg);
+   *commitflag_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+
+   e = ramrcy_take(&entry);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      ramatom_xadd(&ramrcy_theglobals.ramrcyg_misses, 1);
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   ramatom_xadd(&ramrcy_theglobals.ramrcyg_hits, 1);
+   *pages_arg = (char *)((uintptr_t)entry & ~RAMRCY_COMMITBIT);
+   *commitflag_arg = (0 != ((uintptr_t)entry & RAMRCY_COMMITBIT));
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_flush()
+{
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+
+   RAM_FAIL_TRAP(ramrcy_trim(0));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_shed(size_t *count_arg, size_t goal_arg)
+{
+   void *entry = NULL;
+   size_t i = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(count_arg);
+   *count_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+
+   for (i = 0; i < goal_arg; ++i)
+   {
+      e = ramrcy_take(&entry);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_NOTFOUND:
+         *count_arg = i;
+         return RAM_REPLY_OK;
+      case RAM_REPLY_OK:
+         break;
+      }
+
+      RAM_FAIL_TRAP(ramsys_release(
+            (char *)((uintptr_t)entry & ~RAMRCY_COMMITBIT)));
+      ramatom_xadd(&ramrcy_theglobals.ramrcyg_trims, 1);
+   }
+
+   *count_arg = i;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_getstats(ramrcy_stats_t *stats_arg)
+{
+   RAM_FAIL_NOTNULL(stats_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramrcy_theglobals.ramrcyg_initflag);
+
+   stats_arg->ramrcys_count = ramrcy_theglobals.ramrcyg_count;
+   stats_arg->ramrcys_hits = ramrcy_theglobals.ramrcyg_hits;
+   stats_arg->ramrcys_misses = ramrcy_theglobals.ramrcyg_misses;
+   stats_arg->ramrcys_trims = ramrcy_theglobals.ramrcyg_trims;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramrcy_take(void **entry_arg)
+{
+   void *p = NULL;
+   size_t i = 0;
+
+   assert(entry_arg != NULL);
+   *entry_arg = NULL;
+
+   if (ramrcy_theglobals.ramrcyg_count <= 0)
+      return RAM_REPLY_NOTFOUND;
+   for (i = 0; i < RAMRCY_SLOTCOUNT; ++i)
+   {
+      p = ramrcy_theglobals.ramrcyg_slots[i];
+      if (NULL != p &&
+            p == ramatom_casptr(&ramrcy_theglobals.ramrcyg_slots[i], p, NULL))
+      {
+         ramatom_xadd(&ramrcy_theglobals.ramrcyg_count, -1);
+         *entry_arg = p;
+         return RAM_REPLY_OK;
+      }
+   }
+
+   /* the count might be nonzero because a depositor hasn't claimed its
+    * slot yet. i don't wait for it. */
+   return RAM_REPLY_NOTFOUND;
+}
+
+ram_reply_t ramrcy_trim(size_t goal_arg)
+{
+   void *entry = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   while ((long)goal_arg < ramrcy_theglobals.ramrcyg_count)
+   {
+      e = ramrcy_take(&entry);
+      switch (e)
+      {
+      default:
+         RAM_FAIL_TRAP(e);
+         /* i shouldn't ever get here. */
+         return RAM_REPLY_INSANE;
+      case RAM_REPLY_NOTFOUND:
+         /* someone else got there first. */
+         return RAM_REPLY_OK;
+      case RAM_REPLY_OK:
+         break;
+      }
+
+      RAM_FAIL_TRAP(ramsys_release(
+            (char *)((uintptr_t)entry & ~RAMRCY_COMMITBIT)));
+      ramatom_xadd(&ramrcy_theglobals.ramrcyg_trims, 1);
+   }
+
+   return RAM_REPLY_OK;
+}
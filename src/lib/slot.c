@@ -33,16 +33,12 @@
 
 #include <ramalloc/slot.h>
 #include <ramalloc/cast.h>
+#include <ramalloc/atom.h>
 #include <assert.h>
 #include <memory.h>
 
 #define RAMSLOT_NIL_INDEX (-1)
-
-typedef struct ramslot_footer
-{
-   /* in the object pool, the node is stored directly in the footer. */
-   ramslot_node_t ramslotf_node;
-} ramslot_footer_t;
+#define RAMSLOT_QUEUEDBIT ((uintptr_t)1)
 
 typedef struct ramslot_freeslot
 {
@@ -187,6 +183,105 @@ ram_reply_t ramslot_release(void *ptr_arg, ramslot_node_t *node_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramslot_gettoken(void **token_arg, ramslot_node_t *node_arg)
+{
+   RAM_FAIL_NOTNULL(token_arg);
+   *token_arg = NULL;
+   RAM_FAIL_NOTNULL(node_arg);
+
+   *token_arg = &node_arg->ramslotn_link;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramslot_gettokennode(ramslot_node_t **node_arg, void *token_arg)
+{
+   RAM_FAIL_NOTNULL(node_arg);
+   *node_arg = NULL;
+   RAM_FAIL_NOTNULL(token_arg);
+
+   *node_arg = RAM_CAST_STRUCTBASE(ramslot_node_t, ramslotn_link, token_arg);
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramslot_defer(int *queueflag_arg, void *token_arg, void *first_arg,
+   void *last_arg)
+{
+   ramslot_node_t *node = NULL;
+   void *head = NULL;
+
+   RAM_FAIL_NOTNULL(queueflag_arg);
+   *queueflag_arg = 0;
+   RAM_FAIL_NOTNULL(first_arg);
+   RAM_FAIL_NOTNULL(last_arg);
+   RAM_FAIL_TRAP(ramslot_gettokennode(&node, token_arg));
+   /* i need the low bit of the list's head for myself. */
+   assert(0 == ((uintptr_t)first_arg & RAMSLOT_QUEUEDBIT));
+
+   do
+   {
+      head = node->ramslotn_remote;
+      *(void **)last_arg = (void *)((uintptr_t)head & ~RAMSLOT_QUEUEDBIT);
+   }
+   while (head != ramatom_casptr(&node->ramslotn_remote, head,
+         (void *)((uintptr_t)first_arg | RAMSLOT_QUEUEDBIT)));
+
+   /* the thread that sets the queued bit is responsible for queuing the
+    * node. the objects i just deferred keep the node from being destroyed
+    * until the owner has merged them, which can't happen before the node
+    * has been queued. */
+   *queueflag_arg = (0 == ((uintptr_t)head & RAMSLOT_QUEUEDBIT));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramslot_merge(size_t *count_arg, int *emptyflag_arg, void *token_arg)
+{
+   ramslot_node_t *node = NULL;
+   ramslot_pool_t *pool = NULL;
+   ramslot_index_t idx = 0;
+   char *p = NULL, *next = NULL;
+   size_t n = 0;
+   int wasfull = 0;
+   int isempty = 0;
+
+   RAM_FAIL_NOTNULL(count_arg);
+   *count_arg = 0;
+   RAM_FAIL_NOTNULL(emptyflag_arg);
+   *emptyflag_arg = 0;
+
+   RAM_FAIL_TRAP(ramslot_gettokennode(&node, token_arg));
+   pool = RAM_CAST_STRUCTBASE(ramslot_pool_t, ramslotp_vpool,
+         node->ramslotn_vnode.ramvecn_vpool);
+   wasfull = RAMSLOT_ISFULL(node);
+
+   /* i take the entire list and clear the queued bit at the same time, so
+    * the next thread to defer an object will queue the node again. */
+   p = (char *)ramatom_xchgptr(&node->ramslotn_remote, NULL);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0 != ((uintptr_t)p & RAMSLOT_QUEUEDBIT));
+   p = (char *)((uintptr_t)p & ~RAMSLOT_QUEUEDBIT);
+   for (; NULL != p; p = next)
+   {
+      next = *(char **)p;
+      RAM_FAIL_TRAP(ramslot_calcindex(&idx, node, p));
+      ((ramslot_freeslot_t *)p)->ramslotfs_next = node->ramslotn_freestk;
+      node->ramslotn_freestk = idx;
+      ++n;
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, n <= node->ramslotn_count);
+   node->ramslotn_count -= (ramslot_size_t)n;
+   isempty = RAMSLOT_ISEMPTY(node);
+
+   /* the pool only has to hear about the whole batch once. if the node is
+    * now empty, it goes back to the page layer in one step. */
+   RAM_FAIL_PANIC(ramvec_release(&node->ramslotn_vnode, wasfull, isempty));
+   if (isempty)
+      RAM_FAIL_TRAP(pool->ramslotp_rmnode(node));
+
+   *count_arg = n;
+   *emptyflag_arg = isempty;
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramslot_mknode(ramvec_node_t **node_arg, ramvec_pool_t *pool_arg)
 {
    ram_reply_t e = RAM_REPLY_INSANE;
@@ -224,6 +319,8 @@ ram_reply_t ramslot_initnode(ramslot_node_t *node_arg, ramslot_pool_t *pool_arg,
    node_arg->ramslotn_slots = slots_arg;
    /* the node starts out empty... */
    node_arg->ramslotn_count = 0;
+   node_arg->ramslotn_remote = NULL;
+   node_arg->ramslotn_link = NULL;
    /* ...meaning the free list starts out full. */
    RAM_FAIL_TRAP(ramslot_sztoidx(&ii, pool_arg->ramslotp_vpool.ramvecvp_nodecapacity));
    for (i = ii - 1; i >= 0; j = (i--))
@@ -31,6 +31,11 @@
  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
 
+/* sched_getcpu() and mremap() are GNU extensions. */
+#ifndef _GNU_SOURCE
+#  define _GNU_SOURCE
+#endif
+
 /* <ramalloc/sys/linux.h> is included by <ramalloc/sys.h> if it's
  * appropriate for the platform. */
 #include <ramalloc/sys.h>
@@ -41,9 +46,227 @@
 #ifdef RAMSYS_LINUX
 
 #include <ramalloc/mtx.h>
+#include <ramalloc/mem.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/* the kernel advertises the size of a transparent huge page here. if the
+ * file is missing, the kernel doesn't support them. */
+#define RAMLIN_HUGEPAGESIZEPATH \
+   "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size"
 
 static ram_reply_t
    ramlin_waitonbarrier2(ramlin_barrier_t *barrier_arg);
+static ram_reply_t ramlin_hugestats2(size_t *regions_arg,
+      size_t *backed_arg, ramsys_overlap_t overlap_arg, void *context_arg,
+      FILE *smaps_arg);
+
+/* this is 0 if transparent huge pages aren't supported. */
+static size_t ramlin_thehugepgsz = 0;
+
+ram_reply_t ramlin_initialize()
+{
+   FILE *f = NULL;
+   unsigned long n = 0;
+
+   RAM_FAIL_TRAP(ramuix_initialize());
+
+   f = fopen(RAMLIN_HUGEPAGESIZEPATH, "r");
+   if (NULL != f)
+   {
+      if (1 == fscanf(f, "%lu", &n))
+         ramlin_thehugepgsz = n;
+      fclose(f);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlin_whichcpu(size_t *cpu_arg)
+{
+   int cpu = 0;
+
+   RAM_FAIL_NOTNULL(cpu_arg);
+   *cpu_arg = 0;
+
+   /* the answer can be stale by the time i return it, since nothing stops
+    * the thread from migrating. it's only good as a hint. */
+   cpu = sched_getcpu();
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, cpu >= 0);
+
+   *cpu_arg = (size_t)cpu;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlin_hugepagesize(size_t *hugepgsz_arg)
+{
+   RAM_FAIL_NOTNULL(hugepgsz_arg);
+   *hugepgsz_arg = 0;
+
+#ifdef MADV_HUGEPAGE
+   if (0 == ramlin_thehugepgsz)
+      return RAM_REPLY_UNSUPPORTED;
+
+   *hugepgsz_arg = ramlin_thehugepgsz;
+   return RAM_REPLY_OK;
+#else
+   return RAM_REPLY_UNSUPPORTED;
+#endif
+}
+
+ram_reply_t ramlin_reservehuge(char **pages_arg)
+{
+#ifdef MADV_HUGEPAGE
+   size_t hugepgsz = 0;
+   char *p = NULL, *q = NULL;
+   uintptr_t excess = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_TRAP(ramlin_hugepagesize(&hugepgsz));
+
+   /* mmap() won't align the region for me, so i ask for twice as much
+    * address space as i need and trim the excess from either end. */
+   p = mmap(NULL, 2 * hugepgsz, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, MAP_FAILED != p);
+   excess = (uintptr_t)p & (hugepgsz - 1);
+   q = excess ? p + (hugepgsz - excess) : p;
+   if (q > p)
+      RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == munmap(p, q - p));
+   if (q + hugepgsz < p + 2 * hugepgsz)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+            0 == munmap(q + hugepgsz, (p + 2 * hugepgsz) - (q + hugepgsz)));
+   }
+
+   /* the region is committed in its entirety; the kernel will back it with
+    * a huge page the first time any part of it is touched (assuming one is
+    * available). */
+   if (0 != madvise(q, hugepgsz, MADV_HUGEPAGE))
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == munmap(q, hugepgsz));
+      return RAM_REPLY_APIFAIL;
+   }
+
+   *pages_arg = q;
+   return RAM_REPLY_OK;
+#else
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+
+   return RAM_REPLY_UNSUPPORTED;
+#endif
+}
+
+ram_reply_t ramlin_releasehuge(char *pages_arg)
+{
+   size_t hugepgsz = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_TRAP(ramlin_hugepagesize(&hugepgsz));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED,
+         0 == ((uintptr_t)pages_arg & (hugepgsz - 1)));
+
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == munmap(pages_arg, hugepgsz));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlin_remaprange(char **newpages_arg, char *pages_arg,
+      size_t oldsize_arg, size_t newsize_arg)
+{
+   char *p = NULL;
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(newpages_arg);
+   *newpages_arg = NULL;
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(oldsize_arg);
+   RAM_FAIL_NOTZERO(newsize_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, pages_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   /* mremap() moves the page table entries rather than the contents, so
+    * growing a large range this way doesn't cost a copy. */
+   p = mremap(pages_arg, oldsize_arg, newsize_arg, MREMAP_MAYMOVE);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, MAP_FAILED != p);
+
+   *newpages_arg = p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramlin_hugestats(size_t *regions_arg, size_t *backed_arg,
+      ramsys_overlap_t overlap_arg, void *context_arg)
+{
+   FILE *f = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(regions_arg);
+   *regions_arg = 0;
+   RAM_FAIL_NOTNULL(backed_arg);
+   *backed_arg = 0;
+   RAM_FAIL_NOTNULL(overlap_arg);
+
+   f = fopen("/proc/self/smaps", "r");
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, NULL != f);
+   e = ramlin_hugestats2(regions_arg, backed_arg, overlap_arg, context_arg,
+         f);
+   fclose(f);
+
+   return e;
+}
+
+ram_reply_t ramlin_hugestats2(size_t *regions_arg, size_t *backed_arg,
+      ramsys_overlap_t overlap_arg, void *context_arg, FILE *smaps_arg)
+{
+   char line[256];
+   size_t hugepgsz = 0, total = 0, backed = 0, mine = 0;
+   unsigned long start = 0, end = 0, lo = 0, hi = 0, kb = 0, anonhuge = 0;
+
+   assert(regions_arg != NULL);
+   assert(backed_arg != NULL);
+   assert(overlap_arg != NULL);
+   assert(smaps_arg != NULL);
+
+   RAM_FAIL_TRAP(ramlin_hugepagesize(&hugepgsz));
+
+   /* every mapping in /proc/self/smaps starts with its address range and
+    * ends with a *VmFlags* line. i only consider mappings that were advised
+    * with MADV_HUGEPAGE (flagged as "hg") and only the parts of them that
+    * the caller claims. the kernel merges adjacent mappings with the same
+    * flags, though, so a mapping that's only partly the caller's can't be
+    * split any further: its huge pages are credited to the caller up to
+    * the size of the caller's part. */
+   while (NULL != fgets(line, sizeof(line), smaps_arg))
+   {
+      /* sscanf() may assign the first field even if the second one
+       * doesn't match, so i can't scan directly into 'start'. */
+      if (2 == sscanf(line, "%lx-%lx ", &lo, &hi))
+      {
+         start = lo;
+         end = hi;
+         anonhuge = 0;
+      }
+      else if (1 == sscanf(line, "AnonHugePages: %lu kB", &kb))
+         anonhuge = kb;
+      else if (0 == strncmp(line, "VmFlags:", 8) && NULL != strstr(line, " hg"))
+      {
+         RAM_FAIL_TRAP(overlap_arg(&mine, (char *)start, (char *)end,
+               context_arg));
+         total += mine;
+         backed += anonhuge * 1024 < mine ? anonhuge * 1024 : mine;
+      }
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, !ferror(smaps_arg));
+
+   *regions_arg = total / hugepgsz;
+   *backed_arg = backed / hugepgsz;
+   return RAM_REPLY_OK;
+}
 
 ram_reply_t ramlin_mkbarrier(ramlin_barrier_t *barrier_arg,
       size_t capacity_arg)
@@ -54,6 +277,7 @@ ram_reply_t ramlin_mkbarrier(ramlin_barrier_t *barrier_arg,
    barrier_arg->ramlinb_capacity = capacity_arg;
    barrier_arg->ramlinb_vacancy = capacity_arg;
    barrier_arg->ramlinb_cycle = 0;
+   barrier_arg->ramlinb_occupancy = 0;
    RAM_FAIL_TRAP(ramuix_mkmutex(&barrier_arg->ramlinb_mutex));
    RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
          0 == pthread_cond_init(&barrier_arg->ramlinb_cond, NULL));
@@ -63,10 +287,22 @@ ram_reply_t ramlin_mkbarrier(ramlin_barrier_t *barrier_arg,
 
 ram_reply_t ramlin_rmbarrier(ramlin_barrier_t *barrier_arg)
 {
+   size_t occupancy = 0;
+
    RAM_FAIL_NOTNULL(barrier_arg);
    /* i don't allow destruction of the barrier while it's in use. */
    RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
          barrier_arg->ramlinb_vacancy == barrier_arg->ramlinb_capacity);
+   /* the final thread to arrive can get here before the threads it woke
+    * have reacquired and released the mutex, in which case destroying the
+    * mutex fails. i wait for them to leave. */
+   do
+   {
+      RAM_FAIL_TRAP(rammtx_wait(&barrier_arg->ramlinb_mutex));
+      occupancy = barrier_arg->ramlinb_occupancy;
+      RAM_FAIL_PANIC(rammtx_quit(&barrier_arg->ramlinb_mutex));
+   }
+   while (occupancy > 0);
 
    RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
          0 == pthread_cond_destroy(&barrier_arg->ramlinb_cond));
@@ -82,7 +318,9 @@ ram_reply_t ramlin_waitonbarrier(ramlin_barrier_t *barrier_arg)
    RAM_FAIL_NOTNULL(barrier_arg);
 
    RAM_FAIL_TRAP(rammtx_wait(&barrier_arg->ramlinb_mutex));
+   ++barrier_arg->ramlinb_occupancy;
    e = ramlin_waitonbarrier2(barrier_arg);
+   --barrier_arg->ramlinb_occupancy;
    /* there's no point in continuing if i fail to release the mutex. */
    /* TODO: ..._quitmutex() looks like it might be a candidate to succeed-
     * or-die. */
@@ -43,10 +43,12 @@
 #include <ramalloc/mem.h>
 #include <ramalloc/cast.h>
 #include <ramalloc/annotate.h>
+#include <ramalloc/want.h>
 #include <errno.h>
 #include <sys/mman.h>
 #include <string.h>
 #include <libgen.h>
+#include <time.h>
 /* currently, there's a bug in splint that causes it to puke if <unistd.h>
  * is included. the known workaround is to wrap it in the following #ifdef.
  * see <http://bugs.debian.org/cgi-bin/bugreport.cgi?bug=473595> for more
@@ -58,6 +60,14 @@
  * *unrecog* errors. */
 /*@-unrecog@*/
 
+/* a reservation shouldn't count against the commit limit until its pages
+ * are actually committed. */
+#ifdef MAP_NORESERVE
+#  define RAMUIX_RESERVEFLAGS (MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE)
+#else
+#  define RAMUIX_RESERVEFLAGS (MAP_PRIVATE | MAP_ANONYMOUS)
+#endif
+
 static ram_reply_t ramuix_basename2(char *dest_arg, size_t len_arg,
       const char *pathn_arg);
 
@@ -85,8 +95,19 @@ ram_reply_t ramuix_pagesize(size_t *pagesz_arg)
 
 ram_reply_t ramuix_mmapgran(size_t *mmapgran_arg)
 {
-   /* on Linux, the memory mapping granularity is the page size. */
-   RAM_FAIL_TRAP(ramuix_pagesize(mmapgran_arg));
+   size_t pgsz = 0;
+
+   RAM_FAIL_NOTNULL(mmapgran_arg);
+   *mmapgran_arg = 0;
+
+   /* the hardware will map memory a page at a time but asking mmap() for
+    * a single page each time i need one is expensive (both in terms of
+    * system calls and the number of mappings the kernel has to keep track
+    * of). instead, i reserve RAM_WANT_RESERVEPAGES pages at a time and
+    * hand them out individually, much like Windows does with its
+    * allocation granularity. */
+   RAM_FAIL_TRAP(ramuix_pagesize(&pgsz));
+   *mmapgran_arg = pgsz * RAM_WANT_RESERVEPAGES;
 
    return RAM_REPLY_OK;
 }
@@ -107,41 +128,117 @@ ram_reply_t ramuix_cpucount(size_t *cpucount_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramuix_clock(uint64_t *nsec_arg)
+{
+   struct timespec ts;
+
+   RAM_FAIL_NOTNULL(nsec_arg);
+   *nsec_arg = 0;
+
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         0 == clock_gettime(CLOCK_MONOTONIC, &ts));
+   *nsec_arg = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramuix_commit(char *page_arg)
 {
-   RAMANNOTATE_UNUSEDARG(page_arg);
+   size_t pgsz = 0;
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(page_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, page_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   /* the page was reserved without any access rights. granting access
+    * is all that's necessary to commit it; the kernel will supply the
+    * physical memory when the page is first touched. */
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         0 == mprotect(page_arg, pgsz, PROT_READ | PROT_WRITE));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramuix_commitrange(char *pages_arg, size_t size_arg)
+{
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, pages_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   /* like ramuix_commit(), but a contiguous run of pages only costs me a
+    * single system call. */
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         0 == mprotect(pages_arg, size_arg, PROT_READ | PROT_WRITE));
 
-   /* there's no difference between commit and reserve on POSIX platforms.
-    * everything was already taken care of in ramuix_reserve(). */
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramuix_decommit(char *page_arg)
 {
-   RAMANNOTATE_UNUSEDARG(page_arg);
+   size_t pgsz = 0;
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(page_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, page_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   /* MADV_DONTNEED returns the physical memory to the system immediately;
+    * the page will read back as zeroes if it's touched again. */
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         0 == madvise(page_arg, pgsz, MADV_DONTNEED));
+   /* i also revoke access to the page so that stray references to it
+    * fault, as they would on Windows. */
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         0 == mprotect(page_arg, pgsz, PROT_NONE));
 
-   /* there's no difference between commit and reserve on POSIX platforms.
-    * everything will be taken care of in ramuix_release(). */
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramuix_reset(char *page_arg)
 {
-   /* POSIX doesn't offer an option analogous to *MEM_RESET* in Windows. */
-   return ramuix_decommit(page_arg);
+   size_t pgsz = 0;
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(page_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, page_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   /* MADV_FREE is the closest thing POSIX platforms have to *MEM_RESET* in
+    * Windows: the page remains committed but the kernel may reclaim the
+    * physical memory lazily, if and when it comes under memory pressure.
+    * kernels that predate MADV_FREE will reject it, in which case i fall
+    * back to MADV_DONTNEED, which keeps the page accessible but discards
+    * its contents right away. */
+#ifdef MADV_FREE
+   if (0 == madvise(page_arg, pgsz, MADV_FREE))
+      return RAM_REPLY_OK;
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, EINVAL == errno);
+#endif
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         0 == madvise(page_arg, pgsz, MADV_DONTNEED));
+
+   return RAM_REPLY_OK;
 }
 
 ram_reply_t ramuix_reserve(char **pages_arg)
 {
-   size_t pgsz = 0;
+   size_t mmapgran = 0;
    char *p = NULL;
 
    RAM_FAIL_NOTNULL(pages_arg);
    *pages_arg = NULL;
 
-   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
-   p = mmap(NULL, pgsz,
-         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   /* i only reserve address space here. the pages are inaccessible until
+    * they're committed with ramuix_commit(). */
+   RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
+   p = mmap(NULL, mmapgran, PROT_NONE, RAMUIX_RESERVEFLAGS, -1, 0);
    RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, MAP_FAILED != p);
 
    *pages_arg = p;
@@ -150,14 +247,14 @@ ram_reply_t ramuix_reserve(char **pages_arg)
 
 ram_reply_t ramuix_bulkalloc(char **pages_arg)
 {
-   size_t pgsz = 0;
+   size_t mmapgran = 0;
    char *p = NULL;
 
    RAM_FAIL_NOTNULL(pages_arg);
    *pages_arg = NULL;
 
-   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
-   p = mmap(NULL, pgsz,
+   RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
+   p = mmap(NULL, mmapgran,
          PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
    RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, MAP_FAILED != p);
 
@@ -167,16 +264,67 @@ ram_reply_t ramuix_bulkalloc(char **pages_arg)
 
 ram_reply_t ramuix_release(char *pages_arg)
 {
-   size_t pgsz = 0;
+   size_t mmapgran = 0;
    int ispage = 0;
 
    RAM_FAIL_NOTNULL(pages_arg);
    RAM_FAIL_TRAP(rammem_ispage(&ispage, pages_arg));
    RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
 
-   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
-   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == munmap(pages_arg, pgsz));
+   /* both ramuix_reserve() and ramuix_bulkalloc() map exactly one unit of
+    * the mapping granularity. */
+   RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == munmap(pages_arg, mmapgran));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramuix_reserverange(char **pages_arg, size_t size_arg)
+{
+   char *p = NULL;
 
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_NOTZERO(size_arg);
+
+   /* like ramuix_reserve(), except that the caller chooses the size. pages
+    * within the range are committed and decommitted individually. */
+   p = mmap(NULL, size_arg, PROT_NONE, RAMUIX_RESERVEFLAGS, -1, 0);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, MAP_FAILED != p);
+
+   *pages_arg = p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramuix_releaserange(char *pages_arg, size_t size_arg)
+{
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, pages_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == munmap(pages_arg, size_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramuix_maprange(char **pages_arg, size_t size_arg)
+{
+   char *p = NULL;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_NOTZERO(size_arg);
+
+   /* unlike ramuix_reserverange(), the range is readable and writable as
+    * soon as it's mapped. it's released with ramuix_releaserange(). */
+   p = mmap(NULL, size_arg, PROT_READ | PROT_WRITE,
+         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, MAP_FAILED != p);
+
+   *pages_arg = p;
    return RAM_REPLY_OK;
 }
 
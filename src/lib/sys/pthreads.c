@@ -53,7 +53,7 @@ typedef struct ramuix_startroutine
 
 static void * ramuix_startroutine(void *sr_arg);
 
-ram_reply_t ramuix_mktlskey(ramuix_tlskey_t *key_arg)
+ram_reply_t ramuix_mktlskey(ramuix_tlskey_t *key_arg, ramsys_tlsdtor_t dtor_arg)
 {
    RAM_FAIL_NOTNULL(key_arg);
    /* while stepping through this function, i noticed that 0 was the first
@@ -62,7 +62,7 @@ ram_reply_t ramuix_mktlskey(ramuix_tlskey_t *key_arg)
    *key_arg = -1;
 
    RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
-         0 == pthread_key_create(key_arg, NULL));
+         0 == pthread_key_create(key_arg, dtor_arg));
 
    return RAM_REPLY_OK;
 }
@@ -121,6 +121,22 @@ ram_reply_t ramuix_waitformutex(ramuix_mutex_t *mutex_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramuix_trywaitformutex(int *successflag_arg,
+      ramuix_mutex_t *mutex_arg)
+{
+   int err = 0;
+
+   RAM_FAIL_NOTNULL(successflag_arg);
+   *successflag_arg = 0;
+   RAM_FAIL_NOTNULL(mutex_arg);
+
+   err = pthread_mutex_trylock(mutex_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, 0 == err || EBUSY == err);
+   *successflag_arg = (0 == err);
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramuix_quitmutex(ramuix_mutex_t *mutex_arg)
 {
    RAM_FAIL_NOTNULL(mutex_arg);
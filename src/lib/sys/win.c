@@ -39,10 +39,12 @@
 
 #include <ramalloc/mem.h>
 #include <ramalloc/cast.h>
+#include <ramalloc/annotate.h>
 #include <stdio.h>
 #include <string.h>
 
 static SYSTEM_INFO ramwin_sysinfo = {0};
+static LARGE_INTEGER ramwin_qpcfreq = {0};
 
 static ram_reply_t ramwin_basename2(char *dest_arg, size_t len_arg, 
    const char *pathn_arg);
@@ -50,6 +52,8 @@ static ram_reply_t ramwin_basename2(char *dest_arg, size_t len_arg,
 ram_reply_t ramwin_initialize()
 {
    GetSystemInfo(&ramwin_sysinfo);
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         QueryPerformanceFrequency(&ramwin_qpcfreq));
 
    return RAM_REPLY_OK;
 }
@@ -84,6 +88,34 @@ ram_reply_t ramwin_cpucount(size_t *cpucount_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramwin_whichcpu(size_t *cpu_arg)
+{
+   RAM_FAIL_NOTNULL(cpu_arg);
+
+   /* the answer is only a hint; the thread can migrate at any time. */
+   *cpu_arg = GetCurrentProcessorNumber();
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramwin_clock(uint64_t *nsec_arg)
+{
+   LARGE_INTEGER count;
+   uint64_t freq = 0, ticks = 0;
+
+   RAM_FAIL_NOTNULL(nsec_arg);
+   *nsec_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT, ramwin_qpcfreq.QuadPart != 0);
+
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, QueryPerformanceCounter(&count));
+   freq = (uint64_t)ramwin_qpcfreq.QuadPart;
+   ticks = (uint64_t)count.QuadPart;
+   /* i convert the whole seconds separately to avoid overflowing. */
+   *nsec_arg = ticks / freq * 1000000000 + ticks % freq * 1000000000 / freq;
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramwin_commit(char *page_arg)
 {
    int ispage = 0;
@@ -100,6 +132,22 @@ ram_reply_t ramwin_commit(char *page_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramwin_commitrange(char *pages_arg, size_t size_arg)
+{
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, pages_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+      VirtualAlloc(pages_arg, size_arg, MEM_COMMIT, PAGE_READWRITE)
+      == pages_arg);
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramwin_decommit(char *page_arg)
 {
    int ispage = 0;
@@ -177,15 +225,116 @@ ram_reply_t ramwin_release(char *pages_arg)
    return RAM_REPLY_OK;
 }
 
-ram_reply_t ramwin_mktlskey(ramwin_tlskey_t *key_arg)
+ram_reply_t ramwin_maprange(char **pages_arg, size_t size_arg)
+{
+   char *p = NULL;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_NOTZERO(size_arg);
+
+   p = (char *)VirtualAlloc(NULL, size_arg, MEM_RESERVE | MEM_COMMIT,
+         PAGE_READWRITE);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, p != NULL);
+
+   *pages_arg = p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramwin_remaprange(char **newpages_arg, char *pages_arg,
+      size_t oldsize_arg, size_t newsize_arg)
+{
+   RAM_FAIL_NOTNULL(newpages_arg);
+   *newpages_arg = NULL;
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(oldsize_arg);
+   RAM_FAIL_NOTZERO(newsize_arg);
+
+   /* Windows has no equivalent to mremap(); the caller has to copy. */
+   return RAM_REPLY_UNSUPPORTED;
+}
+
+ram_reply_t ramwin_reserverange(char **pages_arg, size_t size_arg)
+{
+   char *p = NULL;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_NOTZERO(size_arg);
+
+   p = (char *)VirtualAlloc(NULL, size_arg, MEM_RESERVE, PAGE_NOACCESS);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, p != NULL);
+
+   *pages_arg = p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramwin_releaserange(char *pages_arg, size_t size_arg)
+{
+   int ispage = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_TRAP(rammem_ispage(&ispage, pages_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ispage);
+
+   /* VirtualFree() releases the entire reservation at once. */
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         VirtualFree(pages_arg, 0, MEM_RELEASE));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramwin_hugepagesize(size_t *hugepgsz_arg)
+{
+   RAM_FAIL_NOTNULL(hugepgsz_arg);
+   *hugepgsz_arg = 0;
+
+   /* large pages on Windows require the *SeLockMemoryPrivilege* privilege
+    * and must be committed all at once, so gluttonous pools aren't
+    * supported on this platform. */
+   return RAM_REPLY_UNSUPPORTED;
+}
+
+ram_reply_t ramwin_reservehuge(char **pages_arg)
+{
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+
+   return RAM_REPLY_UNSUPPORTED;
+}
+
+ram_reply_t ramwin_releasehuge(char *pages_arg)
+{
+   RAM_FAIL_NOTNULL(pages_arg);
+
+   return RAM_REPLY_UNSUPPORTED;
+}
+
+ram_reply_t ramwin_hugestats(size_t *regions_arg, size_t *backed_arg,
+      ramsys_overlap_t overlap_arg, void *context_arg)
+{
+   RAM_FAIL_NOTNULL(regions_arg);
+   *regions_arg = 0;
+   RAM_FAIL_NOTNULL(backed_arg);
+   *backed_arg = 0;
+   RAM_FAIL_NOTNULL(overlap_arg);
+   RAMANNOTATE_UNUSEDARG(context_arg);
+
+   return RAM_REPLY_UNSUPPORTED;
+}
+
+ram_reply_t ramwin_mktlskey(ramwin_tlskey_t *key_arg, ramsys_tlsdtor_t dtor_arg)
 {
    ramwin_tlskey_t k = RAMWIN_NILTLSKEY;
 
    RAM_FAIL_NOTNULL(key_arg);
    *key_arg = RAMWIN_NILTLSKEY;
 
-   k = TlsAlloc();
-   if (TLS_OUT_OF_INDEXES == k)
+   /* i use fiber local storage because it's the only flavor of local
+    * storage on Windows that calls a destructor when a thread exits. */
+   k = FlsAlloc(dtor_arg);
+   if (FLS_OUT_OF_INDEXES == k)
       return RAM_REPLY_RESOURCEFAIL;
    else
    {
@@ -198,7 +347,7 @@ ram_reply_t ramwin_rmtlskey(ramwin_tlskey_t key_arg)
 {
    RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, key_arg != RAMWIN_NILTLSKEY);
 
-   if (TlsFree(key_arg))
+   if (FlsFree(key_arg))
       return RAM_REPLY_OK;
    else
       return RAM_REPLY_APIFAIL;
@@ -212,10 +361,10 @@ ram_reply_t ramwin_rcltls(void **value_arg, ramwin_tlskey_t key_arg)
    *value_arg = NULL;
    RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, key_arg != RAMWIN_NILTLSKEY);
 
-   p = TlsGetValue(key_arg);
+   p = FlsGetValue(key_arg);
    /* NULL is an ambiguous return value. i must check to see if an error
     * occurrs to be certain. */
-   /* TODO: TlsGetValue() doesn't check whether key_arg is valid, so i'd need
+   /* TODO: FlsGetValue() doesn't check whether key_arg is valid, so i'd need
     * to implement this check (or ensure it's validity) myself. */
    if (p || ERROR_SUCCESS == GetLastError())
    {
@@ -231,7 +380,7 @@ ram_reply_t ramwin_stotls(ramwin_tlskey_t key_arg, void *value_arg)
    RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, key_arg != RAMWIN_NILTLSKEY);
    RAM_FAIL_NOTNULL(value_arg);
 
-   if (TlsSetValue(key_arg, value_arg))
+   if (FlsSetValue(key_arg, value_arg))
       return RAM_REPLY_OK;
    else
       return RAM_REPLY_APIFAIL;
@@ -265,6 +414,18 @@ ram_reply_t ramwin_waitformutex(ramwin_mutex_t *mutex_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramwin_trywaitformutex(int *successflag_arg,
+      ramwin_mutex_t *mutex_arg)
+{
+   RAM_FAIL_NOTNULL(successflag_arg);
+   *successflag_arg = 0;
+   RAM_FAIL_NOTNULL(mutex_arg);
+
+   *successflag_arg = (0 != TryEnterCriticalSection(mutex_arg));
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramwin_quitmutex(ramwin_mutex_t *mutex_arg)
 {
    RAM_FAIL_NOTNULL(mutex_arg);
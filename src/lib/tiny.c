@@ -0,0 +1,862 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include <ramalloc/tiny.h>
+#include <ramalloc/atom.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/mtx.h>
+#include <ramalloc/own.h>
+#include <ramalloc/pg.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/tls.h>
+#include <ramalloc/stdint.h>
+#include <assert.h>
+#include <string.h>
+
+/* there's a class for each of 1, 2 and 4 byte cells. */
+#define RAMTINY_CLASSCOUNT 3
+#define RAMTINY_WORDBITS (sizeof(uintptr_t) * 8)
+/* the header is followed by two bitmaps: the local one, which only the
+ * owner touches, and the remote one, which other threads mark. a set bit
+ * means the cell is free. */
+#define RAMTINY_HEADERSIZE \
+   ((sizeof(ramtiny_page_t) + sizeof(uintptr_t) - 1) & \
+      ~(sizeof(uintptr_t) - 1))
+#define RAMTINY_LOCAL(Page) \
+   ((uintptr_t *)((char *)(Page) + RAMTINY_HEADERSIZE))
+#define RAMTINY_REMOTE(Page, Class) \
+   ((void * volatile *)(RAMTINY_LOCAL(Page) + (Class)->ramtinyc_words))
+#define RAMTINY_CELLS(Page, Class) ((char *)(Page) + (Class)->ramtinyc_offset)
+#define RAMTINY_ISONLY(Heap, Page) \
+   ((Heap)->ramtinyh_avail[(Page)->ramtinypg_class] == (Page) && \
+      NULL == (Page)->ramtinypg_next)
+
+typedef struct ramtiny_heap ramtiny_heap_t;
+
+typedef struct ramtiny_page
+{
+   ramtiny_heap_t *ramtinypg_heap;
+   /* links the page into its heap's list of pages with free cells. */
+   struct ramtiny_page *ramtinypg_next;
+   struct ramtiny_page *ramtinypg_prev;
+   /* links the page into its heap's pending stack. */
+   struct ramtiny_page *ramtinypg_pending;
+   /* the number of cells other threads have discarded that the owner
+    * hasn't merged yet. it's incremented before the cell is marked, so the
+    * page can't be found empty (and released) while another thread might
+    * still touch it. */
+   ramatom_counter_t ramtinypg_remote;
+   size_t ramtinypg_class;
+   /* the number of free cells in the local bitmap. */
+   size_t ramtinypg_free;
+   /* no word of the local bitmap before this one has a free cell. */
+   size_t ramtinypg_hint;
+   int ramtinypg_linkflag;
+} ramtiny_page_t;
+
+struct ramtiny_heap
+{
+   rampg_pool_t ramtinyh_pgpool;
+   /* cells are taken from the first page of each list. */
+   ramtiny_page_t *ramtinyh_avail[RAMTINY_CLASSCOUNT];
+   /* pages other threads have discarded cells into, linked through
+    * *ramtinypg_pending*. it's pushed with a compare-and-swap and emptied
+    * all at once by the owner, so it isn't vulnerable to ABA. */
+   void * volatile ramtinyh_pending;
+   /* links the heap into the orphanage once its thread has exited. */
+   ramtiny_heap_t *ramtinyh_nextorphan;
+};
+
+typedef struct ramtiny_class
+{
+   size_t ramtinyc_cellsize;
+   size_t ramtinyc_capacity;
+   /* the number of words in each bitmap. */
+   size_t ramtinyc_words;
+   /* the offset of the first cell from the beginning of the page. */
+   size_t ramtinyc_offset;
+} ramtiny_class_t;
+
+typedef struct ramtiny_globals
+{
+   /* every page the tier holds is in the map. */
+   ramown_map_t ramtinyg_map;
+   ramtiny_class_t ramtinyg_classes[RAMTINY_CLASSCOUNT];
+   size_t ramtinyg_pagesize;
+   ramtls_key_t ramtinyg_tlskey;
+   /* the mutex protects the orphanage. */
+   rammtx_mutex_t ramtinyg_mutex;
+   ramtiny_heap_t *ramtinyg_orphans;
+   ramatom_counter_t ramtinyg_pages;
+   ramatom_counter_t ramtinyg_remote;
+   ramatom_counter_t ramtinyg_adoptions;
+   int ramtinyg_initflag;
+} ramtiny_globals_t;
+
+static ram_reply_t ramtiny_calcclass(ramtiny_class_t *class_arg,
+      size_t cellsize_arg, size_t pagesize_arg);
+static size_t ramtiny_classof(size_t size_arg);
+static ram_reply_t ramtiny_rclheap(ramtiny_heap_t **heap_arg,
+      int createflag_arg);
+static ram_reply_t ramtiny_mkheap(ramtiny_heap_t **heap_arg);
+static ram_reply_t ramtiny_mkpage(ramtiny_page_t **page_arg,
+      ramtiny_heap_t *heap_arg, size_t class_arg);
+static ram_reply_t ramtiny_rmpage(ramtiny_page_t *page_arg);
+static void ramtiny_link(ramtiny_page_t *page_arg);
+static void ramtiny_unlink(ramtiny_page_t *page_arg);
+static ram_reply_t ramtiny_take(void **newptr_arg, ramtiny_page_t *page_arg);
+static ram_reply_t ramtiny_calcindex(size_t *idx_arg,
+      const ramtiny_page_t *page_arg, const char *ptr_arg);
+static ram_reply_t ramtiny_putlocal(ramtiny_page_t *page_arg, size_t idx_arg);
+static ram_reply_t ramtiny_putremote(ramtiny_page_t *page_arg,
+      size_t idx_arg);
+static void ramtiny_push(ramtiny_heap_t *heap_arg, ramtiny_page_t *page_arg);
+static ram_reply_t ramtiny_merge(ramtiny_heap_t *heap_arg);
+static ram_reply_t ramtiny_mergepage(ramtiny_page_t *page_arg);
+static ram_reply_t ramtiny_flush2(ramtiny_heap_t *heap_arg);
+static ram_reply_t ramtiny_chkpage(const ramtiny_page_t *page_arg,
+      const ramtiny_heap_t *heap_arg);
+static void RAMSYS_TLSDTORDECL ramtiny_orphan(void *heap_arg);
+static ram_reply_t ramtiny_orphan2(ramtiny_heap_t *heap_arg);
+
+static ramtiny_globals_t ramtiny_theglobals;
+
+#if RAM_WANT_COMPILERTLS
+/* the calling thread's heap is remembered here, so that it doesn't have
+ * to ask the threading library for it every time. */
+static RAMSYS_THREADLOCAL ramtiny_heap_t *ramtiny_thecache;
+#endif
+
+ram_reply_t ramtiny_initialize()
+{
+   size_t i = 0;
+
+   if (!ramtiny_theglobals.ramtinyg_initflag)
+   {
+      RAM_FAIL_TRAP(rampg_getgranularity(
+            &ramtiny_theglobals.ramtinyg_pagesize));
+      for (i = 0; i < RAMTINY_CLASSCOUNT; ++i)
+      {
+         RAM_FAIL_TRAP(ramtiny_calcclass(
+               &ramtiny_theglobals.ramtinyg_classes[i], (size_t)1 << i,
+               ramtiny_theglobals.ramtinyg_pagesize));
+      }
+      RAM_FAIL_TRAP(rammtx_mkmutex(&ramtiny_theglobals.ramtinyg_mutex));
+      RAM_FAIL_TRAP(ramtls_mkkey(&ramtiny_theglobals.ramtinyg_tlskey,
+            &ramtiny_orphan));
+      ramtiny_theglobals.ramtinyg_initflag = 1;
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_acquire(void **newptr_arg, size_t size_arg)
+{
+   ramtiny_heap_t *heap = NULL;
+   ramtiny_page_t *page = NULL;
+   size_t cls = 0;
+
+   RAM_FAIL_NOTNULL(newptr_arg);
+   *newptr_arg = NULL;
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   if (size_arg > RAMTINY_MAXCELLSIZE)
+      return RAM_REPLY_RANGEFAIL;
+   cls = ramtiny_classof(size_arg);
+
+   RAM_FAIL_TRAP(ramtiny_rclheap(&heap, 1));
+   page = heap->ramtinyh_avail[cls];
+   if (NULL == page)
+   {
+      /* before i ask for another page, i collect whatever other threads
+       * have given back. */
+      RAM_FAIL_TRAP(ramtiny_merge(heap));
+      page = heap->ramtinyh_avail[cls];
+      if (NULL == page)
+         RAM_FAIL_TRAP(ramtiny_mkpage(&page, heap, cls));
+   }
+   RAM_FAIL_TRAP(ramtiny_take(newptr_arg, page));
+
+#if RAM_WANT_ZEROMEM
+   memset(*newptr_arg, 0,
+         ramtiny_theglobals.ramtinyg_classes[cls].ramtinyc_cellsize);
+#endif
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_release(void *ptr_arg)
+{
+   void *owner = NULL;
+   ramtiny_page_t *page = NULL;
+   ramtiny_heap_t *heap = NULL;
+   size_t idx = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(ptr_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   e = ramown_get(&owner, &ramtiny_theglobals.ramtinyg_map, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   page = (ramtiny_page_t *)owner;
+   RAM_FAIL_TRAP(ramtiny_calcindex(&idx, page, (char *)ptr_arg));
+#if RAM_WANT_MARKFREED
+   memset(ptr_arg, RAM_WANT_MARKFREED, ramtiny_theglobals.ramtinyg_classes[
+         page->ramtinypg_class].ramtinyc_cellsize);
+#endif
+
+   /* i don't want to create a heap for a thread that doesn't have one. */
+   RAM_FAIL_TRAP(ramtiny_rclheap(&heap, 0));
+   if (heap == page->ramtinypg_heap)
+      RAM_FAIL_TRAP(ramtiny_putlocal(page, idx));
+   else
+      RAM_FAIL_TRAP(ramtiny_putremote(page, idx));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_query(size_t *size_arg, void *ptr_arg)
+{
+   void *owner = NULL;
+   ramtiny_page_t *page = NULL;
+   const ramtiny_class_t *cls = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(size_arg);
+   *size_arg = 0;
+   RAM_FAIL_NOTNULL(ptr_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   e = ramown_get(&owner, &ramtiny_theglobals.ramtinyg_map, ptr_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_NOTFOUND:
+      return e;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   page = (ramtiny_page_t *)owner;
+   cls = &ramtiny_theglobals.ramtinyg_classes[page->ramtinypg_class];
+   /* the page's header and bitmaps were never handed out. */
+   if ((char *)ptr_arg < RAMTINY_CELLS(page, cls) || (char *)ptr_arg >=
+         RAMTINY_CELLS(page, cls) +
+            cls->ramtinyc_capacity * cls->ramtinyc_cellsize)
+   {
+      return RAM_REPLY_NOTFOUND;
+   }
+
+   *size_arg = cls->ramtinyc_cellsize;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_flush()
+{
+   ramtiny_heap_t *heap = NULL;
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   RAM_FAIL_TRAP(ramtiny_rclheap(&heap, 0));
+   if (NULL != heap)
+      RAM_FAIL_TRAP(ramtiny_flush2(heap));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_getcapacity(size_t *cells_arg, size_t size_arg)
+{
+   RAM_FAIL_NOTNULL(cells_arg);
+   *cells_arg = 0;
+   RAM_FAIL_NOTZERO(size_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   if (size_arg > RAMTINY_MAXCELLSIZE)
+      return RAM_REPLY_RANGEFAIL;
+
+   *cells_arg = ramtiny_theglobals.ramtinyg_classes[
+         ramtiny_classof(size_arg)].ramtinyc_capacity;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_getstats(ramtiny_stats_t *stats_arg)
+{
+   RAM_FAIL_NOTNULL(stats_arg);
+   memset(stats_arg, 0, sizeof(*stats_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   stats_arg->ramtinys_pages = (size_t)ramtiny_theglobals.ramtinyg_pages;
+   stats_arg->ramtinys_remote = (size_t)ramtiny_theglobals.ramtinyg_remote;
+   stats_arg->ramtinys_adoptions =
+         (size_t)ramtiny_theglobals.ramtinyg_adoptions;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_chkheap()
+{
+   ramtiny_heap_t *heap = NULL;
+   const ramtiny_page_t *page = NULL;
+   size_t i = 0;
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INCONSISTENT,
+         ramtiny_theglobals.ramtinyg_initflag);
+
+   RAM_FAIL_TRAP(ramtiny_rclheap(&heap, 0));
+   if (NULL == heap)
+      return RAM_REPLY_OK;
+
+   for (i = 0; i < RAMTINY_CLASSCOUNT; ++i)
+   {
+      for (page = heap->ramtinyh_avail[i]; NULL != page;
+            page = page->ramtinypg_next)
+      {
+         RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, i == page->ramtinypg_class);
+         RAM_FAIL_TRAP(ramtiny_chkpage(page, heap));
+      }
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_calcclass(ramtiny_class_t *class_arg,
+      size_t cellsize_arg, size_t pagesize_arg)
+{
+   size_t cap = 0, words = 0, offset = 0;
+
+   assert(class_arg != NULL);
+   assert(cellsize_arg > 0);
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, pagesize_arg > RAMTINY_HEADERSIZE);
+   /* each cell costs its own size plus two bits. i start with an estimate
+    * that ignores the rounding of the bitmaps to whole words and work my
+    * way down. */
+   cap = (pagesize_arg - RAMTINY_HEADERSIZE) * 8 / (cellsize_arg * 8 + 2);
+   for (;;)
+   {
+      words = (cap + RAMTINY_WORDBITS - 1) / RAMTINY_WORDBITS;
+      offset = RAMTINY_HEADERSIZE + 2 * words * sizeof(uintptr_t);
+      if (offset + cap * cellsize_arg <= pagesize_arg)
+         break;
+      --cap;
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, cap > 0);
+
+   class_arg->ramtinyc_cellsize = cellsize_arg;
+   class_arg->ramtinyc_capacity = cap;
+   class_arg->ramtinyc_words = words;
+   class_arg->ramtinyc_offset = offset;
+   return RAM_REPLY_OK;
+}
+
+size_t ramtiny_classof(size_t size_arg)
+{
+   assert(size_arg > 0 && size_arg <= RAMTINY_MAXCELLSIZE);
+
+   /* 1 -> 0, 2 -> 1, 3 and 4 -> 2. */
+   return size_arg > 2 ? 2 : size_arg - 1;
+}
+
+ram_reply_t ramtiny_rclheap(ramtiny_heap_t **heap_arg, int createflag_arg)
+{
+   void *p = NULL;
+
+   assert(heap_arg != NULL);
+
+#if RAM_WANT_COMPILERTLS
+   if (NULL != ramtiny_thecache)
+   {
+      *heap_arg = ramtiny_thecache;
+      return RAM_REPLY_OK;
+   }
+#endif
+
+   RAM_FAIL_TRAP(ramtls_rcl(&p, ramtiny_theglobals.ramtinyg_tlskey));
+   if (NULL == p && createflag_arg)
+   {
+      RAM_FAIL_TRAP(ramtiny_mkheap((ramtiny_heap_t **)&p));
+      RAM_FAIL_TRAP(ramtls_sto(ramtiny_theglobals.ramtinyg_tlskey, p));
+   }
+
+#if RAM_WANT_COMPILERTLS
+   ramtiny_thecache = (ramtiny_heap_t *)p;
+#endif
+   *heap_arg = (ramtiny_heap_t *)p;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_mkheap(ramtiny_heap_t **heap_arg)
+{
+   ramtiny_heap_t *heap = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(heap_arg != NULL);
+
+   /* a heap left behind by an exiting thread might still hold cells that
+    * are in use, so i prefer to adopt one. */
+   RAM_FAIL_TRAP(rammtx_wait(&ramtiny_theglobals.ramtinyg_mutex));
+   heap = ramtiny_theglobals.ramtinyg_orphans;
+   if (NULL != heap)
+   {
+      ramtiny_theglobals.ramtinyg_orphans = heap->ramtinyh_nextorphan;
+      heap->ramtinyh_nextorphan = NULL;
+   }
+   RAM_FAIL_PANIC(rammtx_quit(&ramtiny_theglobals.ramtinyg_mutex));
+   if (NULL != heap)
+   {
+      ramatom_xadd(&ramtiny_theglobals.ramtinyg_adoptions, 1);
+      *heap_arg = heap;
+      return RAM_REPLY_OK;
+   }
+
+   heap = rammem_supmalloc(sizeof(*heap));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != heap);
+   memset(heap, 0, sizeof(*heap));
+   e = rampg_mkpool(&heap->ramtinyh_pgpool, RAMOPT_FRUGAL);
+   if (RAM_REPLY_OK != e)
+   {
+      rammem_supfree(heap);
+      return e;
+   }
+
+   *heap_arg = heap;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_mkpage(ramtiny_page_t **page_arg,
+      ramtiny_heap_t *heap_arg, size_t class_arg)
+{
+   ramtiny_page_t *page = NULL;
+   const ramtiny_class_t *cls = NULL;
+   uintptr_t *local = NULL;
+   size_t i = 0, tail = 0;
+   void *p = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   assert(page_arg != NULL);
+   assert(heap_arg != NULL);
+   assert(class_arg < RAMTINY_CLASSCOUNT);
+
+   cls = &ramtiny_theglobals.ramtinyg_classes[class_arg];
+   RAM_FAIL_TRAP(rampg_acquire(&p, &heap_arg->ramtinyh_pgpool));
+   page = (ramtiny_page_t *)p;
+   /* the header and both bitmaps start out clear... */
+   memset(page, 0, cls->ramtinyc_offset);
+   page->ramtinypg_heap = heap_arg;
+   page->ramtinypg_class = class_arg;
+   page->ramtinypg_free = cls->ramtinyc_capacity;
+   /* ...and then every cell is marked free in the local bitmap. */
+   local = RAMTINY_LOCAL(page);
+   for (i = 0; i < cls->ramtinyc_capacity / RAMTINY_WORDBITS; ++i)
+      local[i] = ~(uintptr_t)0;
+   tail = cls->ramtinyc_capacity % RAMTINY_WORDBITS;
+   if (tail)
+      local[i] = ((uintptr_t)1 << tail) - 1;
+
+   e = ramown_set(&ramtiny_theglobals.ramtinyg_map, page, page);
+   if (RAM_REPLY_OK != e)
+   {
+      RAM_FAIL_PANIC(rampg_release(page));
+      return e;
+   }
+
+   ramtiny_link(page);
+   ramatom_xadd(&ramtiny_theglobals.ramtinyg_pages, 1);
+   *page_arg = page;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_rmpage(ramtiny_page_t *page_arg)
+{
+   assert(page_arg != NULL);
+
+   if (page_arg->ramtinypg_linkflag)
+      ramtiny_unlink(page_arg);
+   RAM_FAIL_TRAP(ramown_set(&ramtiny_theglobals.ramtinyg_map, page_arg,
+         NULL));
+   RAM_FAIL_TRAP(rampg_release(page_arg));
+   ramatom_xadd(&ramtiny_theglobals.ramtinyg_pages, -1);
+
+   return RAM_REPLY_OK;
+}
+
+void ramtiny_link(ramtiny_page_t *page_arg)
+{
+   ramtiny_page_t **head = NULL;
+
+   assert(page_arg != NULL);
+   assert(!page_arg->ramtinypg_linkflag);
+
+   head = &page_arg->ramtinypg_heap->ramtinyh_avail[
+         page_arg->ramtinypg_class];
+   page_arg->ramtinypg_prev = NULL;
+   page_arg->ramtinypg_next = *head;
+   if (NULL != *head)
+      (*head)->ramtinypg_prev = page_arg;
+   *head = page_arg;
+   page_arg->ramtinypg_linkflag = 1;
+}
+
+void ramtiny_unlink(ramtiny_page_t *page_arg)
+{
+   assert(page_arg != NULL);
+   assert(page_arg->ramtinypg_linkflag);
+
+   if (NULL == page_arg->ramtinypg_prev)
+   {
+      page_arg->ramtinypg_heap->ramtinyh_avail[page_arg->ramtinypg_class] =
+            page_arg->ramtinypg_next;
+   }
+   else
+      page_arg->ramtinypg_prev->ramtinypg_next = page_arg->ramtinypg_next;
+   if (NULL != page_arg->ramtinypg_next)
+      page_arg->ramtinypg_next->ramtinypg_prev = page_arg->ramtinypg_prev;
+   page_arg->ramtinypg_next = NULL;
+   page_arg->ramtinypg_prev = NULL;
+   page_arg->ramtinypg_linkflag = 0;
+}
+
+ram_reply_t ramtiny_take(void **newptr_arg, ramtiny_page_t *page_arg)
+{
+   const ramtiny_class_t *cls = NULL;
+   uintptr_t *local = NULL;
+   size_t w = 0, bit = 0;
+
+   assert(newptr_arg != NULL);
+   assert(page_arg != NULL);
+   assert(page_arg->ramtinypg_free > 0);
+
+   cls = &ramtiny_theglobals.ramtinyg_classes[page_arg->ramtinypg_class];
+   local = RAMTINY_LOCAL(page_arg);
+   for (w = page_arg->ramtinypg_hint; 0 == local[w]; ++w)
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, w + 1 < cls->ramtinyc_words);
+   bit = (size_t)RAMSYS_CTZ64((uint64_t)local[w]);
+   /* this clears the lowest set bit. */
+   local[w] &= local[w] - 1;
+   page_arg->ramtinypg_hint = w;
+   if (0 == --page_arg->ramtinypg_free)
+      ramtiny_unlink(page_arg);
+
+   *newptr_arg = RAMTINY_CELLS(page_arg, cls) +
+         (w * RAMTINY_WORDBITS + bit) * cls->ramtinyc_cellsize;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_calcindex(size_t *idx_arg,
+      const ramtiny_page_t *page_arg, const char *ptr_arg)
+{
+   const ramtiny_class_t *cls = NULL;
+   const char *cells = NULL;
+   size_t offset = 0;
+
+   assert(idx_arg != NULL);
+   assert(page_arg != NULL);
+   assert(ptr_arg != NULL);
+
+   cls = &ramtiny_theglobals.ramtinyg_classes[page_arg->ramtinypg_class];
+   cells = RAMTINY_CELLS(page_arg, cls);
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED, ptr_arg >= cells);
+   offset = (size_t)(ptr_arg - cells);
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED,
+         0 == offset % cls->ramtinyc_cellsize);
+   *idx_arg = offset / cls->ramtinyc_cellsize;
+   RAM_FAIL_EXPECT(RAM_REPLY_DISALLOWED,
+         *idx_arg < cls->ramtinyc_capacity);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_putlocal(ramtiny_page_t *page_arg, size_t idx_arg)
+{
+   const ramtiny_class_t *cls = NULL;
+   uintptr_t *local = NULL;
+   uintptr_t mask = 0;
+   size_t w = 0;
+
+   assert(page_arg != NULL);
+
+   cls = &ramtiny_theglobals.ramtinyg_classes[page_arg->ramtinypg_class];
+   local = RAMTINY_LOCAL(page_arg);
+   w = idx_arg / RAMTINY_WORDBITS;
+   mask = (uintptr_t)1 << (idx_arg % RAMTINY_WORDBITS);
+   /* a cell that's already free has been discarded twice. */
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0 == (local[w] & mask));
+   local[w] |= mask;
+   if (w < page_arg->ramtinypg_hint)
+      page_arg->ramtinypg_hint = w;
+   ++page_arg->ramtinypg_free;
+   if (!page_arg->ramtinypg_linkflag)
+      ramtiny_link(page_arg);
+   /* i hold onto the last page of each class, so that a thread that
+    * acquires and discards a single cell doesn't thrash. */
+   else if (cls->ramtinyc_capacity == page_arg->ramtinypg_free &&
+         !RAMTINY_ISONLY(page_arg->ramtinypg_heap, page_arg))
+   {
+      RAM_FAIL_TRAP(ramtiny_rmpage(page_arg));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_putremote(ramtiny_page_t *page_arg, size_t idx_arg)
+{
+   void * volatile *remote = NULL;
+   void *old = NULL;
+   uintptr_t mask = 0;
+   size_t w = 0;
+
+   assert(page_arg != NULL);
+
+   remote = RAMTINY_REMOTE(page_arg, &ramtiny_theglobals.ramtinyg_classes[
+         page_arg->ramtinypg_class]);
+   w = idx_arg / RAMTINY_WORDBITS;
+   mask = (uintptr_t)1 << (idx_arg % RAMTINY_WORDBITS);
+
+   /* the thread that brings the count up from zero queues the page. the
+    * count has to go up before the cell is marked; see
+    * *ramtinypg_remote*. */
+   if (0 == ramatom_xadd(&page_arg->ramtinypg_remote, 1))
+      ramtiny_push(page_arg->ramtinypg_heap, page_arg);
+   do
+   {
+      old = remote[w];
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0 == ((uintptr_t)old & mask));
+   }
+   while (old != ramatom_casptr(&remote[w], old,
+         (void *)((uintptr_t)old | mask)));
+   ramatom_xadd(&ramtiny_theglobals.ramtinyg_remote, 1);
+
+   return RAM_REPLY_OK;
+}
+
+void ramtiny_push(ramtiny_heap_t *heap_arg, ramtiny_page_t *page_arg)
+{
+   void *head = NULL;
+
+   assert(heap_arg != NULL);
+   assert(page_arg != NULL);
+
+   do
+   {
+      head = heap_arg->ramtinyh_pending;
+      page_arg->ramtinypg_pending = (ramtiny_page_t *)head;
+   }
+   while (head != ramatom_casptr(&heap_arg->ramtinyh_pending, head,
+         page_arg));
+}
+
+ram_reply_t ramtiny_merge(ramtiny_heap_t *heap_arg)
+{
+   ramtiny_page_t *page = NULL, *next = NULL;
+
+   assert(heap_arg != NULL);
+
+   /* pages that have to be queued again while i'm merging go onto a
+    * fresh stack, so this loop always ends. */
+   page = (ramtiny_page_t *)ramatom_xchgptr(&heap_arg->ramtinyh_pending,
+         NULL);
+   for (; NULL != page; page = next)
+   {
+      next = page->ramtinypg_pending;
+      page->ramtinypg_pending = NULL;
+      RAM_FAIL_TRAP(ramtiny_mergepage(page));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_mergepage(ramtiny_page_t *page_arg)
+{
+   const ramtiny_class_t *cls = NULL;
+   uintptr_t *local = NULL;
+   void * volatile *remote = NULL;
+   uintptr_t bits = 0;
+   size_t w = 0;
+   long n = 0, left = 0;
+
+   assert(page_arg != NULL);
+
+   cls = &ramtiny_theglobals.ramtinyg_classes[page_arg->ramtinypg_class];
+   local = RAMTINY_LOCAL(page_arg);
+   remote = RAMTINY_REMOTE(page_arg, cls);
+   for (w = 0; w < cls->ramtinyc_words; ++w)
+   {
+      if (NULL == remote[w])
+         continue;
+      bits = (uintptr_t)ramatom_xchgptr(&remote[w], NULL);
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0 == (local[w] & bits));
+      local[w] |= bits;
+      if (w < page_arg->ramtinypg_hint)
+         page_arg->ramtinypg_hint = w;
+      for (; 0 != bits; bits &= bits - 1)
+         ++n;
+   }
+   page_arg->ramtinypg_free += (size_t)n;
+
+   /* if the count doesn't come back down to zero, another thread has
+    * counted a cell it hasn't marked yet. it won't queue the page, so i
+    * have to. */
+   left = ramatom_xadd(&page_arg->ramtinypg_remote, -n) - n;
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, left >= 0);
+   if (left > 0)
+      ramtiny_push(page_arg->ramtinypg_heap, page_arg);
+
+   if (n > 0 && !page_arg->ramtinypg_linkflag)
+      ramtiny_link(page_arg);
+   if (0 == left && cls->ramtinyc_capacity == page_arg->ramtinypg_free &&
+         !RAMTINY_ISONLY(page_arg->ramtinypg_heap, page_arg))
+   {
+      RAM_FAIL_TRAP(ramtiny_rmpage(page_arg));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_flush2(ramtiny_heap_t *heap_arg)
+{
+   ramtiny_page_t *page = NULL, *next = NULL;
+   size_t i = 0;
+
+   assert(heap_arg != NULL);
+
+   RAM_FAIL_TRAP(ramtiny_merge(heap_arg));
+   /* a page that's still queued has cells on their way back, so it can't
+    * be empty. */
+   for (i = 0; i < RAMTINY_CLASSCOUNT; ++i)
+   {
+      for (page = heap_arg->ramtinyh_avail[i]; NULL != page; page = next)
+      {
+         next = page->ramtinypg_next;
+         if (ramtiny_theglobals.ramtinyg_classes[i].ramtinyc_capacity ==
+               page->ramtinypg_free)
+         {
+            RAM_FAIL_TRAP(ramtiny_rmpage(page));
+         }
+      }
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtiny_chkpage(const ramtiny_page_t *page_arg,
+      const ramtiny_heap_t *heap_arg)
+{
+   const ramtiny_class_t *cls = NULL;
+   const uintptr_t *local = NULL;
+   uintptr_t bits = 0;
+   size_t w = 0, n = 0, tail = 0;
+   void *owner = NULL;
+
+   assert(page_arg != NULL);
+   assert(heap_arg != NULL);
+
+   cls = &ramtiny_theglobals.ramtinyg_classes[page_arg->ramtinypg_class];
+   local = RAMTINY_LOCAL(page_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, heap_arg == page_arg->ramtinypg_heap);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, page_arg->ramtinypg_linkflag);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, page_arg->ramtinypg_free > 0 &&
+         page_arg->ramtinypg_free <= cls->ramtinyc_capacity);
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+         page_arg->ramtinypg_hint < cls->ramtinyc_words);
+   RAM_FAIL_TRAP(ramown_get(&owner, &ramtiny_theglobals.ramtinyg_map,
+         page_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, owner == page_arg);
+
+   /* the free count has to agree with the bitmap, and the bits past the
+    * last cell must never be set. */
+   for (w = 0; w < cls->ramtinyc_words; ++w)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+            w >= page_arg->ramtinypg_hint || 0 == local[w]);
+      for (bits = local[w]; 0 != bits; bits &= bits - 1)
+         ++n;
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, n == page_arg->ramtinypg_free);
+   tail = cls->ramtinyc_capacity % RAMTINY_WORDBITS;
+   if (tail)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0 ==
+            (local[cls->ramtinyc_words - 1] & ~(((uintptr_t)1 << tail) - 1)));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+void RAMSYS_TLSDTORDECL ramtiny_orphan(void *heap_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   /* there's nobody to report a failure to when a thread exits. */
+   e = ramtiny_orphan2((ramtiny_heap_t *)heap_arg);
+   if (RAM_REPLY_OK != e)
+      ram_fail_panic("i failed to orphan an exiting thread's heap.");
+}
+
+ram_reply_t ramtiny_orphan2(ramtiny_heap_t *heap_arg)
+{
+   RAM_FAIL_NOTNULL(heap_arg);
+
+#if RAM_WANT_COMPILERTLS
+   ramtiny_thecache = NULL;
+#endif
+   /* there's no sense in passing on pages nobody is using. */
+   RAM_FAIL_TRAP(ramtiny_flush2(heap_arg));
+
+   RAM_FAIL_TRAP(rammtx_wait(&ramtiny_theglobals.ramtinyg_mutex));
+   heap_arg->ramtinyh_nextorphan = ramtiny_theglobals.ramtinyg_orphans;
+   ramtiny_theglobals.ramtinyg_orphans = heap_arg;
+   RAM_FAIL_PANIC(rammtx_quit(&ramtiny_theglobals.ramtinyg_mutex));
+
+   return RAM_REPLY_OK;
+}
@@ -30,89 +30,147 @@
  * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
  * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
-
 #include <ramalloc/tra.h>
+#include <ramalloc/atom.h>
 #include <string.h>
 
-typedef struct ramtra_foreachadaptor
-{
-   ramtra_foreach_t ramtrafea_function;
-   void *ramtrafea_context;
-} ramtra_foreachadaptor_t;
+#define RAMTRA_NEXT(Item) (*(void **)(Item))
 
-static ram_reply_t ramtra_mktrash2(ramtra_trash_t *trash_arg);
-static ram_reply_t ramtra_foreachadaptor(ramslst_slist_t *node_arg, void *context_arg);
+static ram_reply_t ramtra_foreach2(void *item_arg, ramtra_foreach_t func_arg,
+      void *context_arg);
+static ram_reply_t ramtra_link(ramtra_trash_t *trash_arg, void *first_arg,
+      void *last_arg);
 
 ram_reply_t ramtra_mktrash(ramtra_trash_t *trash_arg)
 {
-   ram_reply_t e = RAM_REPLY_INSANE;
+   RAM_FAIL_NOTNULL(trash_arg);
+
+   trash_arg->ramtrat_shared = NULL;
+   trash_arg->ramtrat_taken = NULL;
+   trash_arg->ramtrat_depth = 0;
+   trash_arg->ramtrat_notifier = NULL;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtra_push(ramtra_trash_t *trash_arg, void *ptr_arg)
+{
+   const ramtra_notifier_t *notifier = NULL;
+   size_t depth = 0;
 
    RAM_FAIL_NOTNULL(trash_arg);
+   RAM_FAIL_NOTNULL(ptr_arg);
 
-   e = ramtra_mktrash2(trash_arg);
-   if (RAM_REPLY_OK == e)
-      return RAM_REPLY_OK;
-   else
-   {
-      memset(trash_arg, 0, sizeof(*trash_arg));
-      return e;
-   }
+   RAM_FAIL_TRAP(ramtra_link(trash_arg, ptr_arg, ptr_arg));
+
+   /* each push sees a distinct depth, so only one producer can be the one
+    * that reaches the threshold. the owner has to bring the depth back
+    * below the threshold before anyone is notified again. */
+   depth = (size_t)(ramatom_xadd(&trash_arg->ramtrat_depth, 1) + 1);
+   notifier = (const ramtra_notifier_t *)trash_arg->ramtrat_notifier;
+   if (NULL != notifier && notifier->ramtran_depth == depth)
+      RAM_FAIL_TRAP(notifier->ramtran_func(notifier->ramtran_context));
+
+   return RAM_REPLY_OK;
 }
 
-ram_reply_t ramtra_mktrash2(ramtra_trash_t *trash_arg)
+ram_reply_t ramtra_give(ramtra_trash_t *trash_arg, void *first_arg,
+      void *last_arg, size_t count_arg)
 {
-   assert(trash_arg != NULL);
+   RAM_FAIL_NOTNULL(trash_arg);
+   RAM_FAIL_NOTNULL(first_arg);
+   RAM_FAIL_NOTNULL(last_arg);
+   RAM_FAIL_NOTZERO(count_arg);
 
-   RAM_FAIL_TRAP(rammtx_mkmutex(&trash_arg->ramtrat_mutex));
-   RAM_FAIL_TRAP(ramslst_mklist(&trash_arg->ramtrat_items));
-   trash_arg->ramtrat_size = 0;
+   /* the items were already counted (and announced to the notifier) when
+    * they were first pushed, so giving them back doesn't notify anyone. */
+   RAM_FAIL_TRAP(ramtra_link(trash_arg, first_arg, last_arg));
+   ramatom_xadd(&trash_arg->ramtrat_depth, (long)count_arg);
 
    return RAM_REPLY_OK;
 }
 
-ram_reply_t ramtra_push(ramtra_trash_t *trash_arg, void *ptr_arg)
+ram_reply_t ramtra_link(ramtra_trash_t *trash_arg, void *first_arg,
+      void *last_arg)
 {
-   ram_reply_t e = RAM_REPLY_INSANE;
+   void *head = NULL;
+
+   assert(trash_arg != NULL);
+   assert(first_arg != NULL);
+   assert(last_arg != NULL);
+
+   /* consumers never remove individual items from the shared stack, so
+    * there's no ABA hazard here. the exchange only fails if another thread
+    * pushed or a consumer emptied the stack since i looked at it. */
+   do
+   {
+      head = trash_arg->ramtrat_shared;
+      RAMTRA_NEXT(last_arg) = head;
+   }
+   while (head != ramatom_casptr(&trash_arg->ramtrat_shared, head, first_arg));
+
+   return RAM_REPLY_OK;
+}
 
+ram_reply_t ramtra_take(void **first_arg, void **last_arg, size_t *count_arg,
+      ramtra_trash_t *trash_arg)
+{
+   void *p = NULL, *last = NULL;
+   size_t n = 0;
+
+   RAM_FAIL_NOTNULL(first_arg);
+   *first_arg = NULL;
+   RAM_FAIL_NOTNULL(last_arg);
+   *last_arg = NULL;
+   RAM_FAIL_NOTNULL(count_arg);
+   *count_arg = 0;
    RAM_FAIL_NOTNULL(trash_arg);
-   RAM_FAIL_NOTNULL(ptr_arg);
 
-   RAM_FAIL_TRAP(rammtx_wait(&trash_arg->ramtrat_mutex));
-   e = ramslst_insert((ramslst_slist_t *)ptr_arg, &trash_arg->ramtrat_items);
-   trash_arg->ramtrat_size += (RAM_REPLY_OK == e);
-   /* if i fail to quit the mutex, the process can't continue meaningfully. */
-   RAM_FAIL_PANIC(rammtx_quit(&trash_arg->ramtrat_mutex));
-   RAM_FAIL_TRAP(e);
+   if (NULL == trash_arg->ramtrat_shared)
+      return RAM_REPLY_NOTFOUND;
+   p = ramatom_xchgptr(&trash_arg->ramtrat_shared, NULL);
+   if (NULL == p)
+      return RAM_REPLY_NOTFOUND;
+
+   /* once i've taken the stack, it's mine alone to walk. */
+   *first_arg = p;
+   for (; NULL != p; p = RAMTRA_NEXT(p))
+   {
+      last = p;
+      ++n;
+   }
+   ramatom_xadd(&trash_arg->ramtrat_depth, -(long)n);
 
+   *last_arg = last;
+   *count_arg = n;
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramtra_pop(void **ptr_arg, ramtra_trash_t *trash_arg)
 {
    void *p = NULL;
-   ram_reply_t e = RAM_REPLY_INSANE;
 
    RAM_FAIL_NOTNULL(ptr_arg);
    *ptr_arg = NULL;
    RAM_FAIL_NOTNULL(trash_arg);
 
-   RAM_FAIL_TRAP(rammtx_wait(&trash_arg->ramtrat_mutex));
-   p = RAMSLST_NEXT(&trash_arg->ramtrat_items);
-   e = ramslst_remove(&trash_arg->ramtrat_items);
-   trash_arg->ramtrat_size -= (RAM_REPLY_OK == e);
-   /* if i fail to quit the mutex, the process can't continue meaningfully. */
-   RAM_FAIL_PANIC(rammtx_quit(&trash_arg->ramtrat_mutex));
-   if (RAM_REPLY_OK == e || RAM_REPLY_NOTFOUND == e)
+   if (NULL == trash_arg->ramtrat_taken)
    {
-      *ptr_arg = p;
-      return e;
-   }
-   else
-   {
-      RAM_FAIL_TRAP(e);
-      /* i shouldn't be able to get here, since 'e' is known to not be RAM_REPLY_OK. */
-      return RAM_REPLY_INSANE;
+      /* an empty trash costs me one load of the shared stack. i only
+       * write to it when there's something to take, and then i take
+       * everything at once. */
+      if (NULL == trash_arg->ramtrat_shared)
+         return RAM_REPLY_NOTFOUND;
+      trash_arg->ramtrat_taken =
+            ramatom_xchgptr(&trash_arg->ramtrat_shared, NULL);
+      assert(trash_arg->ramtrat_taken != NULL);
    }
+
+   p = trash_arg->ramtrat_taken;
+   trash_arg->ramtrat_taken = RAMTRA_NEXT(p);
+   ramatom_xadd(&trash_arg->ramtrat_depth, -1);
+   *ptr_arg = p;
+   return RAM_REPLY_OK;
 }
 
 ram_reply_t ramtra_rmtrash(ramtra_trash_t *trash_arg)
@@ -120,7 +178,6 @@ ram_reply_t ramtra_rmtrash(ramtra_trash_t *trash_arg)
    RAM_FAIL_NOTNULL(trash_arg);
 
    /* TODO: what do i do if the trash isn't empty yet? */
-   RAM_FAIL_TRAP(rammtx_rmmutex(&trash_arg->ramtrat_mutex));
    memset(trash_arg, 0, sizeof(*trash_arg));
 
    return RAM_REPLY_OK;
@@ -128,51 +185,64 @@ ram_reply_t ramtra_rmtrash(ramtra_trash_t *trash_arg)
 
 ram_reply_t ramtra_size(size_t *size_arg, ramtra_trash_t *trash_arg)
 {
-   size_t sz = 0;
+   long depth = 0;
 
    RAM_FAIL_NOTNULL(size_arg);
    *size_arg = 0;
    RAM_FAIL_NOTNULL(trash_arg);
 
-   RAM_FAIL_TRAP(rammtx_wait(&trash_arg->ramtrat_mutex));
-   sz = trash_arg->ramtrat_size;
-   /* if i fail to quit the mutex, the process can't continue meaningfully. */
-   RAM_FAIL_PANIC(rammtx_quit(&trash_arg->ramtrat_mutex));
-
-   *size_arg = sz;
+   /* the depth already counts the items in both stacks. a producer links
+    * an item before counting it, so a consumer that takes the item in
+    * between can briefly drive the depth below zero. */
+   depth = trash_arg->ramtrat_depth;
+   *size_arg = depth > 0 ? (size_t)depth : 0;
    return RAM_REPLY_OK;
 }
 
 ram_reply_t ramtra_foreach(ramtra_trash_t *trash_arg, ramtra_foreach_t func_arg, void *context_arg)
 {
-   ram_reply_t e = RAM_REPLY_INSANE;
-   ramtra_foreachadaptor_t fea = {0};
-
    RAM_FAIL_NOTNULL(trash_arg);
    RAM_FAIL_NOTNULL(func_arg);
 
-   fea.ramtrafea_function = func_arg;
-   fea.ramtrafea_context = context_arg;
+   RAM_FAIL_TRAP(ramtra_foreach2(trash_arg->ramtrat_taken, func_arg,
+         context_arg));
+   RAM_FAIL_TRAP(ramtra_foreach2(trash_arg->ramtrat_shared, func_arg,
+         context_arg));
 
-   RAM_FAIL_TRAP(rammtx_wait(&trash_arg->ramtrat_mutex));
-   /* i don't include the first element in 'ramtrat_items' because it is a sentinel and doesn't
-    * actually hold a trashed pointer. */
-   e = ramslst_foreach(RAMSLST_NEXT(&trash_arg->ramtrat_items), &ramtra_foreachadaptor, &fea);
-   /* if i fail to quit the mutex, the process can't continue meaningfully. */
-   RAM_FAIL_PANIC(rammtx_quit(&trash_arg->ramtrat_mutex));
-   RAM_FAIL_TRAP(e);
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramtra_notify(ramtra_trash_t *trash_arg, const ramtra_notifier_t *notifier_arg)
+{
+   void *old = NULL;
+
+   RAM_FAIL_NOTNULL(trash_arg);
+   if (NULL != notifier_arg)
+   {
+      RAM_FAIL_NOTZERO(notifier_arg->ramtran_depth);
+      RAM_FAIL_NOTNULL(notifier_arg->ramtran_func);
+   }
+
+   /* i need the full barrier that comes with ramatom_casptr() to make sure
+    * that producers see the notifier's contents by the time they see its
+    * address. */
+   do
+      old = trash_arg->ramtrat_notifier;
+   while (old != ramatom_casptr(&trash_arg->ramtrat_notifier, old,
+         (void *)notifier_arg));
 
    return RAM_REPLY_OK;
 }
 
-ram_reply_t ramtra_foreachadaptor(ramslst_slist_t *node_arg, void *context_arg)
+ram_reply_t ramtra_foreach2(void *item_arg, ramtra_foreach_t func_arg,
+      void *context_arg)
 {
-   ramtra_foreachadaptor_t *fea = NULL;
+   void *p = NULL;
+
+   assert(func_arg != NULL);
 
-   assert(node_arg != NULL);
-   assert(context_arg != NULL);
+   for (p = item_arg; NULL != p; p = RAMTRA_NEXT(p))
+      RAM_FAIL_TRAP(func_arg(p, context_arg));
 
-   fea = (ramtra_foreachadaptor_t *)context_arg;
-   assert(fea->ramtrafea_function != NULL);
-   return fea->ramtrafea_function(node_arg, fea->ramtrafea_context);
+   return RAM_REPLY_OK;
 }
@@ -0,0 +1,180 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include <ramalloc/vas.h>
+#include <ramalloc/mtx.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/stdint.h>
+#include <assert.h>
+
+#define RAMVAS_PARTITIONSIZE ((size_t)1 << RAM_WANT_PARTITIONBITS)
+
+typedef struct ramvas_partition
+{
+   rammtx_mutex_t ramvasp_mutex;
+   /* reservations that have been returned to the partition, linked
+    * through their first word. the second word holds the commit flag. */
+   char *ramvasp_free;
+   /* the offset of the first reservation that's never been handed out. */
+   size_t ramvasp_next;
+} ramvas_partition_t;
+
+typedef struct ramvas_globals
+{
+   ramvas_partition_t ramvasg_partitions[RAMVAS_PARTITIONCOUNT];
+   char *ramvasg_base;
+   size_t ramvasg_mmapgran;
+   int ramvasg_initflag;
+} ramvas_globals_t;
+
+static ram_reply_t ramvas_initialize2();
+
+static ramvas_globals_t ramvas_theglobals;
+
+ram_reply_t ramvas_initialize()
+{
+   if (RAM_WANT_PARTITIONED && !ramvas_theglobals.ramvasg_initflag)
+      RAM_FAIL_TRAP(ramvas_initialize2());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramvas_initialize2()
+{
+   size_t i = 0;
+
+   /* the entire range has to be addressable. */
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, RAM_WANT_PARTITIONBITS <
+         sizeof(size_t) * 8 - 8);
+   RAM_FAIL_TRAP(rammem_mmapgran(&ramvas_theglobals.ramvasg_mmapgran));
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED,
+         0 == RAMVAS_PARTITIONSIZE % ramvas_theglobals.ramvasg_mmapgran);
+   for (i = 0; i < RAMVAS_PARTITIONCOUNT; ++i)
+   {
+      RAM_FAIL_TRAP(rammtx_mkmutex(
+            &ramvas_theglobals.ramvasg_partitions[i].ramvasp_mutex));
+   }
+   /* the range only consumes address space until its pages are
+    * committed. */
+   RAM_FAIL_TRAP(ramsys_reserverange(&ramvas_theglobals.ramvasg_base,
+         RAMVAS_PARTITIONCOUNT * RAMVAS_PARTITIONSIZE));
+   ramvas_theglobals.ramvasg_initflag = 1;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramvas_withdraw(char **pages_arg, int *commitflag_arg,
+      size_t partition_arg)
+{
+   ramvas_partition_t *partition = NULL;
+   char *pages = NULL;
+   int commitflag = 0;
+   int returnedflag = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = NULL;
+   RAM_FAIL_NOTNULL(commitflag_arg);
+   *commitflag_arg = 0;
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, ramvas_theglobals.ramvasg_initflag);
+   RAM_FAIL_EXPECT(RAM_REPLY_RANGEFAIL,
+         partition_arg < RAMVAS_PARTITIONCOUNT);
+
+   partition = &ramvas_theglobals.ramvasg_partitions[partition_arg];
+   RAM_FAIL_TRAP(rammtx_wait(&partition->ramvasp_mutex));
+   if (NULL != partition->ramvasp_free)
+   {
+      pages = partition->ramvasp_free;
+      partition->ramvasp_free = ((char **)pages)[0];
+      commitflag = (int)((uintptr_t *)pages)[1];
+      returnedflag = 1;
+   }
+   else if (partition->ramvasp_next < RAMVAS_PARTITIONSIZE)
+   {
+      pages = ramvas_theglobals.ramvasg_base +
+            partition_arg * RAMVAS_PARTITIONSIZE + partition->ramvasp_next;
+      partition->ramvasp_next += ramvas_theglobals.ramvasg_mmapgran;
+   }
+   RAM_FAIL_PANIC(rammtx_quit(&partition->ramvasp_mutex));
+   /* a partition can't borrow from its neighbors without defeating its
+    * purpose. */
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != pages);
+
+   /* i had to commit the first page of an uncommitted reservation to link
+    * it into the free list, so i decommit it again. */
+   if (returnedflag && !commitflag)
+      RAM_FAIL_TRAP(ramsys_decommit(pages));
+
+   *pages_arg = pages;
+   *commitflag_arg = commitflag;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramvas_deposit(char *pages_arg, int commitflag_arg)
+{
+   ramvas_partition_t *partition = NULL;
+   size_t idx = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_EXPECT(RAM_REPLY_UNSUPPORTED, ramvas_theglobals.ramvasg_initflag);
+
+   RAM_FAIL_TRAP(ramvas_locate(&idx, pages_arg));
+   partition = &ramvas_theglobals.ramvasg_partitions[idx];
+   if (!commitflag_arg)
+      RAM_FAIL_TRAP(ramsys_commit(pages_arg));
+   ((uintptr_t *)pages_arg)[1] = commitflag_arg ? 1 : 0;
+   RAM_FAIL_TRAP(rammtx_wait(&partition->ramvasp_mutex));
+   ((char **)pages_arg)[0] = partition->ramvasp_free;
+   partition->ramvasp_free = pages_arg;
+   RAM_FAIL_PANIC(rammtx_quit(&partition->ramvasp_mutex));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t ramvas_locate(size_t *partition_arg, const void *ptr_arg)
+{
+   uintptr_t offset = 0;
+
+   RAM_FAIL_NOTNULL(partition_arg);
+   *partition_arg = 0;
+
+   /* if the range wasn't reserved, nothing can be found in it. */
+   if (!ramvas_theglobals.ramvasg_initflag)
+      return RAM_REPLY_NOTFOUND;
+   /* an address below the base wraps around to a large offset. */
+   offset = (uintptr_t)ptr_arg - (uintptr_t)ramvas_theglobals.ramvasg_base;
+   if ((offset >> RAM_WANT_PARTITIONBITS) >= RAMVAS_PARTITIONCOUNT)
+      return RAM_REPLY_NOTFOUND;
+
+   *partition_arg = (size_t)(offset >> RAM_WANT_PARTITIONBITS);
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,148 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/lazy.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this test fills a lazy pool's trash in bursts and then lets the pool
+ * idle, checking that the reclaim goal climbs to its maximum while a
+ * backlog remains, falls back to its minimum once the backlog is gone,
+ * and never strays outside of those bounds. the objects are sent to the
+ * trash without going through an outgoing buffer, the way a thread without
+ * a pool of its own would send them. */
+
+#define BURST_COUNT 3
+#define OBJECT_COUNT 4096
+#define OBJECT_SIZE 32
+#define IDLE_COUNT 64
+#define MIN_GOAL 8
+#define MAX_GOAL 512
+
+static ram_reply_t main2();
+static ram_reply_t burst(ramlazy_pool_t *lpool_arg, void **ptrs_arg);
+static ram_reply_t idle(size_t *peak_arg, ramlazy_pool_t *lpool_arg);
+
+int main()
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2();
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2()
+{
+   ramlazy_pool_t lpool;
+   ramlazy_policy_t policy = {0};
+   void **ptrs = NULL;
+   size_t i = 0, goal = 0, peak = 0, unused = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   ptrs = calloc(OBJECT_COUNT, sizeof(*ptrs));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != ptrs);
+   policy.ramlazyp_mingoal = MIN_GOAL;
+   policy.ramlazyp_maxgoal = MAX_GOAL;
+   RAM_FAIL_TRAP(ramlazy_mkpool(&lpool, RAM_WANT_DEFAULTAPPETITE, &policy));
+   RAM_FAIL_TRAP(ramlazy_getgoal(&goal, &lpool));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, MIN_GOAL == goal);
+
+   for (i = 0; i < BURST_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(burst(&lpool, ptrs));
+      RAM_FAIL_TRAP(idle(&peak, &lpool));
+      RAM_FAIL_TRAP(ramlazy_getgoal(&goal, &lpool));
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "burst %zu: the goal peaked at %zu objects and settled at %zu.\n",
+            i, peak, goal));
+      /* a burst of this size outlasts the climb from the minimum to the
+       * maximum, and idling afterward outlasts the descent. */
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, MAX_GOAL == peak);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, MIN_GOAL == goal);
+   }
+
+   RAM_FAIL_TRAP(ramlazy_chkpool(&lpool));
+   RAM_FAIL_TRAP(ramlazy_rmpool(&lpool));
+   free(ptrs);
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "the goal adapted as expected.\n"));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t burst(ramlazy_pool_t *lpool_arg, void **ptrs_arg)
+{
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(lpool_arg);
+   RAM_FAIL_NOTNULL(ptrs_arg);
+
+   for (i = 0; i < OBJECT_COUNT; ++i)
+      RAM_FAIL_TRAP(ramlazy_acquire(&ptrs_arg[i], lpool_arg, OBJECT_SIZE));
+   for (i = 0; i < OBJECT_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(ramlazy_discard(lpool_arg, ptrs_arg[i], OBJECT_SIZE,
+            NULL));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t idle(size_t *peak_arg, ramlazy_pool_t *lpool_arg)
+{
+   void *p = NULL;
+   size_t i = 0, goal = 0;
+
+   RAM_FAIL_NOTNULL(peak_arg);
+   *peak_arg = 0;
+   RAM_FAIL_NOTNULL(lpool_arg);
+
+   /* each acquisition is the pool's chance to adapt. */
+   for (i = 0; i < IDLE_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(ramlazy_acquire(&p, lpool_arg, OBJECT_SIZE));
+      RAM_FAIL_TRAP(ramlazy_discard(lpool_arg, p, OBJECT_SIZE, lpool_arg));
+      RAM_FAIL_TRAP(ramlazy_getgoal(&goal, lpool_arg));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, goal >= MIN_GOAL && goal <= MAX_GOAL);
+      if (goal > *peak_arg)
+         *peak_arg = goal;
+   }
+
+   return RAM_REPLY_OK;
+}
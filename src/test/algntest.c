@@ -257,26 +257,20 @@ ram_reply_t runtest2(const ramtest_params_t *params_arg,
    ramtest_params_t testparams = {0};
    ramalgn_tag_t tag = {0};
    size_t unused = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
 
    testparams = *params_arg;
-   /* i am responsible for policing the minimum and maximum allocation
-    * size here. */
-   if (testparams.ramtestp_minsize < sizeof(void *) ||
-         testparams.ramtestp_maxsize < sizeof(void *))
-   {
-      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
-            "you cannot specify a size smaller than %zu bytes.\n",
-            sizeof(void *)));
-      return RAM_REPLY_INPUTFAIL;
-   }
-   /* TODO: shouldn't this test be moved into the framework? */
-   if (testparams.ramtestp_minsize > testparams.ramtestp_maxsize)
+   e = ramtest_chksizes(&testparams);
+   switch (e)
    {
-      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
-            "please specify a minimum size (%zu bytes) that is smaller than "
-            "or equal to the maximum (%zu bytes).\n",
-            testparams.ramtestp_minsize, testparams.ramtestp_maxsize));
-      return RAM_REPLY_INPUTFAIL;
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_INPUTFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
    }
    /* the algnpool doesn't support multi-threaded access. */
    if (testparams.ramtestp_threadcount > 1)
@@ -0,0 +1,299 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/pg.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+
+/* this test compares the resident set size and the latency of the page
+ * pool's appetites (and the huge page coverage of gluttonous pools). each pass acquires and touches a number of pages,
+ * releases all but one page per node (so that the nodes, and therefore
+ * the reservations, stay alive) and then acquires and touches the pages
+ * again. */
+
+#define DEFAULT_PAGE_COUNT 4096
+
+typedef struct result
+{
+   const char *r_name;
+   uint64_t r_acquirens;
+   uint64_t r_releasens;
+   uint64_t r_reacquirens;
+   size_t r_hotrss;
+   size_t r_coldrss;
+   size_t r_hugeregions;
+   size_t r_hugebacked;
+} result_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t measure(result_t *result_arg, char **pages_arg,
+      size_t count_arg, rampg_appetite_t appetite_arg);
+static ram_reply_t acquire(uint64_t *elapsed_arg, char **pages_arg,
+      size_t count_arg, size_t stride_arg, rampg_pool_t *pool_arg);
+static ram_reply_t release(uint64_t *elapsed_arg, char **pages_arg,
+      size_t count_arg, size_t stride_arg);
+static ram_reply_t report(const result_t *result_arg, size_t count_arg);
+static ram_reply_t chkforeign();
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   result_t frugal = {0}, greedy = {0}, gluttonous = {0};
+   char **pages = NULL;
+   size_t count = DEFAULT_PAGE_COUNT;
+   size_t pgsz = 0, released = 0, mmapgran = 0, unused = 0;
+   size_t metadata = 0, payload = 0;
+   int hasgluttony = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   if (argc > 1)
+   {
+      count = strtoul(argv[1], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, count > 0);
+   }
+
+   pages = calloc(count, sizeof(*pages));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != pages);
+
+   RAM_FAIL_TRAP(measure(&frugal, pages, count, RAMOPT_FRUGAL));
+   frugal.r_name = "frugal";
+   RAM_FAIL_TRAP(measure(&greedy, pages, count, RAMOPT_GREEDY));
+   greedy.r_name = "greedy";
+   /* gluttonous pools depend upon support for transparent huge pages. */
+   e = measure(&gluttonous, pages, count, RAMOPT_GLUTTONOUS);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_OK:
+      hasgluttony = 1;
+      gluttonous.r_name = "gluttony";
+      break;
+   case RAM_REPLY_UNSUPPORTED:
+      break;
+   }
+   free(pages);
+
+   RAM_FAIL_TRAP(rampg_getoverhead(&metadata, &payload));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "each node has %zu bytes of metadata for %zu bytes of pages "
+         "(%.3f%%).\n",
+         metadata, payload, 100.0 * metadata / payload));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%zu pages; latency in ns/page, resident set in KiB.\n"
+         "appetite  acquire  release  reacquire  hot rss  cold rss\n",
+         count));
+   RAM_FAIL_TRAP(report(&frugal, count));
+   RAM_FAIL_TRAP(report(&greedy, count));
+   if (hasgluttony)
+   {
+      RAM_FAIL_TRAP(report(&gluttonous, count));
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "%zu of %zu huge pages were backed by the system while the "
+            "gluttonous pool was hot.\n",
+            gluttonous.r_hugebacked, gluttonous.r_hugeregions));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            gluttonous.r_hugebacked <= gluttonous.r_hugeregions);
+      RAM_FAIL_TRAP(chkforeign());
+   }
+   else
+   {
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "gluttonous pools aren't supported on this system.\n"));
+   }
+
+   /* the only claim i'm willing to check is that a frugal pool gives
+    * (at least most of) its released pages back right away. */
+   if (frugal.r_hotrss && frugal.r_coldrss)
+   {
+      RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+      RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
+      released = (count - (count + mmapgran / pgsz - 1) / (mmapgran / pgsz))
+            * pgsz;
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            frugal.r_hotrss - frugal.r_coldrss >= released / 2);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t measure(result_t *result_arg, char **pages_arg,
+      size_t count_arg, rampg_appetite_t appetite_arg)
+{
+   rampg_pool_t pool;
+   size_t pgsz = 0, mmapgran = 0, stride = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(result_arg);
+   RAM_FAIL_NOTNULL(pages_arg);
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   RAM_FAIL_TRAP(rammem_mmapgran(&mmapgran));
+   /* the stride is the number of pages in a single page pool node. */
+   stride = mmapgran / pgsz;
+
+   e = rampg_mkpool(&pool, appetite_arg);
+   if (RAM_REPLY_UNSUPPORTED == e)
+      return e;
+   RAM_FAIL_TRAP(e);
+   RAM_FAIL_TRAP(acquire(&result_arg->r_acquirens, pages_arg, count_arg, 0,
+         &pool));
+   e = ramtest_rss(&result_arg->r_hotrss);
+   if (RAM_REPLY_UNSUPPORTED != e)
+      RAM_FAIL_TRAP(e);
+   if (RAMOPT_GLUTTONOUS == appetite_arg)
+   {
+      RAM_FAIL_TRAP(rampg_gethugestats(&result_arg->r_hugeregions,
+            &result_arg->r_hugebacked));
+   }
+   RAM_FAIL_TRAP(release(&result_arg->r_releasens, pages_arg, count_arg,
+         stride));
+   e = ramtest_rss(&result_arg->r_coldrss);
+   if (RAM_REPLY_UNSUPPORTED != e)
+      RAM_FAIL_TRAP(e);
+   RAM_FAIL_TRAP(acquire(&result_arg->r_reacquirens, pages_arg, count_arg,
+         stride, &pool));
+   RAM_FAIL_TRAP(release(NULL, pages_arg, count_arg, 0));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t acquire(uint64_t *elapsed_arg, char **pages_arg,
+      size_t count_arg, size_t stride_arg, rampg_pool_t *pool_arg)
+{
+   uint64_t t0 = 0, t1 = 0;
+   size_t i = 0, n = 0, gran = 0;
+
+   RAM_FAIL_NOTNULL(elapsed_arg);
+   *elapsed_arg = 0;
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTNULL(pool_arg);
+
+   RAM_FAIL_TRAP(rampg_getgranularity(&gran));
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      /* a non-zero stride indicates that every stride-th page is still
+       * in use. */
+      if (stride_arg && 0 == i % stride_arg)
+         continue;
+      RAM_FAIL_TRAP(rampg_acquire((void **)&pages_arg[i], pool_arg));
+      /* the latency of the first touch is part of what i'm measuring. */
+      memset(pages_arg[i], 0x5a, gran);
+      ++n;
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+
+   if (n)
+      *elapsed_arg = (t1 - t0) / n;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t release(uint64_t *elapsed_arg, char **pages_arg,
+      size_t count_arg, size_t stride_arg)
+{
+   uint64_t t0 = 0, t1 = 0;
+   size_t i = 0, n = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      if (stride_arg && 0 == i % stride_arg)
+         continue;
+      RAM_FAIL_TRAP(rampg_release(pages_arg[i]));
+      pages_arg[i] = NULL;
+      ++n;
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+
+   if (elapsed_arg && n)
+      *elapsed_arg = (t1 - t0) / n;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t report(const result_t *result_arg, size_t count_arg)
+{
+   size_t unused = 0;
+
+   RAM_FAIL_NOTNULL(result_arg);
+   RAM_FAIL_NOTZERO(count_arg);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%-8s  %7lu  %7lu  %9lu  %7zu  %8zu\n",
+         result_arg->r_name,
+         (unsigned long)result_arg->r_acquirens,
+         (unsigned long)result_arg->r_releasens,
+         (unsigned long)result_arg->r_reacquirens,
+         result_arg->r_hotrss / 1024, result_arg->r_coldrss / 1024));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkforeign()
+{
+   char *foreign = NULL;
+   size_t before = 0, after = 0, unused = 0;
+
+   /* a huge page that no page pool mapped isn't counted, even once it's
+    * been touched. */
+   RAM_FAIL_TRAP(rampg_gethugestats(&before, &unused));
+   RAM_FAIL_TRAP(ramsys_reservehuge(&foreign));
+   *foreign = 1;
+   RAM_FAIL_TRAP(rampg_gethugestats(&after, &unused));
+   RAM_FAIL_TRAP(ramsys_releasehuge(foreign));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, before == after);
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,344 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/annotate.h>
+#include <ramalloc/big.h>
+#include <ramalloc/compat.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/mux.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/want.h>
+#include <ramalloc/stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* this test exercises the large object tier through the default allocator:
+ * acquisition, query and discard of objects too large for any size class,
+ * reuse of discarded mappings through the caches, resizing across the
+ * boundary between small and large objects (including growth into the
+ * hundreds of MiB), and the hand-off of an exiting thread's cache. it
+ * also reports how much the caches save on an acquire/discard pair. */
+
+#define PAIR_COUNT 2000
+#define PAIR_SIZE ((size_t)1 << 20)
+#define HUGE_SIZE ((size_t)256 << 20)
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t chkbasics();
+static ram_reply_t chkcaches();
+static ram_reply_t chkresize();
+static ram_reply_t chkcompat();
+static ram_reply_t chkorphan();
+static ram_reply_t timepairs(uint64_t *ns_arg, int flushflag_arg);
+static ram_reply_t orphan(void *arg_arg);
+static ram_reply_t fill(char *ptr_arg, size_t size_arg, char seed_arg);
+static ram_reply_t verify(const char *ptr_arg, size_t size_arg,
+      char seed_arg);
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   uint64_t cached = 0, uncached = 0;
+   size_t unused = 0;
+
+   RAMANNOTATE_UNUSEDARG(argc);
+   RAMANNOTATE_UNUSEDARG(argv);
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   RAM_FAIL_TRAP(chkbasics());
+   RAM_FAIL_TRAP(chkcaches());
+   RAM_FAIL_TRAP(chkresize());
+   RAM_FAIL_TRAP(chkcompat());
+   RAM_FAIL_TRAP(chkorphan());
+
+   RAM_FAIL_TRAP(timepairs(&cached, 0));
+   RAM_FAIL_TRAP(timepairs(&uncached, 1));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%zu KiB acquire/discard pair: %lu ns with the caches, "
+         "%lu ns without.\n", PAIR_SIZE >> 10,
+         (unsigned long)cached, (unsigned long)uncached));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkbasics()
+{
+   static const size_t sizes[] = {RAMMUX_MAXCLASSSIZE + 1, 65536, 65537,
+         PAIR_SIZE, 64 * PAIR_SIZE};
+   void *ptrs[sizeof(sizes) / sizeof(sizes[0])] = {0};
+   size_t i = 0, sz = 0, pgsz = 0;
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+   {
+      RAM_FAIL_TRAP(ram_acquire(&ptrs[i], sizes[i]));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            0 == ((uintptr_t)ptrs[i] & (pgsz - 1)));
+      RAM_FAIL_TRAP(ram_query(&sz, ptrs[i]));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz >= sizes[i] && sz - sizes[i] < pgsz);
+      RAM_FAIL_TRAP(fill((char *)ptrs[i], sizes[i], (char)i));
+   }
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+   {
+      RAM_FAIL_TRAP(verify((char *)ptrs[i], sizes[i], (char)i));
+      RAM_FAIL_TRAP(ram_discard(ptrs[i]));
+      /* a discarded object doesn't belong to anyone, even if its mapping
+       * is being held in a cache. */
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            RAM_REPLY_NOTFOUND == ram_query(&sz, ptrs[i]));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkcaches()
+{
+   rambig_stats_t before = {0}, after = {0};
+   void *p = NULL, *q = NULL;
+
+   RAM_FAIL_TRAP(ram_flush());
+   RAM_FAIL_TRAP(rambig_getstats(&before));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == before.rambigs_live);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == before.rambigs_cached);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == before.rambigs_threadcached);
+
+   RAM_FAIL_TRAP(ram_acquire(&p, PAIR_SIZE));
+   RAM_FAIL_TRAP(ram_discard(p));
+   /* a slightly smaller request can reuse the same mapping. */
+   RAM_FAIL_TRAP(ram_acquire(&q, PAIR_SIZE - PAIR_SIZE / 16));
+   RAM_FAIL_TRAP(rambig_getstats(&after));
+   if (RAM_WANT_LARGETHREADCACHEBYTES || RAM_WANT_LARGECACHEBYTES)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, p == q);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            after.rambigs_hits == before.rambigs_hits + 1);
+   }
+   else
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            after.rambigs_misses == before.rambigs_misses + 2);
+   }
+   RAM_FAIL_TRAP(ram_discard(q));
+
+   /* an object too large for the calling thread's cache goes straight to
+    * the shared one. */
+   RAM_FAIL_TRAP(ram_acquire(&p, RAM_WANT_LARGETHREADCACHEBYTES + 1));
+   RAM_FAIL_TRAP(rambig_getstats(&before));
+   RAM_FAIL_TRAP(ram_discard(p));
+   RAM_FAIL_TRAP(rambig_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.rambigs_threadcached == before.rambigs_threadcached);
+
+   RAM_FAIL_TRAP(ram_flush());
+   RAM_FAIL_TRAP(rambig_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == after.rambigs_cached);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == after.rambigs_threadcached);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkresize()
+{
+   rambig_stats_t before = {0}, after = {0};
+   void *p = NULL;
+   size_t sz = 0;
+
+   /* a small object grows into a large one. */
+   RAM_FAIL_TRAP(ram_acquire(&p, 100));
+   RAM_FAIL_TRAP(fill((char *)p, 100, 1));
+   RAM_FAIL_TRAP(ram_resize(&p, p, PAIR_SIZE));
+   RAM_FAIL_TRAP(verify((char *)p, 100, 1));
+   RAM_FAIL_TRAP(fill((char *)p, PAIR_SIZE, 2));
+
+   /* a large object grows into the hundreds of MiB. */
+   RAM_FAIL_TRAP(rambig_getstats(&before));
+   RAM_FAIL_TRAP(ram_resize(&p, p, HUGE_SIZE));
+   RAM_FAIL_TRAP(rambig_getstats(&after));
+   RAM_FAIL_TRAP(verify((char *)p, PAIR_SIZE, 2));
+   RAM_FAIL_TRAP(ram_query(&sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, HUGE_SIZE == sz);
+#ifdef RAMSYS_LINUX
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.rambigs_remaps == before.rambigs_remaps + 1);
+#endif
+   ((char *)p)[HUGE_SIZE - 1] = 3;
+
+   /* shrinking a little leaves the object where it is. */
+   RAM_FAIL_TRAP(ram_resize(&p, p, HUGE_SIZE - HUGE_SIZE / 16));
+   RAM_FAIL_TRAP(ram_query(&sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, HUGE_SIZE == sz);
+
+   /* shrinking a lot gives the pages back. */
+   RAM_FAIL_TRAP(ram_resize(&p, p, 2 * PAIR_SIZE));
+   RAM_FAIL_TRAP(ram_query(&sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 2 * PAIR_SIZE == sz);
+   RAM_FAIL_TRAP(verify((char *)p, PAIR_SIZE, 2));
+
+   /* a large object shrinks into a small one. */
+   RAM_FAIL_TRAP(ram_resize(&p, p, 1000));
+   RAM_FAIL_TRAP(ram_query(&sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz >= 1000 && sz <= RAMMUX_MAXCLASSSIZE);
+   RAM_FAIL_TRAP(verify((char *)p, 1000, 2));
+   RAM_FAIL_TRAP(ram_discard(p));
+
+   RAM_FAIL_TRAP(rambig_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == after.rambigs_live);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkcompat()
+{
+   char *p = NULL;
+
+   p = ramcompat_realloc(NULL, 50);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, NULL != p);
+   RAM_FAIL_TRAP(fill(p, 50, 4));
+   p = ramcompat_realloc(p, 3 * PAIR_SIZE);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, NULL != p);
+   RAM_FAIL_TRAP(verify(p, 50, 4));
+   p = ramcompat_realloc(p, 6 * PAIR_SIZE);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, NULL != p);
+   RAM_FAIL_TRAP(verify(p, 50, 4));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, NULL == ramcompat_realloc(p, 0));
+
+   /* zero-length objects come from the supplementary allocator. */
+   p = ramcompat_malloc(0);
+   p = ramcompat_realloc(p, 10);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, NULL != p);
+   ramcompat_free(p);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkorphan()
+{
+   ramthread_thread_t thread;
+   rambig_stats_t stats = {0};
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ram_flush());
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, &orphan, NULL));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+
+   /* the exiting thread's cache should have been handed to the shared
+    * cache. */
+   RAM_FAIL_TRAP(rambig_getstats(&stats));
+   if (RAM_WANT_LARGETHREADCACHEBYTES >= PAIR_SIZE &&
+         RAM_WANT_LARGECACHEBYTES >= PAIR_SIZE)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, PAIR_SIZE == stats.rambigs_cached);
+   }
+   RAM_FAIL_TRAP(ram_flush());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t orphan(void *arg_arg)
+{
+   void *p = NULL;
+
+   RAMANNOTATE_UNUSEDARG(arg_arg);
+
+   RAM_FAIL_TRAP(ram_acquire(&p, PAIR_SIZE));
+   RAM_FAIL_TRAP(ram_discard(p));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t timepairs(uint64_t *ns_arg, int flushflag_arg)
+{
+   uint64_t t0 = 0, t1 = 0;
+   void *p = NULL;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(ns_arg);
+
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < PAIR_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(ram_acquire(&p, PAIR_SIZE));
+      /* touching the first page is enough to make a fresh mapping pay
+       * for a page fault. */
+      *(char *)p = (char)i;
+      RAM_FAIL_TRAP(ram_discard(p));
+      /* without the caches, every pair costs two system calls. */
+      if (flushflag_arg)
+         RAM_FAIL_TRAP(rambig_flush());
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+
+   *ns_arg = (t1 - t0) / PAIR_COUNT;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t fill(char *ptr_arg, size_t size_arg, char seed_arg)
+{
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(ptr_arg);
+
+   for (i = 0; i < size_arg; i += 997)
+      ptr_arg[i] = (char)(seed_arg + i);
+   ptr_arg[size_arg - 1] = seed_arg;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t verify(const char *ptr_arg, size_t size_arg, char seed_arg)
+{
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(ptr_arg);
+
+   for (i = 0; i < size_arg - 1; i += 997)
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, ptr_arg[i] == (char)(seed_arg + i));
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,193 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* this benchmark creates and destroys threads in generations. each thread
+ * discards the objects that a thread from the previous generation left
+ * behind and then leaves objects of its own behind for the next
+ * generation, so every thread exits with objects still in use. the
+ * resident set size shouldn't grow once the first few generations have
+ * come and gone. */
+
+#define DEFAULT_THREAD_COUNT 100000
+#define CONCURRENCY 4
+#define OBJECT_COUNT 64
+#define MIN_OBJECT_SIZE 16
+#define SIZE_STEPS 16
+/* the resident set size is allowed to grow by this much after the warm up
+ * period, to account for noise. */
+#define RSS_TOLERANCE (4 * 1024 * 1024)
+
+typedef struct generation
+{
+   void *g_objects[CONCURRENCY][OBJECT_COUNT];
+} generation_t;
+
+typedef struct work
+{
+   generation_t *w_prev;
+   generation_t *w_next;
+   size_t w_slot;
+} work_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t churn(void *arg_arg);
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   static generation_t generations[2];
+   ramthread_thread_t threads[CONCURRENCY];
+   work_t work[CONCURRENCY];
+   size_t threadcount = DEFAULT_THREAD_COUNT, gencount = 0, warmup = 0;
+   size_t i = 0, j = 0, k = 0, warmrss = 0, finalrss = 0, unused = 0;
+   uint64_t t0 = 0, t1 = 0;
+   int rssflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   if (argc > 1)
+   {
+      threadcount = strtoul(argv[1], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, threadcount >= CONCURRENCY);
+   }
+   gencount = threadcount / CONCURRENCY;
+   warmup = gencount / 10;
+
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < gencount; ++i)
+   {
+      for (j = 0; j < CONCURRENCY; ++j)
+      {
+         work[j].w_prev = &generations[(i + 1) % 2];
+         work[j].w_next = &generations[i % 2];
+         work[j].w_slot = j;
+         RAM_FAIL_TRAP(ramthread_mkthread(&threads[j], &churn, &work[j]));
+      }
+      for (j = 0; j < CONCURRENCY; ++j)
+      {
+         RAM_FAIL_TRAP(ramthread_join(&e, threads[j]));
+         RAM_FAIL_TRAP(e);
+      }
+
+      if (i == warmup)
+      {
+         e = ramtest_rss(&warmrss);
+         switch (e)
+         {
+         default:
+            RAM_FAIL_TRAP(e);
+            return RAM_REPLY_INSANE;
+         case RAM_REPLY_UNSUPPORTED:
+            break;
+         case RAM_REPLY_OK:
+            rssflag = 1;
+            break;
+         }
+      }
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   if (rssflag)
+      RAM_FAIL_TRAP(ramtest_rss(&finalrss));
+
+   /* the last generation's objects are the only ones left. */
+   for (j = 0; j < CONCURRENCY; ++j)
+   {
+      for (k = 0; k < OBJECT_COUNT; ++k)
+      {
+         if (NULL != generations[(gencount + 1) % 2].g_objects[j][k])
+            RAM_FAIL_TRAP(ram_discard(
+                  generations[(gencount + 1) % 2].g_objects[j][k]));
+      }
+   }
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%zu threads in %lu ms (%lu us per thread); resident set size "
+         "went from %zu KiB to %zu KiB.\n",
+         gencount * CONCURRENCY, (unsigned long)((t1 - t0) / 1000000),
+         (unsigned long)((t1 - t0) / 1000 / (gencount * CONCURRENCY)),
+         warmrss / 1024, finalrss / 1024));
+   if (rssflag)
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, finalrss <= warmrss + RSS_TOLERANCE);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t churn(void *arg_arg)
+{
+   work_t *work = (work_t *)arg_arg;
+   void **prev = NULL, **next = NULL;
+   size_t i = 0, sz = 0;
+
+   RAM_FAIL_NOTNULL(work);
+
+   /* i take the objects from a neighboring slot so that most of them were
+    * acquired by a different thread than the one that would have used my
+    * slot in the previous generation. */
+   prev = work->w_prev->g_objects[(work->w_slot + 1) % CONCURRENCY];
+   next = work->w_next->g_objects[work->w_slot];
+   for (i = 0; i < OBJECT_COUNT; ++i)
+   {
+      if (NULL != prev[i])
+      {
+         RAM_FAIL_TRAP(ram_discard(prev[i]));
+         prev[i] = NULL;
+      }
+   }
+   for (i = 0; i < OBJECT_COUNT; ++i)
+   {
+      sz = MIN_OBJECT_SIZE * (1 + (i % SIZE_STEPS));
+      RAM_FAIL_TRAP(ram_acquire(&next[i], sz));
+      memset(next[i], 0x5a, sz);
+   }
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,211 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/mux.h>
+#include <ramalloc/algn.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/want.h>
+#include <ramalloc/annotate.h>
+#include <stdio.h>
+
+/* this test checks the size class table that CMake generates and reports
+ * how much memory each class wastes: the internal fragmentation of an
+ * object, in the worst case and on average, and what's left over at the
+ * end of each slab. it also reports how much metadata a mux pool carries
+ * before and after its classes are used. */
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t chkclass(size_t *classsz_arg, size_t idx_arg,
+      size_t prevsz_arg);
+static ram_reply_t tryclass(size_t *pages_arg, size_t *capacity_arg,
+      rammux_pool_t *pool_arg, size_t classsz_arg);
+
+static rammux_pool_t thepool;
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   size_t idx = 0, classsz = 0, prevsz = 0, smallest = 0, pgsz = 0;
+   size_t waste = 0, pages = 0, capacity = 0, unused = 0;
+   size_t fresh = 0, used = 0;
+   int emptyflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAMANNOTATE_UNUSEDARG(argc);
+   RAMANNOTATE_UNUSEDARG(argv);
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   RAM_FAIL_TRAP(rammux_mkpool(&thepool, RAM_WANT_DEFAULTAPPETITE));
+   /* a pool that hasn't been used doesn't have any size class pools. */
+   RAM_FAIL_TRAP(rammux_getfootprint(&fresh, &thepool));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sizeof(thepool) == fresh);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%lu size classes, %d per doubling, up to %lu bytes.\n",
+         (unsigned long)RAMMUX_CLASSCOUNT, RAMMUX_CLASSDIVISIONS,
+         (unsigned long)RAMMUX_MAXCLASSSIZE));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%5s %8s %8s %8s %8s %8s %8s %8s\n", "class", "size", "smallest",
+         "worst", "mean", "pages", "per slab", "tail"));
+
+   for (idx = 0; idx < RAMMUX_CLASSCOUNT; ++idx)
+   {
+      RAM_FAIL_TRAP(chkclass(&classsz, idx, prevsz));
+      smallest = prevsz + 1;
+      prevsz = classsz;
+      RAM_FAIL_TRAP(tryclass(&pages, &capacity, &thepool, classsz));
+
+      /* fragmentation is reported in tenths of a percent. the mean
+       * assumes that every size in the class is equally likely. */
+      waste = (classsz - smallest) * 1000 / classsz;
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "%5lu %8lu %8lu %6lu.%lu%% %6lu.%lu%% %8lu %8lu %8lu\n",
+            (unsigned long)idx, (unsigned long)classsz,
+            (unsigned long)smallest,
+            (unsigned long)(waste / 10), (unsigned long)(waste % 10),
+            (unsigned long)(waste / 2 / 10), (unsigned long)(waste / 2 % 10),
+            (unsigned long)pages, (unsigned long)capacity,
+            (unsigned long)(pages * pgsz - capacity * classsz)));
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, RAMMUX_MAXCLASSSIZE == prevsz);
+
+   /* anything larger than the largest class is out of range. */
+   e = rammux_getclass(&idx, &classsz, RAMMUX_MAXCLASSSIZE + 1);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, RAM_REPLY_RANGEFAIL == e);
+   RAM_FAIL_TRAP(rammux_chkpool(&thepool));
+
+   RAM_FAIL_TRAP(rammux_getfootprint(&used, &thepool));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, used > fresh);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == (used - fresh) % sizeof(ramalgn_pool_t));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "pool metadata: %lu bytes unused, %lu bytes with every class "
+         "(%lu bytes per class).\n", (unsigned long)fresh,
+         (unsigned long)used, (unsigned long)sizeof(ramalgn_pool_t)));
+
+   /* every object has been released, so the pool can be taken apart,
+    * refused classes and all. */
+   RAM_FAIL_TRAP(rammux_isempty(&emptyflag, &thepool));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, emptyflag);
+   RAM_FAIL_TRAP(rammux_rmpool(&thepool));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkclass(size_t *classsz_arg, size_t idx_arg, size_t prevsz_arg)
+{
+   size_t sz = 0, idx = 0, classsz = 0;
+
+   RAM_FAIL_NOTNULL(classsz_arg);
+   *classsz_arg = 0;
+
+   /* every size between the previous class and this one must map onto
+    * this class, which must be able to hold it. the last of them tells me
+    * the size of the class. */
+   RAM_FAIL_TRAP(rammux_getclass(&idx, classsz_arg, prevsz_arg + 1));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, *classsz_arg > prevsz_arg);
+   for (sz = prevsz_arg + 1; sz <= *classsz_arg; ++sz)
+   {
+      RAM_FAIL_TRAP(rammux_getclass(&idx, &classsz, sz));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, idx_arg == idx);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, *classsz_arg == classsz);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t tryclass(size_t *pages_arg, size_t *capacity_arg,
+      rammux_pool_t *pool_arg, size_t classsz_arg)
+{
+   char *p = NULL;
+   rammux_pool_t *pool = NULL;
+   ramalgn_pool_t *apool = NULL, *last = NULL;
+   size_t sz = 0, before = 0, after = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+   *pages_arg = 0;
+   RAM_FAIL_NOTNULL(capacity_arg);
+   *capacity_arg = 0;
+   RAM_FAIL_NOTNULL(pool_arg);
+
+   /* classes that won't fit into a slab are refused by the aligned
+    * pool. */
+   e = rammux_acquire((void **)&p, pool_arg, classsz_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      /* ...and stay refused, without taking up a pool. */
+      RAM_FAIL_TRAP(rammux_getfootprint(&before, pool_arg));
+      e = rammux_acquire((void **)&p, pool_arg, classsz_arg);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, RAM_REPLY_RANGEFAIL == e);
+      RAM_FAIL_TRAP(rammux_getfootprint(&after, pool_arg));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, before == after);
+      return RAM_REPLY_OK;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   RAM_FAIL_TRAP(rammux_query(&pool, &sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, pool_arg == pool);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, classsz_arg == sz);
+   /* the last byte of an object might be on a different page of the slab
+    * than the first. */
+   RAM_FAIL_TRAP(ramalgn_query(&apool, p));
+   RAM_FAIL_TRAP(ramalgn_query(&last, p + classsz_arg - 1));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, apool == last);
+   RAM_FAIL_TRAP(ramalgn_getslabsize(pages_arg, capacity_arg, apool));
+   /* a reservation must hold a whole number of slabs, whatever its size. */
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 ==
+         apool->ramalgnp_pgpool.rampgp_vpool.ramvecvp_nodecapacity % *pages_arg);
+   RAM_FAIL_TRAP(rammux_release(p));
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,192 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/barrier.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this test has one thread acquire a lot of memory and then go to sleep
+ * while several other threads discard it. once the producer wakes up, it
+ * measures how much was left waiting in its trash. in alternate rounds, the
+ * producer hands its pool off before it sleeps. when it does, the
+ * consumers reclaim on its behalf and little is left over; when it
+ * doesn't, nobody else may touch its pool and everything is left over. */
+
+#define OBJECT_COUNT 65536
+#define OBJECT_SIZE 64
+#define CONSUMER_COUNT 4
+#define ROUND_COUNT 4
+/* the delegates keep the trash shallow, so no more than a small fraction
+ * of the objects should be left over. */
+#define LEFTOVER_LIMIT (OBJECT_COUNT / 4)
+
+typedef struct shared
+{
+   rambarrier_barrier_t s_ready;
+   rambarrier_barrier_t s_done;
+   void **s_ptrs;
+   /* the most that was left over in a round that handed off. */
+   size_t s_worst;
+   /* the least that was left over in a round that didn't. */
+   size_t s_kept;
+} shared_t;
+
+typedef struct consumer
+{
+   shared_t *c_shared;
+   size_t c_id;
+} consumer_t;
+
+static ram_reply_t main2();
+static ram_reply_t produce(void *arg_arg);
+static ram_reply_t consume(void *arg_arg);
+
+int main()
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2();
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2()
+{
+   shared_t shared = {0};
+   consumer_t consumers[CONSUMER_COUNT] = {{0}};
+   ramthread_thread_t producer;
+   ramthread_thread_t threads[CONSUMER_COUNT];
+   size_t i = 0, unused = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   shared.s_ptrs = calloc(OBJECT_COUNT, sizeof(*shared.s_ptrs));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != shared.s_ptrs);
+   RAM_FAIL_TRAP(rambarrier_mkbarrier(&shared.s_ready, CONSUMER_COUNT + 1));
+   RAM_FAIL_TRAP(rambarrier_mkbarrier(&shared.s_done, CONSUMER_COUNT + 1));
+
+   RAM_FAIL_TRAP(ramthread_mkthread(&producer, &produce, &shared));
+   for (i = 0; i < CONSUMER_COUNT; ++i)
+   {
+      consumers[i].c_shared = &shared;
+      consumers[i].c_id = i;
+      RAM_FAIL_TRAP(ramthread_mkthread(&threads[i], &consume,
+            &consumers[i]));
+   }
+   for (i = 0; i < CONSUMER_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(ramthread_join(&e, threads[i]));
+      RAM_FAIL_TRAP(e);
+   }
+   RAM_FAIL_TRAP(ramthread_join(&e, producer));
+   RAM_FAIL_TRAP(e);
+
+   RAM_FAIL_TRAP(rambarrier_rmbarrier(&shared.s_ready));
+   RAM_FAIL_TRAP(rambarrier_rmbarrier(&shared.s_done));
+   free(shared.s_ptrs);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "at worst, %zu of %d objects were left in the sleeping producer's "
+         "trash after it handed off; without the hand-off, at least %zu "
+         "were.\n", shared.s_worst, OBJECT_COUNT, shared.s_kept));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, shared.s_worst <= LEFTOVER_LIMIT);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, OBJECT_COUNT == shared.s_kept);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t produce(void *arg_arg)
+{
+   shared_t *shared = (shared_t *)arg_arg;
+   ram_reclaimstats_t stats = {0};
+   size_t i = 0, j = 0, leftover = 0;
+
+   RAM_FAIL_NOTNULL(shared);
+
+   shared->s_kept = OBJECT_COUNT;
+   for (i = 0; i < ROUND_COUNT; ++i)
+   {
+      for (j = 0; j < OBJECT_COUNT; ++j)
+         RAM_FAIL_TRAP(ram_acquire(&shared->s_ptrs[j], OBJECT_SIZE));
+      if (0 == i % 2)
+         RAM_FAIL_TRAP(ram_handoff());
+      RAM_FAIL_TRAP(rambarrier_wait(&shared->s_ready));
+      /* while i wait here, i'm not doing anything to empty my trash. */
+      RAM_FAIL_TRAP(rambarrier_wait(&shared->s_done));
+
+      leftover = 0;
+      do
+      {
+         RAM_FAIL_TRAP(ram_reclaimfor(&stats, (uint64_t)-1));
+         leftover += stats.ramdrs_objects;
+      }
+      while (!stats.ramdrs_complete);
+      if (0 != i % 2)
+      {
+         if (leftover < shared->s_kept)
+            shared->s_kept = leftover;
+      }
+      else if (leftover > shared->s_worst)
+         shared->s_worst = leftover;
+      RAM_FAIL_TRAP(ram_default_check());
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t consume(void *arg_arg)
+{
+   consumer_t *consumer = (consumer_t *)arg_arg;
+   size_t i = 0, j = 0;
+
+   RAM_FAIL_NOTNULL(consumer);
+
+   for (i = 0; i < ROUND_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(rambarrier_wait(&consumer->c_shared->s_ready));
+      /* the consumers take turns, object by object, so that they all
+       * discard to the same pages at once. */
+      for (j = consumer->c_id; j < OBJECT_COUNT; j += CONSUMER_COUNT)
+         RAM_FAIL_TRAP(ram_discard(consumer->c_shared->s_ptrs[j]));
+      RAM_FAIL_TRAP(ram_flush());
+      RAM_FAIL_TRAP(rambarrier_wait(&consumer->c_shared->s_done));
+   }
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,203 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/barrier.h>
+#include <ramalloc/annotate.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this test plays the part of a fiber scheduler that moves a fiber, and
+ * the fiber's heap, between two threads. memory the fiber discards itself
+ * is released immediately, no matter which thread it's running on;
+ * memory that another thread discards is sent back to the heap and
+ * reclaimed by whichever thread is running the fiber at the time. */
+
+#define OBJECT_COUNT 256
+#define OBJECT_SIZE 32
+/* too large for any size class. */
+#define LARGE_SIZE 65536
+/* small enough for ram_acquire() to put into a tiny cell. */
+#define TINY_SIZE 3
+
+typedef struct fiber
+{
+   ram_heap_t *f_heap;
+   void *f_objects[OBJECT_COUNT];
+   size_t f_reclaimed;
+   /* the threads take turns between these, so each one also hands the
+    * heap from one thread to the other. */
+   rambarrier_barrier_t f_barrier;
+} fiber_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t threada(void *arg_arg);
+static ram_reply_t threadb(void *arg_arg);
+static ram_reply_t tryunpooled();
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   static fiber_t fiber;
+   ramthread_thread_t a, b;
+   size_t sz = 0, unused = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAMANNOTATE_UNUSEDARG(argc);
+   RAMANNOTATE_UNUSEDARG(argv);
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   RAM_FAIL_TRAP(ram_mkheap(&fiber.f_heap));
+   RAM_FAIL_TRAP(rambarrier_mkbarrier(&fiber.f_barrier, 2));
+   RAM_FAIL_TRAP(ramthread_mkthread(&a, &threada, &fiber));
+   RAM_FAIL_TRAP(ramthread_mkthread(&b, &threadb, &fiber));
+   RAM_FAIL_TRAP(ramthread_join(&e, a));
+   RAM_FAIL_TRAP(e);
+   RAM_FAIL_TRAP(ramthread_join(&e, b));
+   RAM_FAIL_TRAP(e);
+   RAM_FAIL_TRAP(rambarrier_rmbarrier(&fiber.f_barrier));
+
+   /* everything that the other thread discarded came back to the heap. */
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%zu of %d objects discarded by another thread were reclaimed "
+         "into the heap.\n", fiber.f_reclaimed, OBJECT_COUNT / 2));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, OBJECT_COUNT / 2 == fiber.f_reclaimed);
+
+   /* the last object outlived its heap, which doesn't make it any less
+    * valid. */
+   RAM_FAIL_TRAP(ram_query(&sz, fiber.f_objects[0]));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz >= OBJECT_SIZE);
+   RAM_FAIL_TRAP(ram_discard(fiber.f_objects[0]));
+   RAM_FAIL_TRAP(ram_default_check());
+
+   RAM_FAIL_TRAP(tryunpooled());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t tryunpooled()
+{
+   ram_heap_t *heap = NULL;
+   void *p = NULL;
+   size_t sz = 0;
+
+   /* objects that don't belong to any heap can still be acquired and
+    * discarded through one, whichever way they were acquired. */
+   RAM_FAIL_TRAP(ram_mkheap(&heap));
+   RAM_FAIL_TRAP(ram_heapacquire(&p, heap, LARGE_SIZE));
+   RAM_FAIL_TRAP(ram_query(&sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz >= LARGE_SIZE);
+   RAM_FAIL_TRAP(ram_heapdiscard(heap, p));
+   RAM_FAIL_TRAP(ram_acquire(&p, LARGE_SIZE));
+   RAM_FAIL_TRAP(ram_heapdiscard(heap, p));
+   RAM_FAIL_TRAP(ram_acquire(&p, TINY_SIZE));
+   RAM_FAIL_TRAP(ram_heapdiscard(heap, p));
+   /* a heap doesn't hand out tiny cells, but what it does hand out goes
+    * back the same way. */
+   RAM_FAIL_TRAP(ram_heapacquire(&p, heap, TINY_SIZE));
+   RAM_FAIL_TRAP(ram_heapdiscard(heap, p));
+   RAM_FAIL_TRAP(ram_rmheap(heap));
+   RAM_FAIL_TRAP(ram_default_check());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t threada(void *arg_arg)
+{
+   fiber_t *fiber = (fiber_t *)arg_arg;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(fiber);
+
+   /* step 1: the fiber runs here and fills its working set. */
+   for (i = 0; i < OBJECT_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(ram_heapacquire(&fiber->f_objects[i], fiber->f_heap,
+            OBJECT_SIZE));
+   }
+   RAM_FAIL_TRAP(rambarrier_wait(&fiber->f_barrier));
+   /* step 2: the fiber has moved to the other thread. */
+   RAM_FAIL_TRAP(rambarrier_wait(&fiber->f_barrier));
+   /* step 3: this thread discards the second half of the objects without
+    * the heap's involvement, as it would for objects passed to it by the
+    * fiber. they're buffered in this thread's own pool until they're
+    * dispatched. */
+   for (i = OBJECT_COUNT / 2; i < OBJECT_COUNT; ++i)
+      RAM_FAIL_TRAP(ram_discard(fiber->f_objects[i]));
+   RAM_FAIL_TRAP(ram_flush());
+   RAM_FAIL_TRAP(rambarrier_wait(&fiber->f_barrier));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t threadb(void *arg_arg)
+{
+   fiber_t *fiber = (fiber_t *)arg_arg;
+   size_t i = 0, count = 0;
+
+   RAM_FAIL_NOTNULL(fiber);
+
+   RAM_FAIL_TRAP(rambarrier_wait(&fiber->f_barrier));
+   /* step 2: the fiber runs here now and discards the first half of its
+    * objects, except for one. the heap owns them, so they're released
+    * immediately and nothing should end up in its trash. */
+   for (i = 1; i < OBJECT_COUNT / 2; ++i)
+      RAM_FAIL_TRAP(ram_heapdiscard(fiber->f_heap, fiber->f_objects[i]));
+   RAM_FAIL_TRAP(ram_heapreclaim(&count, fiber->f_heap, (size_t)-1));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == count);
+   RAM_FAIL_TRAP(rambarrier_wait(&fiber->f_barrier));
+   /* step 3: the other thread is discarding. */
+   RAM_FAIL_TRAP(rambarrier_wait(&fiber->f_barrier));
+   /* step 4: the fiber reclaims what the other thread sent back and then
+    * finishes, leaving one object behind. */
+   RAM_FAIL_TRAP(ram_heapreclaim(&fiber->f_reclaimed, fiber->f_heap,
+         (size_t)-1));
+   RAM_FAIL_TRAP(ram_rmheap(fiber->f_heap));
+   fiber->f_heap = NULL;
+
+   return RAM_REPLY_OK;
+}
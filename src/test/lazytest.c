@@ -47,8 +47,9 @@
 #define DEFAULT_MINIMUM_ALLOCATION_SIZE 8
 #define DEFAULT_MAXIMUM_ALLOCATION_SIZE 128
 #define DEFAULT_MALLOC_CHANCE 30
-/* currently, the reclaim ratio cannot be parameterized. */
+/* currently, the reclaim policy cannot be parameterized. */
 #define RECLAIM_RATIO 2
+#define RECLAIM_LIMIT 16
 
 typedef struct extra
 {
@@ -248,27 +249,23 @@ ram_reply_t runtest2(const ramtest_params_t *params_arg,
 {
    size_t i = 0;
    ramtest_params_t testparams = {0};
-   size_t unused = 0;
+   ramlazy_policy_t policy = {0};
+   ram_reply_t e = RAM_REPLY_INSANE;
 
    testparams = *params_arg;
-   /* i am responsible for policing the minimum and maximum allocation
-    * size here. */
-   if (testparams.ramtestp_minsize < sizeof(void *) ||
-         testparams.ramtestp_maxsize < sizeof(void *))
-   {
-      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
-            "you cannot specify a size smaller than %zu bytes.\n",
-            sizeof(void *)));
-      return RAM_REPLY_INPUTFAIL;
-   }
-   /* TODO: shouldn't this test be moved into the framework? */
-   if (testparams.ramtestp_minsize > testparams.ramtestp_maxsize)
+   policy.ramlazyp_mingoal = RECLAIM_RATIO;
+   policy.ramlazyp_maxgoal = RECLAIM_LIMIT;
+   e = ramtest_chksizes(&testparams);
+   switch (e)
    {
-      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
-            "please specify a minimum size (%zu bytes) that is smaller than "
-            "or equal to the maximum (%zu bytes).\n",
-            testparams.ramtestp_minsize, testparams.ramtestp_maxsize));
-      return RAM_REPLY_INPUTFAIL;
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_INPUTFAIL:
+      return e;
+   case RAM_REPLY_OK:
+      break;
    }
    /* TODO: how do i determine the maximum allocation size ahead of time? */
    testparams.ramtestp_extra = extra_arg;
@@ -281,7 +278,7 @@ ram_reply_t runtest2(const ramtest_params_t *params_arg,
    for (i = 0; i < extra_arg->e_poolcount; ++i)
    {
       RAM_FAIL_TRAP(ramlazy_mkpool(&extra_arg->e_pools[i],
-            RAM_WANT_DEFAULTAPPETITE, RECLAIM_RATIO));
+            RAM_WANT_DEFAULTAPPETITE, &policy));
    }
 
    RAM_FAIL_TRAP(ramtest_test(&testparams));
@@ -0,0 +1,213 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/atom.h>
+#include <stdlib.h>
+#include <stdio.h>
+#ifdef RAMSYS_LINUX
+#  include <sys/eventfd.h>
+#  include <poll.h>
+#  include <unistd.h>
+#endif
+
+/* this test has a second thread discard memory belonging to the main
+ * thread and checks that the main thread is told about it only once the
+ * trash is deep enough. on Linux, the notification goes through an
+ * eventfd, the way an event loop would consume it. */
+
+#define OBJECT_COUNT 8192
+#define OBJECT_SIZE 64
+#define NOTIFY_DEPTH 16
+
+typedef struct work
+{
+   void **w_ptrs;
+   size_t w_count;
+} work_t;
+
+typedef struct listener
+{
+   ramatom_counter_t l_count;
+   int l_fd;
+} listener_t;
+
+static ram_reply_t main2();
+static ram_reply_t exercise(size_t *notices_arg, listener_t *listener_arg,
+      void **ptrs_arg, size_t count_arg);
+static ram_reply_t discard(void *arg_arg);
+static ram_reply_t notify(void *context_arg);
+
+int main()
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2();
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2()
+{
+   listener_t listener = {0};
+   ram_notifier_t notifier = {0};
+   void **ptrs = NULL;
+   size_t count = 0, unused = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   ptrs = calloc(OBJECT_COUNT, sizeof(*ptrs));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != ptrs);
+   listener.l_fd = -1;
+#ifdef RAMSYS_LINUX
+   listener.l_fd = eventfd(0, EFD_NONBLOCK);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, listener.l_fd >= 0);
+#endif
+
+   notifier.ramdn_depth = 0;
+   notifier.ramdn_func = &notify;
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_DISALLOWED == ram_notify(&notifier));
+   notifier.ramdn_depth = NOTIFY_DEPTH;
+   notifier.ramdn_context = &listener;
+   RAM_FAIL_TRAP(ram_notify(&notifier));
+
+   /* a handful of objects fit on a page or two, which is well short of
+    * the depth. */
+   RAM_FAIL_TRAP(exercise(&count, &listener, ptrs, NOTIFY_DEPTH));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == count);
+   /* a page's worth of objects at a time quickly gets there, but it only
+    * gets there once. */
+   RAM_FAIL_TRAP(exercise(&count, &listener, ptrs, OBJECT_COUNT));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 1 == count);
+   /* once the trash has been serviced, it can get there again. */
+   RAM_FAIL_TRAP(exercise(&count, &listener, ptrs, OBJECT_COUNT));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 1 == count);
+   /* without a notifier, nobody hears a thing. */
+   RAM_FAIL_TRAP(ram_notify(NULL));
+   RAM_FAIL_TRAP(exercise(&count, &listener, ptrs, OBJECT_COUNT));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == count);
+
+#ifdef RAMSYS_LINUX
+   (void)close(listener.l_fd);
+#endif
+   free(ptrs);
+   RAM_FAIL_TRAP(ram_default_check());
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "notifications arrived as expected.\n"));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t exercise(size_t *notices_arg, listener_t *listener_arg,
+      void **ptrs_arg, size_t count_arg)
+{
+   ramthread_thread_t thread;
+   work_t work = {0};
+   size_t i = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+#ifdef RAMSYS_LINUX
+   struct pollfd pfd = {0};
+   uint64_t value = 0;
+#endif
+
+   RAM_FAIL_NOTNULL(notices_arg);
+   *notices_arg = 0;
+   RAM_FAIL_NOTNULL(listener_arg);
+   RAM_FAIL_NOTNULL(ptrs_arg);
+
+   listener_arg->l_count = 0;
+   for (i = 0; i < count_arg; ++i)
+      RAM_FAIL_TRAP(ram_acquire(&ptrs_arg[i], OBJECT_SIZE));
+   work.w_ptrs = ptrs_arg;
+   work.w_count = count_arg;
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, &discard, &work));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+
+#ifdef RAMSYS_LINUX
+   /* this is what an event loop would see. */
+   pfd.fd = listener_arg->l_fd;
+   pfd.events = POLLIN;
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, poll(&pfd, 1, 0) >= 0);
+   if (pfd.revents & POLLIN)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+            sizeof(value) == read(listener_arg->l_fd, &value, sizeof(value)));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            (uint64_t)listener_arg->l_count == value);
+   }
+   else
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == listener_arg->l_count);
+#endif
+
+   *notices_arg = (size_t)listener_arg->l_count;
+   RAM_FAIL_TRAP(ram_flush());
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t discard(void *arg_arg)
+{
+   work_t *work = (work_t *)arg_arg;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(work);
+
+   for (i = 0; i < work->w_count; ++i)
+      RAM_FAIL_TRAP(ram_discard(work->w_ptrs[i]));
+   RAM_FAIL_TRAP(ram_flush());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t notify(void *context_arg)
+{
+   listener_t *listener = (listener_t *)context_arg;
+#ifdef RAMSYS_LINUX
+   uint64_t one = 1;
+#endif
+
+   RAM_FAIL_NOTNULL(listener);
+
+   ramatom_xadd(&listener->l_count, 1);
+#ifdef RAMSYS_LINUX
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL,
+         sizeof(one) == write(listener->l_fd, &one, sizeof(one)));
+#endif
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,153 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/para.h>
+#include <ramalloc/thread.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this test checks that a parallel pool refuses to be taken apart while
+ * objects in a thread's pool are still in use, whether the thread has
+ * exited or not, and that it succeeds once they've all been released. */
+
+#define OBJECT_COUNT 4096
+#define OBJECT_SIZE 48
+
+typedef struct work
+{
+   rampara_pool_t *w_pool;
+   void **w_ptrs;
+} work_t;
+
+static ram_reply_t main2();
+static ram_reply_t run(ram_reply_t (*func_arg)(void *), work_t *work_arg);
+static ram_reply_t acquire(void *arg_arg);
+static ram_reply_t release(void *arg_arg);
+
+int main()
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2();
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2()
+{
+   rampara_pool_t pool;
+   ramlazy_policy_t policy = {0};
+   work_t work = {0};
+   void *p = NULL;
+   size_t unused = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   work.w_ptrs = calloc(OBJECT_COUNT, sizeof(*work.w_ptrs));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != work.w_ptrs);
+   work.w_pool = &pool;
+   policy.ramlazyp_mingoal = 8;
+   policy.ramlazyp_maxgoal = 512;
+
+   /* a thread that exits while its objects are in use leaves an orphan
+    * that can't be freed yet. */
+   RAM_FAIL_TRAP(rampara_mkpool(&pool, RAM_WANT_DEFAULTAPPETITE, &policy));
+   RAM_FAIL_TRAP(run(&acquire, &work));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_DISALLOWED == rampara_rmpool(&pool));
+   /* the pool is still usable after it's been refused. */
+   RAM_FAIL_TRAP(rampara_chkpool(&pool));
+   RAM_FAIL_TRAP(run(&release, &work));
+   RAM_FAIL_TRAP(rampara_rmpool(&pool));
+
+   /* the same goes for the calling thread's own pool. */
+   RAM_FAIL_TRAP(rampara_mkpool(&pool, RAM_WANT_DEFAULTAPPETITE, &policy));
+   RAM_FAIL_TRAP(rampara_acquire(&p, &pool, OBJECT_SIZE));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_DISALLOWED == rampara_rmpool(&pool));
+   RAM_FAIL_TRAP(rampara_release(p));
+   RAM_FAIL_TRAP(rampara_rmpool(&pool));
+
+   free(work.w_ptrs);
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "the pool was taken apart only once it was empty.\n"));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t run(ram_reply_t (*func_arg)(void *), work_t *work_arg)
+{
+   ramthread_thread_t thread;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, func_arg, work_arg));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t acquire(void *arg_arg)
+{
+   work_t *work = (work_t *)arg_arg;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(work);
+
+   for (i = 0; i < OBJECT_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(rampara_acquire(&work->w_ptrs[i], work->w_pool,
+            OBJECT_SIZE));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t release(void *arg_arg)
+{
+   work_t *work = (work_t *)arg_arg;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(work);
+
+   /* this thread adopts the orphan, so it's orphaned again (and empty)
+    * when the thread exits. */
+   for (i = 0; i < OBJECT_COUNT; ++i)
+      RAM_FAIL_TRAP(rampara_release(work->w_ptrs[i]));
+
+   return RAM_REPLY_OK;
+}
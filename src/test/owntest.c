@@ -0,0 +1,160 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/own.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+
+/* this test exercises the ownership map directly and then makes sure that
+ * foreign addresses aren't mistaken for the allocator's own, even if they
+ * contain bytes that used to identify a page footer. */
+
+#define PAGE_COUNT 64
+#define LOOKUP_COUNT 1000000
+#define OBJECT_SIZE 64
+
+static ram_reply_t main2();
+static ram_reply_t chkmap();
+static ram_reply_t chkforeign();
+
+static ramown_map_t owntest_themap;
+
+int main()
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2();
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2()
+{
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   RAM_FAIL_TRAP(chkmap());
+   RAM_FAIL_TRAP(chkforeign());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkmap()
+{
+   uintptr_t base = 0;
+   uint64_t t0 = 0, t1 = 0;
+   size_t pgsz = 0, i = 0, footprint = 0, unused = 0;
+   void *owner = NULL;
+   char *p = NULL;
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   /* i don't need real pages to exercise the map; any page-aligned address
+    * will do. i pick one that straddles a leaf boundary. */
+   base = ((uintptr_t)1 << 40) - (PAGE_COUNT / 2) * pgsz;
+
+   for (i = 0; i < PAGE_COUNT; ++i)
+   {
+      p = (char *)(base + i * pgsz);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            RAM_REPLY_NOTFOUND == ramown_get(&owner, &owntest_themap, p));
+      RAM_FAIL_TRAP(ramown_set(&owntest_themap, p, (void *)(i + 1)));
+   }
+   for (i = 0; i < PAGE_COUNT; ++i)
+   {
+      /* any address within the page should resolve to its owner. */
+      p = (char *)(base + i * pgsz + pgsz - 1);
+      RAM_FAIL_TRAP(ramown_get(&owner, &owntest_themap, p));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, (void *)(i + 1) == owner);
+   }
+   /* addresses the map can't represent aren't found either. */
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, RAM_REPLY_NOTFOUND ==
+         ramown_get(&owner, &owntest_themap, (void *)UINTPTR_MAX));
+
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < LOOKUP_COUNT; ++i)
+   {
+      p = (char *)(base + (i % PAGE_COUNT) * pgsz);
+      RAM_FAIL_TRAP(ramown_get(&owner, &owntest_themap, p));
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+
+   RAM_FAIL_TRAP(ramown_getfootprint(&footprint, &owntest_themap));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%d pages; lookup latency is %lu ns; the map uses %zu bytes.\n",
+         PAGE_COUNT, (unsigned long)((t1 - t0) * 1000 / LOOKUP_COUNT) / 1000,
+         footprint));
+
+   for (i = 0; i < PAGE_COUNT; ++i)
+   {
+      p = (char *)(base + i * pgsz);
+      RAM_FAIL_TRAP(ramown_set(&owntest_themap, p, NULL));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            RAM_REPLY_NOTFOUND == ramown_get(&owner, &owntest_themap, p));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkforeign()
+{
+   char *foreign = NULL;
+   char *p = NULL;
+   size_t pgsz = 0, sz = 0;
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   /* a page from somewhere else, with the bytes that used to identify
+    * aligned and page pool footers scattered all over it. */
+   foreign = malloc(pgsz * 2);
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != foreign);
+   for (p = foreign; p + 4 <= foreign + pgsz * 2; p += 4)
+      memcpy(p, (0 == (p - foreign) % 8) ? "ALIG" : "PAGE", 4);
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_NOTFOUND == ram_query(&sz, foreign + pgsz));
+   free(foreign);
+
+   /* the allocator's own objects are still found, of course. */
+   RAM_FAIL_TRAP(ram_acquire((void **)&p, OBJECT_SIZE));
+   RAM_FAIL_TRAP(ram_query(&sz, p));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz >= OBJECT_SIZE);
+   RAM_FAIL_TRAP(ram_discard(p));
+   RAM_FAIL_TRAP(ram_flush());
+
+   return RAM_REPLY_OK;
+}
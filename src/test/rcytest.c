@@ -0,0 +1,292 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/pg.h>
+#include <ramalloc/rcy.h>
+#include <ramalloc/sys.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+
+/* this test simulates a phase change, where one page pool shrinks while
+ * another grows, with and without the recycler. it then checks the
+ * recycler's watermarks and hammers it from several threads at once to
+ * make sure that no reservation is ever handed to two owners. */
+
+#define DEFAULT_PAGE_COUNT 4096
+#define ITERATION_COUNT 2000
+#define THREAD_HOLD 12
+#define THREAD_LOW 2
+#define THREAD_HIGH 8
+
+typedef struct result
+{
+   uint64_t r_growns;
+   size_t r_hits;
+   size_t r_misses;
+} result_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t phasechange(result_t *result_arg, char **pages_arg,
+      size_t count_arg);
+static ram_reply_t chkwatermarks(char **pages_arg, size_t count_arg);
+static ram_reply_t chkparallel();
+static ram_reply_t churn(void *arg_arg);
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   result_t recycled = {0}, unrecycled = {0};
+   char **pages = NULL;
+   size_t count = DEFAULT_PAGE_COUNT;
+   size_t low = 0, high = 0, unused = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   if (argc > 1)
+   {
+      count = strtoul(argv[1], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, count > 0);
+   }
+
+   pages = calloc(count, sizeof(*pages));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != pages);
+
+   RAM_FAIL_TRAP(ramrcy_getwatermarks(&low, &high));
+   RAM_FAIL_TRAP(phasechange(&recycled, pages, count));
+   RAM_FAIL_TRAP(ramrcy_setwatermarks(0, 0));
+   RAM_FAIL_TRAP(phasechange(&unrecycled, pages, count));
+   RAM_FAIL_TRAP(ramrcy_setwatermarks(low, high));
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%zu pages; phase change latency in ns/page.\n"
+         "recycler  grow  hits  misses\n"
+         "enabled   %4lu  %4zu  %6zu\n"
+         "disabled  %4lu  %4zu  %6zu\n",
+         count,
+         (unsigned long)recycled.r_growns, recycled.r_hits,
+         recycled.r_misses,
+         (unsigned long)unrecycled.r_growns, unrecycled.r_hits,
+         unrecycled.r_misses));
+   /* if the recycler is enabled, a growing pool should find the
+    * reservations the shrinking pool gave up. */
+   if (high)
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, recycled.r_hits > 0);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == unrecycled.r_hits);
+
+   RAM_FAIL_TRAP(chkwatermarks(pages, count));
+   free(pages);
+   if (high >= THREAD_HIGH)
+      RAM_FAIL_TRAP(chkparallel());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t phasechange(result_t *result_arg, char **pages_arg,
+      size_t count_arg)
+{
+   rampg_pool_t shrinking, growing;
+   ramrcy_stats_t before = {0}, after = {0};
+   uint64_t t0 = 0, t1 = 0;
+   size_t i = 0, gran = 0;
+
+   RAM_FAIL_NOTNULL(result_arg);
+   RAM_FAIL_NOTNULL(pages_arg);
+   RAM_FAIL_NOTZERO(count_arg);
+
+   RAM_FAIL_TRAP(rampg_getgranularity(&gran));
+   RAM_FAIL_TRAP(rampg_mkpool(&shrinking, RAMOPT_FRUGAL));
+   RAM_FAIL_TRAP(rampg_mkpool(&growing, RAMOPT_FRUGAL));
+
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(rampg_acquire((void **)&pages_arg[i], &shrinking));
+      memset(pages_arg[i], 0x5a, gran);
+   }
+   for (i = 0; i < count_arg; ++i)
+      RAM_FAIL_TRAP(rampg_release(pages_arg[i]));
+
+   RAM_FAIL_TRAP(ramrcy_getstats(&before));
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(rampg_acquire((void **)&pages_arg[i], &growing));
+      memset(pages_arg[i], 0xa5, gran);
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   RAM_FAIL_TRAP(ramrcy_getstats(&after));
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(rampg_release(pages_arg[i]));
+      pages_arg[i] = NULL;
+   }
+
+   result_arg->r_growns = (t1 - t0) / count_arg;
+   result_arg->r_hits = after.ramrcys_hits - before.ramrcys_hits;
+   result_arg->r_misses = after.ramrcys_misses - before.ramrcys_misses;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkwatermarks(char **pages_arg, size_t count_arg)
+{
+   rampg_pool_t pool;
+   ramrcy_stats_t stats = {0};
+   size_t i = 0, low = 0, high = 0;
+
+   RAM_FAIL_NOTNULL(pages_arg);
+
+   RAM_FAIL_TRAP(ramrcy_getwatermarks(&low, &high));
+
+   RAM_FAIL_TRAP(rampg_mkpool(&pool, RAMOPT_FRUGAL));
+   for (i = 0; i < count_arg; ++i)
+      RAM_FAIL_TRAP(rampg_acquire((void **)&pages_arg[i], &pool));
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(rampg_release(pages_arg[i]));
+      pages_arg[i] = NULL;
+      RAM_FAIL_TRAP(ramrcy_getstats(&stats));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, stats.ramrcys_count <= high);
+   }
+
+   /* lowering the high watermark takes effect immediately. */
+   RAM_FAIL_TRAP(ramrcy_setwatermarks(low / 2, low));
+   RAM_FAIL_TRAP(ramrcy_getstats(&stats));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, stats.ramrcys_count <= low);
+   RAM_FAIL_TRAP(ramrcy_flush());
+   RAM_FAIL_TRAP(ramrcy_getstats(&stats));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == stats.ramrcys_count);
+   RAM_FAIL_TRAP(ramrcy_setwatermarks(low, high));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkparallel()
+{
+   ramthread_thread_t *threads = NULL;
+   ramrcy_stats_t before = {0}, after = {0};
+   size_t i = 0, threadcount = 0, low = 0, high = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ramtest_defaultthreadcount(&threadcount));
+   if (threadcount < 2)
+      threadcount = 2;
+   threads = calloc(threadcount, sizeof(*threads));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != threads);
+
+   RAM_FAIL_TRAP(ramrcy_getwatermarks(&low, &high));
+   RAM_FAIL_TRAP(ramrcy_setwatermarks(THREAD_LOW, THREAD_HIGH));
+   RAM_FAIL_TRAP(ramrcy_getstats(&before));
+   for (i = 0; i < threadcount; ++i)
+      RAM_FAIL_TRAP(ramthread_mkthread(&threads[i], &churn, (void *)(i + 1)));
+   for (i = 0; i < threadcount; ++i)
+   {
+      RAM_FAIL_TRAP(ramthread_join(&e, threads[i]));
+      RAM_FAIL_TRAP(e);
+   }
+   free(threads);
+   RAM_FAIL_TRAP(ramrcy_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramrcys_hits > before.ramrcys_hits);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramrcys_trims > before.ramrcys_trims);
+
+   RAM_FAIL_TRAP(ramrcy_flush());
+   RAM_FAIL_TRAP(ramrcy_setwatermarks(low, high));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t churn(void *arg_arg)
+{
+   uintptr_t id = (uintptr_t)arg_arg;
+   volatile uintptr_t *owner = NULL;
+   char *pages[THREAD_HOLD] = {0};
+   size_t i = 0, j = 0;
+   int commitflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTZERO(id);
+
+   for (i = 0; i < ITERATION_COUNT; ++i)
+   {
+      /* i hold onto more reservations at a time than the high watermark
+       * allows for, so that the recycler oscillates between its
+       * watermarks. */
+      for (j = 0; j < THREAD_HOLD; ++j)
+      {
+         e = ramrcy_withdraw(&pages[j], &commitflag);
+         switch (e)
+         {
+         default:
+            RAM_FAIL_TRAP(e);
+            return RAM_REPLY_INSANE;
+         case RAM_REPLY_OK:
+            /* i only deposit committed reservations. */
+            RAM_FAIL_EXPECT(RAM_REPLY_INSANE, commitflag);
+            break;
+         case RAM_REPLY_NOTFOUND:
+            RAM_FAIL_TRAP(ramsys_bulkalloc(&pages[j]));
+            break;
+         }
+         /* each reservation records its owner in its first word; if a
+          * reservation were handed to two threads at once, one of them
+          * would find the other's mark. */
+         owner = (volatile uintptr_t *)pages[j];
+         RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0 == *owner);
+         *owner = id;
+      }
+      for (j = 0; j < THREAD_HOLD; ++j)
+      {
+         owner = (volatile uintptr_t *)pages[j];
+         RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, id == *owner);
+         *owner = 0;
+         RAM_FAIL_TRAP(ramrcy_deposit(pages[j], 1));
+      }
+   }
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,143 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this test has a second thread discard everything the main thread
+ * acquired and then has the main thread reclaim it a frame at a time,
+ * making sure that a frame with no budget left stops short and that
+ * repeated frames eventually account for every object. */
+
+#define DEFAULT_OBJECT_COUNT 2048
+#define OBJECT_SIZE 64
+/* one millisecond is a generous slice of a 60Hz frame. */
+#define FRAME_BUDGET 1000000
+
+typedef struct work
+{
+   void **w_ptrs;
+   size_t w_count;
+} work_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t discard(void *arg_arg);
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   ram_reclaimstats_t stats = {0};
+   ramthread_thread_t thread;
+   work_t work = {0};
+   size_t i = 0, objects = 0, pages = 0, frames = 0, unused = 0;
+   uint64_t worst = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   work.w_count = DEFAULT_OBJECT_COUNT;
+   if (argc > 1)
+   {
+      work.w_count = strtoul(argv[1], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, work.w_count > 0);
+   }
+   work.w_ptrs = calloc(work.w_count, sizeof(*work.w_ptrs));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != work.w_ptrs);
+
+   for (i = 0; i < work.w_count; ++i)
+      RAM_FAIL_TRAP(ram_acquire(&work.w_ptrs[i], OBJECT_SIZE));
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, &discard, &work));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+   free(work.w_ptrs);
+
+   /* a frame without any budget still makes progress, but it can't
+    * finish the job. */
+   RAM_FAIL_TRAP(ram_reclaimfor(&stats, 0));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, !stats.ramdrs_complete);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, stats.ramdrs_objects > 0);
+   objects = stats.ramdrs_objects;
+   pages = stats.ramdrs_pages;
+   frames = 1;
+
+   do
+   {
+      RAM_FAIL_TRAP(ram_reclaimfor(&stats, FRAME_BUDGET));
+      objects += stats.ramdrs_objects;
+      pages += stats.ramdrs_pages;
+      if (stats.ramdrs_elapsed > worst)
+         worst = stats.ramdrs_elapsed;
+      ++frames;
+   }
+   while (!stats.ramdrs_complete);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "reclaimed %zu objects and %zu pages over %zu frames; the longest "
+         "frame took %lu ns.\n", objects, pages, frames,
+         (unsigned long)worst));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, work.w_count == objects);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, pages > 0);
+   RAM_FAIL_TRAP(ram_default_check());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t discard(void *arg_arg)
+{
+   work_t *work = (work_t *)arg_arg;
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(work);
+
+   for (i = 0; i < work->w_count; ++i)
+      RAM_FAIL_TRAP(ram_discard(work->w_ptrs[i]));
+   /* anything still sitting in this thread's outgoing buffers has to be
+    * sent before the thread goes away. */
+   RAM_FAIL_TRAP(ram_flush());
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,195 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <memory.h>
+
+/* this test measures how many page faults and how much time it takes to
+ * acquire objects of a size that was reserved ahead of time, compared with
+ * a size that wasn't. it then checks that the reservation persists as a
+ * floor after the objects are discarded. */
+
+#define DEFAULT_OBJECT_COUNT 8192
+#define WARM_SIZE 64
+#define COLD_SIZE 72
+/* a handful of faults can come from things outside of the allocator's
+ * control, such as the stack, or from the bookkeeping that aligned pools
+ * get from the supplementary allocator. */
+#define FAULT_TOLERANCE 8
+
+typedef struct result
+{
+   uint64_t r_ns;
+   size_t r_faults;
+} result_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t fill(result_t *result_arg, char **ptrs_arg,
+      size_t count_arg, size_t size_arg);
+static ram_reply_t empty(char **ptrs_arg, size_t count_arg);
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   result_t warm = {0}, rewarm = {0}, cold = {0};
+   ram_reservation_t profile[2];
+   char **ptrs = NULL;
+   size_t count = DEFAULT_OBJECT_COUNT;
+   size_t unused = 0;
+   int faultsflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   if (argc > 1)
+   {
+      count = strtoul(argv[1], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, count > 0);
+   }
+
+   /* i touch the pointer array before measuring anything, so that its
+    * faults aren't counted against the allocator. */
+   ptrs = malloc(count * sizeof(*ptrs));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != ptrs);
+   memset(ptrs, 0, count * sizeof(*ptrs));
+
+   e = ramtest_faults(&unused);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_UNSUPPORTED:
+      break;
+   case RAM_REPLY_OK:
+      faultsflag = 1;
+      break;
+   }
+
+   /* sizes that the allocator can't accommodate can't be reserved. */
+   profile[0].ramdr_size = WARM_SIZE;
+   profile[0].ramdr_count = count;
+   profile[1].ramdr_size = (size_t)1 << 20;
+   profile[1].ramdr_count = 1;
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_RANGEFAIL == ram_prewarm(profile, 2));
+
+   RAM_FAIL_TRAP(fill(&warm, ptrs, count, WARM_SIZE));
+   RAM_FAIL_TRAP(empty(ptrs, count));
+   /* the reservation should have been replenished by the discards. */
+   RAM_FAIL_TRAP(fill(&rewarm, ptrs, count, WARM_SIZE));
+   RAM_FAIL_TRAP(empty(ptrs, count));
+   RAM_FAIL_TRAP(fill(&cold, ptrs, count, COLD_SIZE));
+   RAM_FAIL_TRAP(empty(ptrs, count));
+   /* removing the reservation gives the pages back. */
+   RAM_FAIL_TRAP(ram_reserve(WARM_SIZE, 0));
+   RAM_FAIL_TRAP(ram_default_check());
+   free(ptrs);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%zu objects; first-touch latency in ns/object.\n"
+         "size  reserved  latency  faults\n"
+         "%4d  yes       %7lu  %6zu\n"
+         "%4d  again     %7lu  %6zu\n"
+         "%4d  no        %7lu  %6zu\n",
+         count,
+         WARM_SIZE, (unsigned long)warm.r_ns, warm.r_faults,
+         WARM_SIZE, (unsigned long)rewarm.r_ns, rewarm.r_faults,
+         COLD_SIZE, (unsigned long)cold.r_ns, cold.r_faults));
+   if (faultsflag)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, warm.r_faults <= FAULT_TOLERANCE);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, rewarm.r_faults <= FAULT_TOLERANCE);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, cold.r_faults > warm.r_faults);
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t fill(result_t *result_arg, char **ptrs_arg, size_t count_arg,
+      size_t size_arg)
+{
+   uint64_t t0 = 0, t1 = 0;
+   size_t f0 = 0, f1 = 0, i = 0;
+
+   RAM_FAIL_NOTNULL(result_arg);
+   RAM_FAIL_NOTNULL(ptrs_arg);
+   RAM_FAIL_NOTZERO(count_arg);
+
+   /* faults aren't counted on every platform; in that case, both counts
+    * are zero. */
+   (void)ramtest_faults(&f0);
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(ram_acquire((void **)&ptrs_arg[i], size_arg));
+      /* the first touch is what i'm really measuring. */
+      memset(ptrs_arg[i], 0x5a, size_arg);
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   (void)ramtest_faults(&f1);
+
+   result_arg->r_ns = (t1 - t0) / count_arg;
+   result_arg->r_faults = f1 - f0;
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t empty(char **ptrs_arg, size_t count_arg)
+{
+   size_t i = 0;
+
+   RAM_FAIL_NOTNULL(ptrs_arg);
+
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(ram_discard(ptrs_arg[i]));
+      ptrs_arg[i] = NULL;
+   }
+   RAM_FAIL_TRAP(ram_flush());
+
+   return RAM_REPLY_OK;
+}
@@ -0,0 +1,292 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/para.h>
+#include <ramalloc/cpu.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/barrier.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+/* this benchmark compares a parallel pool, which keeps a heap for each
+ * thread, with a per-cpu pool, which keeps a heap for each processor. each
+ * thread holds a small working set of objects of assorted sizes and
+ * replaces them at random. i report how long the threads took and how much
+ * the resident set grew while they were at it. */
+
+#define DEFAULT_THREAD_COUNT 8
+#define WORKING_SET 32
+#define ITERATION_COUNT 2000
+/* objects are 8 to 256 bytes large, so each thread touches 6 size
+ * classes. */
+#define SIZE_CLASSES 6
+#define MINIMUM_SIZE 8
+#define BARRIER_COUNT 4
+
+typedef struct bench
+{
+   int b_cpuflag;
+   rampara_pool_t b_parapool;
+   ramcpu_pool_t b_cpupool;
+   /* the threads meet at the first barrier once they've started and wait
+    * at the second for me to start the clock. they meet at the third when
+    * they're done, so that i can measure what happened in between, and
+    * they leave after the fourth. */
+   rambarrier_barrier_t b_barriers[BARRIER_COUNT];
+} bench_t;
+
+typedef struct work
+{
+   bench_t *w_bench;
+   size_t w_seed;
+} work_t;
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t runbench(bench_t *bench_arg, size_t threadcount_arg);
+static ram_reply_t churn(void *arg_arg);
+static ram_reply_t acquire(void **newptr_arg, bench_t *bench_arg, size_t size_arg);
+static ram_reply_t release(bench_t *bench_arg, void *ptr_arg);
+static ram_reply_t measure(size_t *rss_arg, int *rssflag_arg);
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   static bench_t bench;
+   ramlazy_policy_t policy = {0};
+   size_t threadcount = DEFAULT_THREAD_COUNT, unused = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   /* usage: scaletest [para|cpu] [thread-count] */
+   if (argc > 1)
+   {
+      if (0 == strcmp(argv[1], "cpu"))
+         bench.b_cpuflag = 1;
+      else if (0 != strcmp(argv[1], "para"))
+      {
+         RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
+               "please specify either \"para\" or \"cpu\".\n"));
+         return RAM_REPLY_INPUTFAIL;
+      }
+   }
+   if (argc > 2)
+   {
+      threadcount = strtoul(argv[2], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, threadcount > 0);
+   }
+
+   policy.ramlazyp_mingoal = RAM_WANT_DEFAULTRECLAIMGOAL;
+   policy.ramlazyp_maxgoal = RAM_WANT_DEFAULTRECLAIMLIMIT;
+   if (bench.b_cpuflag)
+   {
+      RAM_FAIL_TRAP(ramcpu_mkpool(&bench.b_cpupool, 0,
+            RAM_WANT_DEFAULTAPPETITE, &policy));
+   }
+   else
+   {
+      RAM_FAIL_TRAP(rampara_mkpool(&bench.b_parapool,
+            RAM_WANT_DEFAULTAPPETITE, &policy));
+   }
+
+   RAM_FAIL_TRAP(runbench(&bench, threadcount));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t runbench(bench_t *bench_arg, size_t threadcount_arg)
+{
+   ramthread_thread_t *threads = NULL;
+   work_t *work = NULL;
+   size_t i = 0, rss0 = 0, rss1 = 0, unused = 0;
+   uint64_t t0 = 0, t1 = 0;
+   int rssflag = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(bench_arg);
+
+   threads = calloc(threadcount_arg, sizeof(*threads));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != threads);
+   work = calloc(threadcount_arg, sizeof(*work));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != work);
+   for (i = 0; i < BARRIER_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(rambarrier_mkbarrier(&bench_arg->b_barriers[i],
+            threadcount_arg + 1));
+   }
+
+   for (i = 0; i < threadcount_arg; ++i)
+   {
+      work[i].w_bench = bench_arg;
+      work[i].w_seed = i + 1;
+      RAM_FAIL_TRAP(ramthread_mkthread(&threads[i], &churn, &work[i]));
+   }
+
+   /* the threads' stacks are already part of the resident set by the time
+    * they reach the first barrier, so they don't count against either
+    * pool. none of them can start work until i reach the second. */
+   RAM_FAIL_TRAP(rambarrier_wait(&bench_arg->b_barriers[0]));
+   RAM_FAIL_TRAP(measure(&rss0, &rssflag));
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   RAM_FAIL_TRAP(rambarrier_wait(&bench_arg->b_barriers[1]));
+   RAM_FAIL_TRAP(rambarrier_wait(&bench_arg->b_barriers[2]));
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   RAM_FAIL_TRAP(measure(&rss1, &rssflag));
+   RAM_FAIL_TRAP(rambarrier_wait(&bench_arg->b_barriers[3]));
+
+   for (i = 0; i < threadcount_arg; ++i)
+   {
+      RAM_FAIL_TRAP(ramthread_join(&e, threads[i]));
+      RAM_FAIL_TRAP(e);
+   }
+   for (i = 0; i < BARRIER_COUNT; ++i)
+      RAM_FAIL_TRAP(rambarrier_rmbarrier(&bench_arg->b_barriers[i]));
+   free(work);
+   free(threads);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%s pool, %zu threads: %lu ms (%lu ns per operation)",
+         bench_arg->b_cpuflag ? "per-cpu" : "parallel", threadcount_arg,
+         (unsigned long)((t1 - t0) / 1000000),
+         (unsigned long)((t1 - t0)
+            / (threadcount_arg * (WORKING_SET + ITERATION_COUNT) * 2))));
+   if (rssflag)
+   {
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "; the resident set grew by %zu KiB.\n",
+            (rss1 > rss0 ? rss1 - rss0 : 0) / 1024));
+   }
+   else
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout, ".\n"));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t churn(void *arg_arg)
+{
+   work_t *work = (work_t *)arg_arg;
+   void *objects[WORKING_SET] = {0};
+   size_t i = 0, j = 0, rng = 0;
+
+   RAM_FAIL_NOTNULL(work);
+   rng = work->w_seed;
+
+   RAM_FAIL_TRAP(rambarrier_wait(&work->w_bench->b_barriers[0]));
+   RAM_FAIL_TRAP(rambarrier_wait(&work->w_bench->b_barriers[1]));
+   /* a linear congruential generator is good enough to pick sizes and
+    * victims, and unlike rand(), it's mine alone. */
+   for (i = 0; i < WORKING_SET + ITERATION_COUNT; ++i)
+   {
+      rng = rng * 1103515245 + 12345;
+      j = i < WORKING_SET ? i : (rng >> 8) % WORKING_SET;
+      if (NULL != objects[j])
+         RAM_FAIL_TRAP(release(work->w_bench, objects[j]));
+      RAM_FAIL_TRAP(acquire(&objects[j], work->w_bench,
+            MINIMUM_SIZE << ((rng >> 16) % SIZE_CLASSES)));
+   }
+   RAM_FAIL_TRAP(rambarrier_wait(&work->w_bench->b_barriers[2]));
+   RAM_FAIL_TRAP(rambarrier_wait(&work->w_bench->b_barriers[3]));
+
+   for (j = 0; j < WORKING_SET; ++j)
+      RAM_FAIL_TRAP(release(work->w_bench, objects[j]));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t acquire(void **newptr_arg, bench_t *bench_arg, size_t size_arg)
+{
+   RAM_FAIL_NOTNULL(bench_arg);
+
+   if (bench_arg->b_cpuflag)
+   {
+      RAM_FAIL_TRAP(ramcpu_acquire(newptr_arg, &bench_arg->b_cpupool,
+            size_arg));
+   }
+   else
+   {
+      RAM_FAIL_TRAP(rampara_acquire(newptr_arg, &bench_arg->b_parapool,
+            size_arg));
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t release(bench_t *bench_arg, void *ptr_arg)
+{
+   RAM_FAIL_NOTNULL(bench_arg);
+
+   if (bench_arg->b_cpuflag)
+      RAM_FAIL_TRAP(ramcpu_release(ptr_arg));
+   else
+      RAM_FAIL_TRAP(rampara_release(ptr_arg));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t measure(size_t *rss_arg, int *rssflag_arg)
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_NOTNULL(rss_arg);
+   RAM_FAIL_NOTNULL(rssflag_arg);
+
+   e = ramtest_rss(rss_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_UNSUPPORTED:
+      *rssflag_arg = 0;
+      break;
+   case RAM_REPLY_OK:
+      *rssflag_arg = 1;
+      break;
+   }
+
+   return RAM_REPLY_OK;
+}
@@ -36,12 +36,20 @@
 #include <ramalloc/thread.h>
 #include <ramalloc/misc.h>
 #include <ramalloc/cast.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/sys.h>
 #include <trio.h>
 #include <string.h>
 #include <stdio.h>
 #include <time.h>
 #include <stdlib.h>
 
+#ifdef RAMSYS_LINUX
+#  include <sys/resource.h>
+#elif defined(RAMSYS_WINDOWS)
+#  include <psapi.h>
+#endif
+
 typedef struct ramtest_allocrec
 {
    ramtest_allocdesc_t ramtestar_desc;
@@ -335,6 +343,32 @@ ram_reply_t ramtest_describe(FILE *out_arg,
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramtest_chksizes(const ramtest_params_t *params_arg)
+{
+   size_t unused = 0;
+
+   RAM_FAIL_NOTNULL(params_arg);
+
+   if (params_arg->ramtestp_minsize < sizeof(void *) ||
+         params_arg->ramtestp_maxsize < sizeof(void *))
+   {
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
+            "you cannot specify a size smaller than %zu bytes.\n",
+            sizeof(void *)));
+      return RAM_REPLY_INPUTFAIL;
+   }
+   if (params_arg->ramtestp_minsize > params_arg->ramtestp_maxsize)
+   {
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr,
+            "please specify a minimum size (%zu bytes) that is smaller than "
+            "or equal to the maximum (%zu bytes).\n",
+            params_arg->ramtestp_minsize, params_arg->ramtestp_maxsize));
+      return RAM_REPLY_INPUTFAIL;
+   }
+
+   return RAM_REPLY_OK;
+}
+
 ram_reply_t ramtest_test(const ramtest_params_t *params_arg)
 {
    ram_reply_t e = RAM_REPLY_INSANE;
@@ -698,6 +732,111 @@ ram_reply_t ramtest_maxthreadcount(size_t *count_arg)
    return RAM_REPLY_OK;
 }
 
+ram_reply_t ramtest_rss(size_t *rss_arg)
+{
+#ifdef RAMSYS_LINUX
+   FILE *f = NULL;
+   unsigned long size = 0, resident = 0;
+   size_t pgsz = 0;
+   int n = 0;
+
+   RAM_FAIL_NOTNULL(rss_arg);
+   *rss_arg = 0;
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   /* the second field of /proc/self/statm is the resident set size, in
+    * pages. */
+   f = fopen("/proc/self/statm", "r");
+   RAM_FAIL_EXPECT(RAM_REPLY_CRTFAIL, NULL != f);
+   n = fscanf(f, "%lu %lu", &size, &resident);
+   fclose(f);
+   RAM_FAIL_EXPECT(RAM_REPLY_CRTFAIL, 2 == n);
+
+   *rss_arg = resident * pgsz;
+   return RAM_REPLY_OK;
+#elif defined(RAMSYS_WINDOWS)
+   PROCESS_MEMORY_COUNTERS counters;
+
+   RAM_FAIL_NOTNULL(rss_arg);
+   *rss_arg = 0;
+
+   /* the working set is the closest thing Windows has to a resident set. */
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, GetProcessMemoryInfo(
+         GetCurrentProcess(), &counters, sizeof(counters)));
+
+   *rss_arg = counters.WorkingSetSize;
+   return RAM_REPLY_OK;
+#else
+   RAM_FAIL_NOTNULL(rss_arg);
+   *rss_arg = 0;
+
+   return RAM_REPLY_UNSUPPORTED;
+#endif
+}
+
+ram_reply_t ramtest_clock(uint64_t *nsec_arg)
+{
+#if defined(RAMSYS_WINDOWS)
+   LARGE_INTEGER freq, count;
+
+   RAM_FAIL_NOTNULL(nsec_arg);
+   *nsec_arg = 0;
+
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, QueryPerformanceFrequency(&freq));
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, QueryPerformanceCounter(&count));
+   *nsec_arg = (uint64_t)((double)count.QuadPart * 1e9 /
+         (double)freq.QuadPart);
+
+   return RAM_REPLY_OK;
+#else
+   struct timespec ts;
+
+   RAM_FAIL_NOTNULL(nsec_arg);
+   *nsec_arg = 0;
+
+   RAM_FAIL_EXPECT(RAM_REPLY_CRTFAIL,
+         0 == clock_gettime(CLOCK_MONOTONIC, &ts));
+   *nsec_arg = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+
+   return RAM_REPLY_OK;
+#endif
+}
+
+ram_reply_t ramtest_faults(size_t *faults_arg)
+{
+#ifdef RAMSYS_LINUX
+   struct rusage usage;
+
+   RAM_FAIL_NOTNULL(faults_arg);
+   *faults_arg = 0;
+
+   /* i count both minor and major faults; either one means that the
+    * process had to enter the kernel. */
+   RAM_FAIL_EXPECT(RAM_REPLY_CRTFAIL, 0 == getrusage(RUSAGE_SELF, &usage));
+   *faults_arg = (size_t)usage.ru_minflt + (size_t)usage.ru_majflt;
+
+   return RAM_REPLY_OK;
+#elif defined(RAMSYS_WINDOWS)
+   PROCESS_MEMORY_COUNTERS counters;
+
+   RAM_FAIL_NOTNULL(faults_arg);
+   *faults_arg = 0;
+
+   /* Windows doesn't tell soft faults apart from hard ones here, which
+    * suits me; i'd count both anyway. */
+   RAM_FAIL_EXPECT(RAM_REPLY_APIFAIL, GetProcessMemoryInfo(
+         GetCurrentProcess(), &counters, sizeof(counters)));
+   *faults_arg = counters.PageFaultCount;
+
+   return RAM_REPLY_OK;
+#else
+   RAM_FAIL_NOTNULL(faults_arg);
+   *faults_arg = 0;
+
+   return RAM_REPLY_UNSUPPORTED;
+#endif
+}
+
 ram_reply_t ramtest_fprintf(size_t *count_arg, FILE *file_arg,
       const char *fmt_arg, ...)
 {
@@ -83,11 +83,19 @@ ram_reply_t ramtest_randint32(int32_t *result_arg, int32_t n0_arg,
 ram_reply_t ramtest_shuffle(void *array_arg, size_t size_arg,
       size_t count_arg);
 
+/* tells the operator what's wrong and replies RAM_REPLY_INPUTFAIL if the
+ * allocation sizes in *params_arg* are smaller than a pointer or if the
+ * minimum exceeds the maximum. */
+ram_reply_t ramtest_chksizes(const ramtest_params_t *params_arg);
 ram_reply_t ramtest_test(const ramtest_params_t *params_arg);
 
 ram_reply_t ramtest_defaultthreadcount(size_t *count_arg);
 ram_reply_t ramtest_maxthreadcount(size_t *count_arg);
 
+ram_reply_t ramtest_rss(size_t *rss_arg);
+ram_reply_t ramtest_clock(uint64_t *nsec_arg);
+ram_reply_t ramtest_faults(size_t *faults_arg);
+
 /*@printflike@*/
 RAMSYS_PRINTFDECL(
       ram_reply_t ramtest_fprintf(size_t *count_arg, FILE *file_arg,
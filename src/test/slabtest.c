@@ -0,0 +1,131 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/algn.h>
+#include <ramalloc/pg.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/annotate.h>
+#include <stdio.h>
+
+/* this test checks the slabs that aligned pools choose for every
+ * granularity up to the largest run against reservations of different
+ * sizes, including ones that aren't a power of two. a reservation's size
+ * is fixed when the library is built, so this is the only way to exercise
+ * the others without rebuilding it. */
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t chkslab(size_t granularity_arg, size_t reservation_arg,
+      size_t pagesize_arg);
+
+/* reservations, in pages, that aren't a power of two are listed alongside
+ * ones that are. */
+static const size_t thereservations[] = {1, 3, 12, 24, 100, 128, 384, 512};
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   size_t i = 0, granularity = 0, pgsz = 0, unused = 0;
+
+   RAMANNOTATE_UNUSEDARG(argc);
+   RAMANNOTATE_UNUSEDARG(argv);
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+
+   for (i = 0; i < sizeof(thereservations) / sizeof(thereservations[0]); ++i)
+   {
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "checking slabs for a reservation of %lu pages...\n",
+            (unsigned long)thereservations[i]));
+      for (granularity = sizeof(void *);
+            granularity <= pgsz * RAMPG_MAXRUNLENGTH;
+            granularity += sizeof(void *))
+      {
+         RAM_FAIL_TRAP(chkslab(granularity, thereservations[i], pgsz));
+      }
+   }
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkslab(size_t granularity_arg, size_t reservation_arg,
+      size_t pagesize_arg)
+{
+   size_t pages = 0, capacity = 0, maxpages = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   /* the longest run that a reservation can hold a whole number of. */
+   for (maxpages = 1; maxpages < RAMPG_MAXRUNLENGTH
+         && 0 == reservation_arg % (maxpages * 2); maxpages *= 2)
+      continue;
+
+   e = ramalgn_calcslab(&pages, &capacity, granularity_arg, reservation_arg);
+   switch (e)
+   {
+   default:
+      RAM_FAIL_TRAP(e);
+      /* i shouldn't ever get here. */
+      return RAM_REPLY_INSANE;
+   case RAM_REPLY_RANGEFAIL:
+      /* a granularity can only be refused if it's too large for the
+       * longest run there is, or if the reservation doesn't stand in the
+       * way of that run. */
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, maxpages == RAMPG_MAXRUNLENGTH ||
+            granularity_arg > pagesize_arg * maxpages);
+      return RAM_REPLY_OK;
+   case RAM_REPLY_OK:
+      break;
+   }
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == (pages & (pages - 1)));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, pages <= maxpages);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == reservation_arg % pages);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, capacity > 0);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         capacity == pagesize_arg * pages / granularity_arg);
+
+   return RAM_REPLY_OK;
+}
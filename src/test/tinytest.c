@@ -0,0 +1,333 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/annotate.h>
+#include <ramalloc/mem.h>
+#include <ramalloc/thread.h>
+#include <ramalloc/tiny.h>
+#include <ramalloc/want.h>
+#include <ramalloc/stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* this test exercises the tiny object tier: acquisition, query and
+ * discard of cells, reuse of discarded cells, discards from a thread that
+ * doesn't own the cell and adoption of an exiting thread's heap. it also
+ * reports how much memory cells save over the smallest size class. */
+
+#define CELL_COUNT 100000
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t chkcapacity(size_t slotsize_arg);
+static ram_reply_t chkcells(size_t slotsize_arg);
+static ram_reply_t chkreuse();
+static ram_reply_t chkremote();
+static ram_reply_t chkorphan();
+static ram_reply_t chkdefault();
+static ram_reply_t discardall(void *arg_arg);
+static ram_reply_t leave(void *arg_arg);
+static ram_reply_t adopt(void *arg_arg);
+
+static void *thecells[CELL_COUNT];
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   void *p = NULL;
+   size_t slotsz = 0;
+
+   RAMANNOTATE_UNUSEDARG(argc);
+   RAMANNOTATE_UNUSEDARG(argv);
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   /* the smallest object the size classes hold is the yardstick. */
+   RAM_FAIL_TRAP(ram_acquire(&p, RAMTINY_MAXCELLSIZE + 1));
+   RAM_FAIL_TRAP(ram_query(&slotsz, p));
+   RAM_FAIL_TRAP(ram_discard(p));
+
+   RAM_FAIL_TRAP(chkcapacity(slotsz));
+   RAM_FAIL_TRAP(chkcells(slotsz));
+   RAM_FAIL_TRAP(chkreuse());
+   RAM_FAIL_TRAP(chkremote());
+   RAM_FAIL_TRAP(chkorphan());
+   RAM_FAIL_TRAP(chkdefault());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkcapacity(size_t slotsize_arg)
+{
+   size_t pgsz = 0, cells = 0, size = 0, unused = 0;
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   for (size = 1; size <= RAMTINY_MAXCELLSIZE; size *= 2)
+   {
+      RAM_FAIL_TRAP(ramtiny_getcapacity(&cells, size));
+      /* the bitmaps can't cost more than a quarter of each cell. */
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, cells * size <= pgsz);
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            cells * (size * 8 + 2) >= (pgsz - 128) * 8);
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "%zu byte cells: %zu per page, %.1fx the %zu byte slots.\n",
+            size, cells, (double)cells / (double)(pgsz / slotsize_arg),
+            slotsize_arg));
+   }
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, RAM_REPLY_RANGEFAIL ==
+         ramtiny_getcapacity(&cells, RAMTINY_MAXCELLSIZE + 1));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkcells(size_t slotsize_arg)
+{
+   ramtiny_stats_t before = {0}, after = {0};
+   size_t i = 0, sz = 0, pgsz = 0, used = 0, unused = 0;
+
+   RAM_FAIL_TRAP(rammem_pagesize(&pgsz));
+   RAM_FAIL_TRAP(ramtiny_getstats(&before));
+
+   for (i = 0; i < CELL_COUNT; ++i)
+   {
+      RAM_FAIL_TRAP(ramtiny_acquire(&thecells[i], 2));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == ((uintptr_t)thecells[i] & 1));
+      RAM_FAIL_TRAP(ramtiny_query(&sz, thecells[i]));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 2 == sz);
+      *(uint16_t *)thecells[i] = (uint16_t)i;
+   }
+   /* if two cells overlapped, one of them would have been overwritten. */
+   for (i = 0; i < CELL_COUNT; ++i)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT,
+            (uint16_t)i == *(uint16_t *)thecells[i]);
+   }
+   RAM_FAIL_TRAP(ramtiny_chkheap());
+
+   RAM_FAIL_TRAP(ramtiny_getstats(&after));
+   used = after.ramtinys_pages - before.ramtinys_pages;
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "%d 2 byte cells: %zu KiB in cells, %zu KiB in %zu byte slots.\n",
+         CELL_COUNT, used * pgsz >> 10,
+         ((size_t)CELL_COUNT * slotsize_arg) >> 10, slotsize_arg));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         used * pgsz < (size_t)CELL_COUNT * slotsize_arg);
+
+   for (i = 0; i < CELL_COUNT; ++i)
+      RAM_FAIL_TRAP(ramtiny_release(thecells[i]));
+   RAM_FAIL_TRAP(ramtiny_flush());
+   RAM_FAIL_TRAP(ramtiny_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramtinys_pages <= before.ramtinys_pages);
+
+   /* the header of a page isn't a cell. */
+   RAM_FAIL_TRAP(ramtiny_acquire(&thecells[0], 1));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, RAM_REPLY_NOTFOUND == ramtiny_query(&sz,
+         (void *)((uintptr_t)thecells[0] & ~(uintptr_t)(pgsz - 1))));
+   RAM_FAIL_TRAP(ramtiny_release(thecells[0]));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_RANGEFAIL == ramtiny_acquire(&thecells[0], 5));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkreuse()
+{
+   ramtiny_stats_t before = {0}, after = {0};
+   void *p = NULL;
+   size_t i = 0;
+
+   RAM_FAIL_TRAP(ramtiny_getstats(&before));
+   for (i = 0; i < CELL_COUNT / 10; ++i)
+      RAM_FAIL_TRAP(ramtiny_acquire(&thecells[i], 4));
+   /* the lowest free cell is always taken first, so a discarded cell is
+    * the next one handed out. */
+   p = thecells[CELL_COUNT / 20];
+   RAM_FAIL_TRAP(ramtiny_release(p));
+   RAM_FAIL_TRAP(ramtiny_acquire(&thecells[CELL_COUNT / 20], 3));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, p == thecells[CELL_COUNT / 20]);
+   RAM_FAIL_TRAP(ramtiny_chkheap());
+
+   for (i = 0; i < CELL_COUNT / 10; ++i)
+      RAM_FAIL_TRAP(ramtiny_release(thecells[i]));
+   RAM_FAIL_TRAP(ramtiny_flush());
+   RAM_FAIL_TRAP(ramtiny_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramtinys_pages <= before.ramtinys_pages);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkremote()
+{
+   ramthread_thread_t thread;
+   ramtiny_stats_t before = {0}, after = {0};
+   size_t i = 0;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ramtiny_flush());
+   RAM_FAIL_TRAP(ramtiny_getstats(&before));
+   for (i = 0; i < CELL_COUNT; ++i)
+      RAM_FAIL_TRAP(ramtiny_acquire(&thecells[i], 1));
+
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, &discardall, NULL));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+
+   /* the cells come home when the owner merges them. */
+   RAM_FAIL_TRAP(ramtiny_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramtinys_remote == before.ramtinys_remote + CELL_COUNT);
+   RAM_FAIL_TRAP(ramtiny_flush());
+   RAM_FAIL_TRAP(ramtiny_chkheap());
+   RAM_FAIL_TRAP(ramtiny_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramtinys_pages <= before.ramtinys_pages);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t discardall(void *arg_arg)
+{
+   size_t i = 0;
+
+   RAMANNOTATE_UNUSEDARG(arg_arg);
+
+   /* i discard in reverse, so the owner can't be helped along by the
+    * order in which the pages were queued. */
+   for (i = CELL_COUNT; i > 0; --i)
+      RAM_FAIL_TRAP(ramtiny_release(thecells[i - 1]));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkorphan()
+{
+   ramthread_thread_t thread;
+   ramtiny_stats_t before = {0}, after = {0};
+   void *p = NULL;
+   ram_reply_t e = RAM_REPLY_INSANE;
+
+   RAM_FAIL_TRAP(ramtiny_getstats(&before));
+
+   /* the first thread leaves a cell behind... */
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, &leave, &p));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, NULL != p);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0x5a == *(unsigned char *)p);
+   RAM_FAIL_TRAP(ramtiny_release(p));
+
+   /* ...and the second one adopts its heap, along with the discard. */
+   RAM_FAIL_TRAP(ramthread_mkthread(&thread, &adopt, NULL));
+   RAM_FAIL_TRAP(ramthread_join(&e, thread));
+   RAM_FAIL_TRAP(e);
+
+   RAM_FAIL_TRAP(ramtiny_getstats(&after));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramtinys_adoptions == before.ramtinys_adoptions + 1);
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         after.ramtinys_pages == before.ramtinys_pages);
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t leave(void *arg_arg)
+{
+   RAM_FAIL_NOTNULL(arg_arg);
+
+   RAM_FAIL_TRAP(ramtiny_acquire((void **)arg_arg, 1));
+   *(unsigned char *)*(void **)arg_arg = 0x5a;
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t adopt(void *arg_arg)
+{
+   void *p = NULL;
+
+   RAMANNOTATE_UNUSEDARG(arg_arg);
+
+   RAM_FAIL_TRAP(ramtiny_acquire(&p, 1));
+   RAM_FAIL_TRAP(ramtiny_release(p));
+   RAM_FAIL_TRAP(ramtiny_chkheap());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkdefault()
+{
+   static const size_t sizes[] = {1, 2, 3, 4, RAMTINY_MAXCELLSIZE + 1};
+   void *p = NULL;
+   size_t i = 0, sz = 0, tsz = 0;
+
+   for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+   {
+      RAM_FAIL_TRAP(ram_acquire(&p, sizes[i]));
+      RAM_FAIL_TRAP(ram_query(&sz, p));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz >= sizes[i]);
+#if RAM_WANT_TINYCELLS
+      /* small requests are routed to the tiny tier. */
+      if (sizes[i] <= RAMTINY_MAXCELLSIZE)
+      {
+         RAM_FAIL_TRAP(ramtiny_query(&tsz, p));
+         RAM_FAIL_EXPECT(RAM_REPLY_INSANE, sz == tsz && sz < 2 * sizes[i]);
+      }
+      else
+#endif
+      {
+         RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+               RAM_REPLY_NOTFOUND == ramtiny_query(&tsz, p));
+      }
+      memset(p, 0xa5, sizes[i]);
+      /* a cell can grow out of the tier. */
+      RAM_FAIL_TRAP(ram_resize(&p, p, 100));
+      RAM_FAIL_EXPECT(RAM_REPLY_CORRUPT, 0xa5 == *(unsigned char *)p);
+      RAM_FAIL_TRAP(ram_discard(p));
+   }
+   RAM_FAIL_TRAP(ram_default_check());
+
+   return RAM_REPLY_OK;
+}
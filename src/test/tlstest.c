@@ -0,0 +1,186 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/tls.h>
+#include <ramalloc/want.h>
+#include <ramalloc/stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this microbenchmark measures what it costs a thread to find its own
+ * pool. it times a lookup through a threading library key against a load
+ * from a thread-local variable and then times the acquire and discard
+ * pair that pays for one of them every time it's called. */
+
+#define DEFAULT_ITERATION_COUNT 4000000
+#define OBJECT_SIZE 16
+
+static ram_reply_t main2(int argc, char *argv[]);
+static ram_reply_t bykey(uint64_t *elapsed_arg, size_t count_arg);
+#ifdef RAMSYS_THREADLOCAL
+static ram_reply_t bystorageclass(uint64_t *elapsed_arg, size_t count_arg);
+#endif
+static ram_reply_t bypair(uint64_t *elapsed_arg, size_t count_arg);
+
+#ifdef RAMSYS_THREADLOCAL
+static RAMSYS_THREADLOCAL void * volatile thetls = NULL;
+#endif
+
+int main(int argc, char *argv[])
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2(argc, argv);
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2(int argc, char *argv[])
+{
+   size_t count = DEFAULT_ITERATION_COUNT, unused = 0;
+   uint64_t elapsed = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   if (argc > 1)
+   {
+      count = strtoul(argv[1], NULL, 10);
+      RAM_FAIL_EXPECT(RAM_REPLY_INPUTFAIL, count > 0);
+   }
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "the compiler's thread-local storage is %s.\n",
+         RAM_WANT_COMPILERTLS ? "enabled" : "disabled"));
+
+   RAM_FAIL_TRAP(bykey(&elapsed, count));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "lookup through a key: %lu ps per call.\n",
+         (unsigned long)(elapsed * 1000 / count)));
+#ifdef RAMSYS_THREADLOCAL
+   RAM_FAIL_TRAP(bystorageclass(&elapsed, count));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "lookup through a thread-local variable: %lu ps per call.\n",
+         (unsigned long)(elapsed * 1000 / count)));
+#endif
+   RAM_FAIL_TRAP(bypair(&elapsed, count));
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "ram_acquire() and ram_discard(): %lu ps per pair.\n",
+         (unsigned long)(elapsed * 1000 / count)));
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t bykey(uint64_t *elapsed_arg, size_t count_arg)
+{
+   ramtls_key_t key;
+   void *p = NULL;
+   size_t i = 0, misses = 0;
+   uint64_t t0 = 0, t1 = 0;
+
+   RAM_FAIL_NOTNULL(elapsed_arg);
+   *elapsed_arg = 0;
+
+   RAM_FAIL_TRAP(ramtls_mkkey(&key, NULL));
+   RAM_FAIL_TRAP(ramtls_sto(key, &key));
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(ramtls_rcl(&p, key));
+      if (&key != p)
+         ++misses;
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   RAM_FAIL_TRAP(ramtls_rmkey(key));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == misses);
+
+   *elapsed_arg = t1 - t0;
+   return RAM_REPLY_OK;
+}
+
+#ifdef RAMSYS_THREADLOCAL
+ram_reply_t bystorageclass(uint64_t *elapsed_arg, size_t count_arg)
+{
+   size_t i = 0, misses = 0;
+   uint64_t t0 = 0, t1 = 0;
+
+   RAM_FAIL_NOTNULL(elapsed_arg);
+   *elapsed_arg = 0;
+
+   /* the variable is volatile so that the load can't be hoisted out of
+    * the loop. */
+   thetls = &misses;
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      if (&misses != thetls)
+         ++misses;
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE, 0 == misses);
+
+   *elapsed_arg = t1 - t0;
+   return RAM_REPLY_OK;
+}
+#endif
+
+ram_reply_t bypair(uint64_t *elapsed_arg, size_t count_arg)
+{
+   void *anchor = NULL, *p = NULL;
+   size_t i = 0;
+   uint64_t t0 = 0, t1 = 0;
+
+   RAM_FAIL_NOTNULL(elapsed_arg);
+   *elapsed_arg = 0;
+
+   /* the first acquisition makes the thread's pool, so i leave it out of
+    * the measurement. i hold on to it so that the page it's on never
+    * empties; otherwise, i'd be measuring the cost of committing and
+    * decommitting a page instead. */
+   RAM_FAIL_TRAP(ram_acquire(&anchor, OBJECT_SIZE));
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < count_arg; ++i)
+   {
+      RAM_FAIL_TRAP(ram_acquire(&p, OBJECT_SIZE));
+      RAM_FAIL_TRAP(ram_discard(p));
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   RAM_FAIL_TRAP(ram_discard(anchor));
+
+   *elapsed_arg = t1 - t0;
+   return RAM_REPLY_OK;
+}
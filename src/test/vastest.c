@@ -0,0 +1,131 @@
+/* ex: set softtabstop=3 shiftwidth=3 expandtab: */
+
+/* This file is part of the *ramalloc* project at <http://fmrl.org>.
+ * Copyright (c) 2011, Michael Lowell Roberts.
+ * All rights reserved. 
+ *
+ * Redistribution and use in source and binary forms, with or without 
+ * modification, are permitted provided that the following conditions are 
+ * met: 
+ *
+ *  * Redistributions of source code must retain the above copyright 
+ *  notice, this list of conditions and the following disclaimer. 
+ *
+ *  * Redistributions in binary form must reproduce the above copyright 
+ *  notice, this list of conditions and the following disclaimer in the 
+ *  documentation and/or other materials provided with the distribution.
+ * 
+ *  * Neither the name of the copyright holder nor the names of 
+ *  contributors may be used to endorse or promote products derived 
+ *  from this software without specific prior written permission. 
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS 
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED 
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A 
+ * PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER 
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED 
+ * TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR 
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF 
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING 
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS 
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+#include "shared/test.h"
+#include <ramalloc/ramalloc.h>
+#include <ramalloc/vas.h>
+#include <ramalloc/mux.h>
+#include <ramalloc/want.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* this test makes sure that objects are attributed to the partition of
+ * their size class and that foreign addresses are turned away without
+ * being read. */
+
+#define SIZE_COUNT 16
+#define QUERY_COUNT 1000000
+
+static ram_reply_t main2();
+static ram_reply_t chkpartitions();
+static ram_reply_t chkforeign();
+
+int main()
+{
+   ram_reply_t e = RAM_REPLY_INSANE;
+   size_t unused = 0;
+
+   e = main2();
+   if (RAM_REPLY_OK != e)
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stderr, "fail (%d).", e));
+
+   return e;
+}
+
+ram_reply_t main2()
+{
+   size_t unused = 0;
+
+   RAM_FAIL_TRAP(ram_initialize(NULL, NULL));
+
+   if (!RAM_WANT_PARTITIONED)
+   {
+      RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+            "address space partitioning is disabled; nothing to test.\n"));
+      return RAM_REPLY_OK;
+   }
+
+   RAM_FAIL_TRAP(chkpartitions());
+   RAM_FAIL_TRAP(chkforeign());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkpartitions()
+{
+   void *ptrs[SIZE_COUNT] = {0};
+   size_t i = 0, sz = 0, partition = 0, cls = 0, clssz = 0;
+
+   for (i = 0; i < SIZE_COUNT; ++i)
+      RAM_FAIL_TRAP(ram_acquire(&ptrs[i], (i + 1) * sizeof(void *)));
+   for (i = 0; i < SIZE_COUNT; ++i)
+   {
+      /* each size class has a partition of its own. */
+      RAM_FAIL_TRAP(rammux_getclass(&cls, &clssz, (i + 1) * sizeof(void *)));
+      RAM_FAIL_TRAP(ramvas_locate(&partition, ptrs[i]));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, cls == partition);
+      RAM_FAIL_TRAP(ram_query(&sz, ptrs[i]));
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE, clssz == sz);
+   }
+   for (i = 0; i < SIZE_COUNT; ++i)
+      RAM_FAIL_TRAP(ram_discard(ptrs[i]));
+   RAM_FAIL_TRAP(ram_flush());
+
+   return RAM_REPLY_OK;
+}
+
+ram_reply_t chkforeign()
+{
+   char *foreign = NULL;
+   size_t i = 0, sz = 0, partition = 0, unused = 0;
+   uint64_t t0 = 0, t1 = 0;
+
+   foreign = malloc(sizeof(void *));
+   RAM_FAIL_EXPECT(RAM_REPLY_RESOURCEFAIL, NULL != foreign);
+
+   RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+         RAM_REPLY_NOTFOUND == ramvas_locate(&partition, foreign));
+   RAM_FAIL_TRAP(ramtest_clock(&t0));
+   for (i = 0; i < QUERY_COUNT; ++i)
+   {
+      RAM_FAIL_EXPECT(RAM_REPLY_INSANE,
+            RAM_REPLY_NOTFOUND == ram_query(&sz, foreign));
+   }
+   RAM_FAIL_TRAP(ramtest_clock(&t1));
+   free(foreign);
+
+   RAM_FAIL_TRAP(ramtest_fprintf(&unused, stdout,
+         "a foreign query takes %lu ns.\n",
+         (unsigned long)((t1 - t0) * 1000 / QUERY_COUNT) / 1000));
+
+   return RAM_REPLY_OK;
+}